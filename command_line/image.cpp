@@ -27,31 +27,40 @@
 #include "program/settings.h"
 
 #include "layout/graphlayout.h"
-#include "layout/graphlayoutworker.h"
+#include "layout/layoutcache.h"
 
-#include "ui/bandagegraphicsscene.h"
-#include "ui/bandagegraphicsview.h"
+#include "ui/graphrenderer.h"
 
+#include <memory>
 #include <vector>
 #include <QPainter>
 #include <QSvgGenerator>
 
 #include <CLI/CLI.hpp>
 
+// QPainter could not draw into larger images, tiled rendering streams the
+// image instead
+static constexpr unsigned MAX_IMAGE_SIZE = 32767;
+static constexpr unsigned MAX_TILED_IMAGE_SIZE = 1 << 20;
+
 CLI::App *addImageSubcommand(CLI::App &app, ImageCmd &cmd) {
     auto *image = app.add_subcommand("image", "Generate an image file of a graph");
     image->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage")
             ->required()->check(CLI::ExistingFile);
-    image->add_option("<output_file>", cmd.m_image, "The image file to be created (must end in '.jpg', '.png' or '.svg')")
+    image->add_option("<output_file>", cmd.m_image, "The image file to be created (must end in '.jpg', '.png', '.svg' or '.dzi')")
             ->required();
     image->add_option("--height", cmd.m_height, "Image height")
-            ->default_val(cmd.m_height)->check(CLI::Range(1, 32767));
+            ->default_val(cmd.m_height)->check(CLI::Range(1u, MAX_TILED_IMAGE_SIZE));
     image->add_option("--width", cmd.m_width, "Image width")
-            ->check(CLI::Range(1, 32767));
+            ->check(CLI::Range(1u, MAX_TILED_IMAGE_SIZE));
     image->add_option("--color", cmd.m_color, "csv file with 2 columns: first the node name second the node color")
             ->check(CLI::ExistingFile);
+    image->add_flag("--tiled", cmd.m_tiled, "Render the PNG image in tiles on several threads (see --threads), allows images larger than 32767 pixels");
+    image->add_option("--tilesize", cmd.m_tileSize, "Tile size for the tiled rendering")
+            ->default_val(cmd.m_tileSize)->check(CLI::Range(64, 8192));
 
-    image->footer("If only height or width is set, the other will be determined automatically. If both are set, the image will be exactly that size");
+    image->footer("If only height or width is set, the other will be determined automatically. If both are set, the image will be exactly that size. "
+                  "A '.dzi' output file is a DeepZoom tile pyramid, its tiles are written into the '<name>_files' directory");
 
     return image;
 }
@@ -60,6 +69,8 @@ int handleImageCmd(QApplication *app,
                    const CLI::App &cli, const ImageCmd &cmd) {
     auto imageFileExtension = cmd.m_image.extension();
     bool pixelImage;
+    bool deepZoom = imageFileExtension == ".dzi";
+    bool tiled = cmd.m_tiled || deepZoom;
 
     QTextStream out(stdout);
     QTextStream err(stderr);
@@ -67,8 +78,15 @@ int handleImageCmd(QApplication *app,
         pixelImage = true;
     else if (imageFileExtension == ".svg")
         pixelImage = false;
+    else if (deepZoom)
+        pixelImage = true;
     else {
-        outputText("Bandage-NG error: the output filename must end in .png, .jpg or .svg", &err);
+        outputText("Bandage-NG error: the output filename must end in .png, .jpg, .svg or .dzi", &err);
+        return 1;
+    }
+
+    if (tiled && imageFileExtension != ".png" && !deepZoom) {
+        outputText("Bandage-NG error: tiled rendering needs the output filename to end in .png or .dzi", &err);
         return 1;
     }
 
@@ -140,17 +158,17 @@ int handleImageCmd(QApplication *app,
 
 
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
-    BandageGraphicsScene scene;
+    std::unique_ptr<GraphRenderer> renderer;
     {
         GraphLayoutStorage layout =
-                GraphLayoutWorker(g_settings->graphLayoutQuality,
-                                  g_settings->linearLayout,
-                                  g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
-
-        scene.addGraphicsItemsToScene(*g_assemblyGraph, layout);
-        scene.setSceneRectangle();
+                layout::cache::layoutGraph(*g_assemblyGraph,
+                                           g_settings->graphLayoutQuality,
+                                           g_settings->linearLayout,
+                                           g_settings->componentSeparation);
+        renderer = std::make_unique<GraphRenderer>(*g_assemblyGraph, layout);
     }
-    double sceneRectAspectRatio = scene.sceneRect().width() / scene.sceneRect().height();
+    QRectF sceneRect = renderer->sceneRect();
+    double sceneRectAspectRatio = sceneRect.width() / sceneRect.height();
 
     // Determine image size
     // If neither height nor width set, use a default of height = 1000.
@@ -164,15 +182,27 @@ int handleImageCmd(QApplication *app,
     else if (height == 0 && width > 0)
         height = width / sceneRectAspectRatio;
 
+    unsigned maxImageSize = tiled ? MAX_TILED_IMAGE_SIZE : MAX_IMAGE_SIZE;
+    if (pixelImage && (width > maxImageSize || height > maxImageSize)) {
+        outputText(QString("Bandage-NG error: the image could not be larger than %1 pixels (%2 with --tiled)")
+                           .arg(MAX_IMAGE_SIZE).arg(MAX_TILED_IMAGE_SIZE), &err);
+        return 1;
+    }
+
     bool success = true;
     QPainter painter;
-    if (pixelImage) {
+    if (tiled) {
+        QSize imageSize(int(width), int(height));
+        success = deepZoom
+                  ? renderer->saveDeepZoom(cmd.m_image.c_str(), imageSize, int(cmd.m_tileSize), g_settings->threads)
+                  : renderer->savePNG(cmd.m_image.c_str(), imageSize, int(cmd.m_tileSize), g_settings->threads);
+    } else if (pixelImage) {
         QImage image(width, height, QImage::Format_ARGB32);
         image.fill(Qt::white);
         painter.begin(&image);
         painter.setRenderHint(QPainter::Antialiasing);
         painter.setRenderHint(QPainter::TextAntialiasing);
-        scene.render(&painter);
+        renderer->render(painter, image.size());
         success = image.save(cmd.m_image.c_str());
         painter.end();
     } else { //SVG
@@ -184,7 +214,7 @@ int handleImageCmd(QApplication *app,
         painter.fillRect(0, 0, width, height, Qt::white);
         painter.setRenderHint(QPainter::Antialiasing);
         painter.setRenderHint(QPainter::TextAntialiasing);
-        scene.render(&painter);
+        renderer->render(painter, QSize(width, height));
         painter.end();
     }
 
@@ -30,6 +30,8 @@ struct ImageCmd {
     unsigned m_height = 1000;
     unsigned m_width = 0;
     std::filesystem::path m_color;
+    bool m_tiled = false;
+    unsigned m_tileSize = 1024;
 };
 
 CLI::App *addImageSubcommand(CLI::App &app, ImageCmd &cmd);
@@ -19,6 +19,7 @@
 
 #include "commoncommandlinefunctions.h"
 #include "graph/assemblygraph.h"
+#include "graph/graphstatistics.h"
 #include "program/settings.h"
 
 #include <CLI/CLI.hpp>
@@ -28,6 +29,7 @@ CLI::App *addInfoSubcommand(CLI::App &app, InfoCmd &cmd) {
     info->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage")
             ->required()->check(CLI::ExistingFile);
     info->add_flag("--tsv", cmd.m_tsv, "Output the information in a single tab-delimited line starting with the graph file");
+    info->add_flag("--memory", cmd.m_memory, "Also report the memory used to store the graph");
 
     info->footer(
         "Bandage info takes a graph file as input and outputs (to stdout) the following statistics about the graph:\n"
@@ -64,31 +66,29 @@ int handleInfoCmd(QApplication *app,
         return 1;
     }
 
-    int nodeCount = g_assemblyGraph->m_nodeCount;
-    int edgeCount = g_assemblyGraph->m_edgeCount;
-    QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-    int smallestOverlap = overlapRange.first;
-    int largestOverlap = overlapRange.second;
-    int totalLength = g_assemblyGraph->m_totalLength;
-    int totalLengthNoOverlaps = g_assemblyGraph->getTotalLengthMinusEdgeOverlaps();
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
-
-    double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
+    graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph, g_settings->threads);
+    int nodeCount = stats.nodeCount;
+    int edgeCount = stats.edgeCount;
+    int smallestOverlap = stats.smallestOverlap;
+    int largestOverlap = stats.largestOverlap;
+    long long totalLength = stats.totalLength;
+    long long totalLengthNoOverlaps = stats.totalLengthNoOverlaps;
+    unsigned deadEnds = stats.deadEnds;
+    double percentageDeadEnds = stats.percentageDeadEnds;
+
+    int n50 = stats.n50;
+    int shortestNode = stats.shortestNode;
+    int firstQuartile = stats.firstQuartile;
+    int median = stats.median;
+    int thirdQuartile = stats.thirdQuartile;
+    int longestNode = stats.longestNode;
+
+    int componentCount = stats.componentCount;
+    long long largestComponentLength = stats.largestComponentLength;
+    long long totalLengthOrphanedNodes = stats.totalLengthOrphanedNodes;
+
+    double medianDepthByBase = stats.medianDepthByBase;
+    long long estimatedSequenceLength = stats.estimatedSequenceLength;
 
     if (cmd.m_tsv) {
         out << cmd.m_graph.c_str() << "\t"
@@ -133,5 +133,17 @@ int handleInfoCmd(QApplication *app,
             << "Estimated sequence length (bp):   " << estimatedSequenceLength << "\n";
     }
 
+    if (cmd.m_memory) {
+        auto memory = g_assemblyGraph->getMemoryUsage();
+        double bytesPerNode = memory.nodeCount ? double(memory.totalBytes()) / double(memory.nodeCount) : 0.0;
+        out << "Node storage (bytes):             " << memory.nodeBytes << "\n"
+            << "Edge storage (bytes):             " << memory.edgeBytes << "\n"
+            << "Node names (bytes):               " << memory.nameBytes << "\n"
+            << "Sequences (bytes):                " << memory.sequenceBytes << "\n"
+            << "Edge index (bytes):               " << memory.edgeIndexBytes << "\n"
+            << "Total graph memory (bytes):       " << memory.totalBytes() << "\n"
+            << "Bytes per node:                   " << bytesPerNode << "\n";
+    }
+
     return 0;
 }
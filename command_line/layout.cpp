@@ -27,8 +27,8 @@
 #include "program/settings.h"
 
 #include "layout/graphlayout.h"
-#include "layout/graphlayoutworker.h"
 #include "layout/io.h"
+#include "layout/layoutcache.h"
 
 #include <vector>
 
@@ -38,7 +38,7 @@ CLI::App *addLayoutSubcommand(CLI::App &app, LayoutCmd &cmd) {
     auto *layout = app.add_subcommand("layout", "Layout the graph");
     layout->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage")
             ->required()->check(CLI::ExistingFile);
-    layout->add_option("<layout>", cmd.m_layout, "The layout file to be created (must end with .tsv or .layout)")
+    layout->add_option("<layout>", cmd.m_layout, "The layout file to be created (must end with .tsv, .layout or .blayout)")
             ->required();
 
     return layout;
@@ -47,16 +47,16 @@ CLI::App *addLayoutSubcommand(CLI::App &app, LayoutCmd &cmd) {
 int handleLayoutCmd(QApplication *app,
                    const CLI::App &cli, const LayoutCmd &cmd) {
     auto layoutFileExtension = cmd.m_layout.extension();
-    bool isTSV;
+    bool isTSV = false, isBinary = false;
 
     QTextStream out(stdout);
     QTextStream err(stderr);
     if (layoutFileExtension == ".tsv")
         isTSV = true;
-    else if (layoutFileExtension == ".layout")
-        isTSV = false;
-    else {
-        outputText("Bandage-NG error: the output filename must end in .tsv or .layout", &err);
+    else if (layoutFileExtension == ".blayout")
+        isBinary = true;
+    else if (layoutFileExtension != ".layout") {
+        outputText("Bandage-NG error: the output filename must end in .tsv, .layout or .blayout", &err);
         return 1;
     }
 
@@ -99,12 +99,13 @@ int handleLayoutCmd(QApplication *app,
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
 
     GraphLayoutStorage layout =
-            GraphLayoutWorker(g_settings->graphLayoutQuality,
-                              g_settings->linearLayout,
-                              g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+            layout::cache::layoutGraph(*g_assemblyGraph,
+                                       g_settings->graphLayoutQuality,
+                                       g_settings->linearLayout,
+                                       g_settings->componentSeparation);
 
-    bool success = (isTSV ?
-                    layout::io::saveTSV(cmd.m_layout.c_str(), layout) :
+    bool success = (isTSV ? layout::io::saveTSV(cmd.m_layout.c_str(), layout) :
+                    isBinary ? layout::io::saveBinary(cmd.m_layout.c_str(), layout) :
                     layout::io::save(cmd.m_layout.c_str(), layout));
     
     if (!success) {
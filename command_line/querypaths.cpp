@@ -155,8 +155,9 @@ int handleQueryPathsCmd(QApplication *app,
     auto maybeNA = [](auto val) -> QString {
         using ValT = decltype(val);
         if constexpr (std::is_same_v<ValT, double>) {
-            if (std::isnan(val))
-            return "N/A";
+            if (std::isnan(val) || val < 0)
+                return "N/A";
+            return QString::number(val);
         } else if constexpr (std::is_same_v<ValT, SciNot>) {
             if (std::isnan(val.toDouble()))
                 return "N/A";
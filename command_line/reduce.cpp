@@ -33,8 +33,10 @@ CLI::App *addReduceSubcommand(CLI::App &app, ReduceCmd &cmd) {
     auto *reduce = app.add_subcommand("reduce", "Save a subgraph of a larger graph");
     reduce->add_option("<inputgraph>", cmd.m_graph, "A graph file of any type supported by Bandage")
             ->required()->check(CLI::ExistingFile);
-    reduce->add_option("<outputgraph>", cmd.m_out, "The filename for the GFA graph to be made (if it does not end in '.gfa', that extension will be added)")
+    reduce->add_option("<outputgraph>", cmd.m_out, "The filename for the GFA graph to be made (if it does not end in '.gfa' or '.gfa.gz', '.gfa' will be added). "
+                       "Graphs with the '.gz' extension are gzip-compressed")
             ->required();
+    reduce->add_flag("--bgzf", cmd.m_bgzf, "Compress the output graph with blocked gzip (BGZF) using all threads, '.gz' will be added if missing");
 
     reduce->footer("Bandage reduce takes an input graph and saves a reduced subgraph using the graph scope settings. The saved graph will be in GFA format.\n"
                    "If a graph scope is not specified, then the 'entire' scope will be used, in which case this will simply convert the input graph to GFA format.");
@@ -48,8 +50,10 @@ int handleReduceCmd(QApplication *app,
     QTextStream err(stderr);
 
     QString outputFilename = cmd.m_out.c_str();
-    if (!outputFilename.endsWith(".gfa"))
+    if (!outputFilename.endsWith(".gfa") && !outputFilename.endsWith(".gfa.gz"))
         outputFilename += ".gfa";
+    if (cmd.m_bgzf && !outputFilename.endsWith(".gz"))
+        outputFilename += ".gz";
 
     if (!g_assemblyGraph->loadGraphFromFile(cmd.m_graph.c_str())) {
         outputText(("Bandage-NG error: could not load " + cmd.m_graph.native()).c_str(), &err);
@@ -88,7 +92,8 @@ int handleReduceCmd(QApplication *app,
 
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
 
-    if (!gfa::saveVisibleGraph(outputFilename, *g_assemblyGraph)) {
+    if (!gfa::saveVisibleGraph(outputFilename, *g_assemblyGraph,
+                               cmd.m_bgzf ? io::Compression::Bgzf : io::Compression::Auto)) {
         err << "Bandage was unable to save the graph file." << Qt::endl;
         return 1;
     }
@@ -25,6 +25,7 @@ namespace CLI {
 struct ReduceCmd {
     std::filesystem::path m_graph;
     std::filesystem::path m_out;
+    bool m_bgzf = false;
 };
 
 CLI::App *addReduceSubcommand(CLI::App &app,
@@ -277,6 +277,13 @@ static CLI::App *addGraphLayoutSettings(CLI::App &app) {
     auto *layout = app.add_option_group("Graph layout");
     add_setting(*layout, "--nodseglen", g_settings->nodeSegmentLength, "Node segment length");
     add_setting(*layout, "--iter", g_settings->graphLayoutQuality, "Graph layout iterations");
+    layout->add_option("--layout", g_settings->graphLayoutAlgorithm,
+                       "Graph layout algorithm: fmmm, or multilevel to collapse unbranching paths first (much faster on large graphs)")
+            ->transform(CLI::CheckedTransformer(
+                std::vector<std::pair<std::string, GraphLayoutAlgorithm>>{
+                    {"fmmm", FMMM_LAYOUT},
+                    {"multilevel", MULTILEVEL_LAYOUT}}))
+            ->default_val("fmmm");
     layout->add_flag("--linear", g_settings->linearLayout, "Linear graph layout")
             ->capture_default_str();
 
@@ -297,6 +304,9 @@ static CLI::App *addGraphAppearanceSettings(CLI::App &app) {
             ->default_str(getDefaultColour(g_settings->selectionColour).toStdString());
     ga->add_flag("--aa,!--noaa", g_settings->antialiasing, "Enable / disable antialiasing")
             ->capture_default_str();
+    ga->add_flag("--lod,!--nolod", g_settings->levelOfDetail,
+                 "Enable / disable simplified drawing of nodes and edges only a few pixels large in the graph view")
+            ->capture_default_str();
     ga->add_flag("--double,!--single", g_settings->doubleMode, "Draw graph in single / double mode")
             ->capture_default_str();
     ga->add_flag("--singlearr", g_settings->arrowheadsInSingleMode, "Show node arrowheads in single mode")
@@ -518,6 +528,22 @@ static CLI::App *addQueryPathsSettings(CLI::App &app) {
     return bqp;
 }
 
+static CLI::App *addPerformanceSettings(CLI::App &app) {
+    auto *perf = app.add_option_group("Performance");
+    add_setting(*perf, "--threads", g_settings->threads,
+                "Number of worker threads to use for graph loading, analysis and graph searches");
+    add_setting(*perf, "--layoutthreads", g_settings->layoutThreads,
+                "Number of threads to use for the layout of large graph components (0 to use all cores)");
+    add_setting(*perf, "--layoutcache", g_settings->layoutCacheSize,
+                "Size limit of the on-disk layout cache in megabytes (0 to disable the cache)");
+    add_setting(*perf, "--searchcache", g_settings->searchCacheSize,
+                "Size limit of the on-disk search database cache in megabytes (0 to disable the cache)");
+    add_setting(*perf, "--pathsearchlimit", g_settings->queryPathSearchLimit,
+                "Maximum number of partial paths examined when looking for the paths of a query (0 for no limit)");
+
+    return perf;
+}
+
 CLI::App *addSettings(CLI::App &app) {
     auto *scope = addGraphScopeSettings(app);
     auto *size = addGraphSizeSettings(app);
@@ -532,6 +558,7 @@ CLI::App *addSettings(CLI::App &app) {
     auto *dc = addDepthColorsSettings(app);
     auto *bs = addBlastSearchSettings(app);
     auto *bqp = addQueryPathsSettings(app);
+    auto *perf = addPerformanceSettings(app);
 
     return &app;
 }
@@ -0,0 +1,69 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "adjacency.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+using namespace graph;
+
+Adjacency::Adjacency(const AssemblyGraph &graph) {
+    // Assign ids pairwise, positive node (or the first one seen from the pair)
+    // gets the even one
+    m_nodes.reserve(graph.m_deBruijnGraphNodes.size() + 1);
+    m_ids.reserve(graph.m_deBruijnGraphNodes.size());
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (m_ids.count(node))
+            continue;
+
+        DeBruijnNode *rcNode = node->getReverseComplement();
+        if (rcNode && rcNode != node && node->isNegativeNode() && !m_ids.count(rcNode))
+            std::swap(node, rcNode);
+
+        auto id = NodeId(m_nodes.size());
+        m_ids.emplace(node, id);
+        m_nodes.push_back(node);
+        if (rcNode && rcNode != node) {
+            m_ids.emplace(rcNode, id + 1);
+            m_nodes.push_back(rcNode);
+        } else
+            m_nodes.push_back(nullptr);
+    }
+
+    // Count the leaving edges of every node, then fill the rows
+    m_offsets.assign(m_nodes.size() + 1, 0);
+    for (const auto &entry : graph.m_deBruijnGraphEdges)
+        m_offsets[id(entry.first.first) + 1] += 1;
+    for (size_t i = 1; i < m_offsets.size(); ++i)
+        m_offsets[i] += m_offsets[i - 1];
+
+    m_targets.resize(m_offsets.back());
+    m_edges.resize(m_offsets.back());
+    std::vector<uint64_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+    for (const auto &entry : graph.m_deBruijnGraphEdges) {
+        uint64_t pos = fill[id(entry.first.first)]++;
+        m_targets[pos] = id(entry.first.second);
+        m_edges[pos] = entry.second;
+    }
+}
+
+Adjacency::NodeId Adjacency::id(const DeBruijnNode *node) const {
+    auto it = m_ids.find(node);
+    return it == m_ids.end() ? INVALID : it->second;
+}
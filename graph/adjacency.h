@@ -0,0 +1,85 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "llvm/ADT/iterator_range.h"
+#include "parallel_hashmap/phmap.h"
+
+#include <cstdint>
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+class DeBruijnEdge;
+
+namespace graph {
+    // Read-only compressed sparse row snapshot of the graph structure. Nodes
+    // get dense integer ids, a node and its reverse complement always get the
+    // ids 2k and 2k + 1, so id ^ 1 is the reverse complement and id >> 1
+    // identifies the complementary pair.
+    //
+    // Only leaving edges are stored: the edges entering a node are the
+    // reverse complements of the edges leaving its reverse complement.
+    //
+    // The snapshot must not outlive any structural change of the graph, use
+    // AssemblyGraph::adjacency() to get an up to date one.
+    class Adjacency {
+    public:
+        using NodeId = uint32_t;
+        static constexpr NodeId INVALID = NodeId(-1);
+
+        explicit Adjacency(const AssemblyGraph &graph);
+
+        [[nodiscard]] size_t nodeCount() const { return m_nodes.size(); }
+        [[nodiscard]] size_t pairCount() const { return m_nodes.size() / 2; }
+        [[nodiscard]] size_t edgeCount() const { return m_targets.size(); }
+
+        static NodeId rc(NodeId id) { return id ^ 1; }
+        static bool isPositive(NodeId id) { return (id & 1) == 0; }
+
+        // Might be null for the missing half of an unpaired node
+        [[nodiscard]] DeBruijnNode *node(NodeId id) const { return m_nodes[id]; }
+        [[nodiscard]] NodeId id(const DeBruijnNode *node) const;
+
+        [[nodiscard]] auto outgoing(NodeId id) const {
+            return llvm::make_range(m_targets.data() + m_offsets[id], m_targets.data() + m_offsets[id + 1]);
+        }
+        [[nodiscard]] auto outgoingEdges(NodeId id) const {
+            return llvm::make_range(m_edges.data() + m_offsets[id], m_edges.data() + m_offsets[id + 1]);
+        }
+        [[nodiscard]] size_t outDegree(NodeId id) const { return m_offsets[id + 1] - m_offsets[id]; }
+        [[nodiscard]] size_t inDegree(NodeId id) const { return outDegree(rc(id)); }
+
+        // Calls fn(NodeId) for every node connected to the given one either by
+        // a leaving or an entering edge
+        template<class Fn>
+        void forEachNeighbour(NodeId id, Fn &&fn) const {
+            for (NodeId target : outgoing(id))
+                fn(target);
+            for (NodeId source : outgoing(rc(id)))
+                fn(rc(source));
+        }
+
+    private:
+        std::vector<DeBruijnNode *> m_nodes;
+        phmap::flat_hash_map<const DeBruijnNode *, NodeId> m_ids;
+        std::vector<uint64_t> m_offsets;
+        std::vector<NodeId> m_targets;
+        std::vector<DeBruijnEdge *> m_edges;
+    };
+}
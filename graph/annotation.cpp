@@ -17,39 +17,39 @@
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "annotation.h"
-#include "graphicsitemnode.h"
+#include "nodedrawing.h"
 #include "program/settings.h"
 
 #include <QPen>
 #include <QPainter>
 
-void SolidView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+void SolidView::drawFigure(QPainter &painter, NodeDrawing &nodeDrawing, bool reverseComplement, int64_t start,
                            int64_t end) const {
     QPen pen;
     pen.setCapStyle(Qt::FlatCap);
     pen.setJoinStyle(Qt::BevelJoin);
 
-    pen.setWidthF(m_widthMultiplier * graphicsItemNode.m_width);
+    pen.setWidthF(m_widthMultiplier * nodeDrawing.m_width);
 
     pen.setColor(m_color);
     painter.setPen(pen);
 
-    double fractionStart = graphicsItemNode.indexToFraction(start);
-    double fractionEnd = graphicsItemNode.indexToFraction(end + 1);
+    double fractionStart = nodeDrawing.indexToFraction(start);
+    double fractionEnd = nodeDrawing.indexToFraction(end + 1);
 
     if (reverseComplement) {
         fractionStart = 1 - fractionStart;
         fractionEnd = 1 - fractionEnd;
     }
-    painter.drawPath(graphicsItemNode.makePartialPath(fractionStart, fractionEnd));
+    painter.drawPath(nodeDrawing.makePartialPath(fractionStart, fractionEnd));
 }
 
-void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+void RainbowBlastHitView::drawFigure(QPainter &painter, NodeDrawing &nodeDrawing, bool reverseComplement,
                                      int64_t start, int64_t end) const {
 
-    double scaledNodeLength = graphicsItemNode.getNodePathLength() * g_absoluteZoom;
-    double fractionStart = graphicsItemNode.indexToFraction(start);
-    double fractionEnd = graphicsItemNode.indexToFraction(end + 1);
+    double scaledNodeLength = nodeDrawing.getNodePathLength() * g_absoluteZoom;
+    double fractionStart = nodeDrawing.indexToFraction(start);
+    double fractionEnd = nodeDrawing.indexToFraction(end + 1);
     double scaledHitLength = (fractionEnd - fractionStart) * scaledNodeLength;
     int partCount = ceil(
             g_settings->blastRainbowPartsPerQuery * fabs(m_rainbowFractionStart - m_rainbowFractionEnd));
@@ -70,7 +70,7 @@ void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphi
     pen.setCapStyle(Qt::FlatCap);
     pen.setJoinStyle(Qt::BevelJoin);
 
-    pen.setWidthF(graphicsItemNode.m_width);
+    pen.setWidthF(nodeDrawing.m_width);
 
     for (int i = 0; i < partCount; ++i) {
         QColor dotColour;
@@ -83,24 +83,24 @@ void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphi
 
         pen.setColor(dotColour);
         painter.setPen(pen);
-        painter.drawPath(graphicsItemNode.makePartialPath(fromFraction, toFraction));
+        painter.drawPath(nodeDrawing.makePartialPath(fromFraction, toFraction));
 
         nodeFraction = nextFraction;
         rainbowFraction += rainbowSpacing;
     }
 }
 
-void Annotation::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement,
+void Annotation::drawFigure(QPainter &painter, NodeDrawing &nodeDrawing, bool reverseComplement,
                             const std::set<ViewId> &viewsToShow) const {
     for (auto view_id : viewsToShow) {
-        m_views[view_id]->drawFigure(painter, graphicsItemNode, reverseComplement, m_start, m_end);
+        m_views[view_id]->drawFigure(painter, nodeDrawing, reverseComplement, m_start, m_end);
     }
 }
 
-void Annotation::drawDescription(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement) const {
+void Annotation::drawDescription(QPainter &painter, NodeDrawing &nodeDrawing, bool reverseComplement) const {
     double annotationCenter =
-            (graphicsItemNode.indexToFraction(m_start) + graphicsItemNode.indexToFraction(m_end)) / 2;
-    auto textPoint = graphicsItemNode.findLocationOnPath(
+            (nodeDrawing.indexToFraction(m_start) + nodeDrawing.indexToFraction(m_end)) / 2;
+    auto textPoint = nodeDrawing.findLocationOnPath(
             reverseComplement ? 1 - annotationCenter : annotationCenter);
     auto qStringText = QString::fromStdString(m_text);
 
@@ -109,7 +109,7 @@ void Annotation::drawDescription(QPainter &painter, GraphicsItemNode &graphicsIt
     double shiftLeft = -metrics.boundingRect(qStringText).width() / 2.0;
     textPath.addText(shiftLeft, 0.0, g_settings->labelFont, qStringText);
 
-    GraphicsItemNode::drawTextPathAtLocation(&painter, textPath, textPoint);
+    NodeDrawing::drawTextPathAtLocation(&painter, textPath, textPoint);
 }
 
 BedBlockView::BedBlockView(double widthMultiplier, const QColor &color, const std::vector<bed::Block> &blocks)
@@ -120,9 +120,9 @@ BedBlockView::BedBlockView(double widthMultiplier, const QColor &color, const st
     }
 }
 
-void BedBlockView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
+void BedBlockView::drawFigure(QPainter &painter, NodeDrawing &nodeDrawing, bool reverseComplement, int64_t start,
                               int64_t end) const {
     for (const auto &block: m_blocks) {
-        block.drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
+        block.drawFigure(painter, nodeDrawing, reverseComplement, start, end);
     }
 }
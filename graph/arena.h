@@ -0,0 +1,188 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+    // Allocates objects of type T from large contiguous slabs. Objects could be
+    // destroyed individually (their slots are reused by subsequent
+    // allocations), however the main point is clear(): everything is released
+    // at once without going through the allocator for every object.
+    // Destructors are run only for types that need them.
+    template<class T, size_t SlabObjects = 4096>
+    class ObjectArena {
+        union Slot {
+            Slot *next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        struct Slab {
+            Slot slots[SlabObjects];
+            std::bitset<SlabObjects> live;
+        };
+
+    public:
+        ObjectArena() = default;
+        ObjectArena(const ObjectArena &) = delete;
+        ObjectArena &operator=(const ObjectArena &) = delete;
+        ~ObjectArena() { clear(); }
+
+        template<class... Args>
+        T *create(Args &&... args) {
+            auto [slab, slot] = allocate();
+            T *obj;
+            try {
+                obj = new(slot->storage) T(std::forward<Args>(args)...);
+            } catch (...) {
+                slot->next = freeList_;
+                freeList_ = slot;
+                throw;
+            }
+
+            slab->live.set(slot - slab->slots);
+            size_ += 1;
+            return obj;
+        }
+
+        void destroy(T *obj) {
+            if (!obj)
+                return;
+
+            auto *slot = reinterpret_cast<Slot *>(obj);
+            Slab *slab = findSlab(slot);
+            obj->~T();
+            slab->live.reset(slot - slab->slots);
+            slot->next = freeList_;
+            freeList_ = slot;
+            size_ -= 1;
+        }
+
+        void clear() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (auto &slab : slabs_) {
+                    if (slab->live.none())
+                        continue;
+                    for (size_t i = 0; i < SlabObjects; ++i)
+                        if (slab->live.test(i))
+                            std::launder(reinterpret_cast<T *>(slab->slots[i].storage))->~T();
+                }
+            }
+
+            slabs_.clear();
+            sortedSlabs_.clear();
+            used_ = SlabObjects;
+            freeList_ = nullptr;
+            size_ = 0;
+        }
+
+        [[nodiscard]] size_t size() const { return size_; }
+        [[nodiscard]] size_t allocatedBytes() const { return slabs_.size() * sizeof(Slab); }
+
+    private:
+        std::pair<Slab *, Slot *> allocate() {
+            if (freeList_) {
+                Slot *slot = freeList_;
+                freeList_ = slot->next;
+                return { findSlab(slot), slot };
+            }
+
+            if (used_ == SlabObjects) {
+                // Slots are left uninitialized, only the liveness bits are cleared
+                slabs_.emplace_back(new Slab);
+                Slab *slab = slabs_.back().get();
+                sortedSlabs_.insert(std::upper_bound(sortedSlabs_.begin(), sortedSlabs_.end(), slab,
+                                                     std::less<>()),
+                                    slab);
+                used_ = 0;
+            }
+
+            Slab *slab = slabs_.back().get();
+            return { slab, &slab->slots[used_++] };
+        }
+
+        Slab *findSlab(const Slot *slot) const {
+            // The last slab starting at or before the slot
+            auto it = std::upper_bound(sortedSlabs_.begin(), sortedSlabs_.end(), slot,
+                                       [](const Slot *s, const Slab *slab) {
+                                           return std::less<>()(s, slab->slots);
+                                       });
+            return *std::prev(it);
+        }
+
+        std::vector<std::unique_ptr<Slab>> slabs_;
+        // Slabs ordered by address, used to find the slab owning an object
+        std::vector<Slab *> sortedSlabs_;
+        // Number of slots handed out from the last slab
+        size_t used_ = SlabObjects;
+        Slot *freeList_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Stores strings back to back in large blocks. Strings are never freed
+    // individually, only all at once via clear(), so the returned views are
+    // valid until then.
+    class StringPool {
+        static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    public:
+        std::string_view intern(std::string_view str) {
+            if (str.size() > left_) {
+                size_t blockSize = std::max(BLOCK_SIZE, str.size());
+                blocks_.emplace_back(new char[blockSize]);
+                current_ = blocks_.back().get();
+                left_ = blockSize;
+                allocated_ += blockSize;
+            }
+
+            char *res = current_;
+            if (!str.empty())
+                std::memcpy(res, str.data(), str.size());
+            current_ += str.size();
+            left_ -= str.size();
+            used_ += str.size();
+
+            return { res, str.size() };
+        }
+
+        void clear() {
+            blocks_.clear();
+            current_ = nullptr;
+            left_ = allocated_ = used_ = 0;
+        }
+
+        [[nodiscard]] size_t allocatedBytes() const { return allocated_; }
+        [[nodiscard]] size_t usedBytes() const { return used_; }
+
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        char *current_ = nullptr;
+        size_t left_ = 0;
+        size_t allocated_ = 0;
+        size_t used_ = 0;
+    };
+}
@@ -36,7 +36,6 @@
 #include <QApplication>
 #include <QFile>
 #include <QList>
-#include <QQueue>
 #include <QRegularExpression>
 #include <QSet>
 
@@ -81,19 +80,14 @@ void AssemblyGraph::cleanUp() {
     m_deBruijnGraphPaths.clear();
     m_deBruijnGraphWalks.clear();
 
-    {
-        for (auto &entry : m_deBruijnGraphNodes) {
-            delete entry;
-        }
-        m_deBruijnGraphNodes.clear();
-    }
-
-    {
-        for (auto &entry : m_deBruijnGraphEdges) {
-            delete entry.second;
-        }
-        m_deBruijnGraphEdges.clear();
-    }
+    // Nodes, edges and their names are released at once together with the
+    // arenas, no need to go over them one by one
+    m_deBruijnGraphNodes.clear();
+    m_deBruijnGraphEdges.clear();
+    m_adjacency.reset();
+    m_nodeArena.clear();
+    m_edgeArena.clear();
+    m_namePool.clear();
 
     m_nodeTags.clear();
     m_edgeTags.clear();
@@ -104,6 +98,64 @@ void AssemblyGraph::cleanUp() {
     clearGraphInfo();
 }
 
+DeBruijnNode *AssemblyGraph::createNode(std::string_view name, float depth, const Sequence &sequence,
+                                        unsigned length) {
+    m_adjacency.reset();
+    return m_nodeArena.create(m_namePool.intern(name), depth, sequence, length);
+}
+
+DeBruijnEdge *AssemblyGraph::createEdge(DeBruijnNode *startingNode, DeBruijnNode *endingNode) {
+    m_adjacency.reset();
+    return m_edgeArena.create(startingNode, endingNode);
+}
+
+void AssemblyGraph::destroyNode(DeBruijnNode *node) {
+    m_adjacency.reset();
+    m_nodeArena.destroy(node);
+}
+
+void AssemblyGraph::destroyEdge(DeBruijnEdge *edge) {
+    m_adjacency.reset();
+    m_edgeArena.destroy(edge);
+}
+
+// The old name stays in the pool until the graph is cleaned up
+void AssemblyGraph::renameNode(DeBruijnNode *node, std::string_view newName) {
+    node->setName(m_namePool.intern(newName));
+}
+
+const graph::Adjacency &AssemblyGraph::adjacency() const {
+    std::lock_guard<std::mutex> lock(m_adjacencyMutex);
+    if (!m_adjacency)
+        m_adjacency = std::make_unique<graph::Adjacency>(*this);
+
+    return *m_adjacency;
+}
+
+AssemblyGraph::MemoryUsage AssemblyGraph::getMemoryUsage() const {
+    MemoryUsage usage{};
+    usage.nodeCount = m_nodeArena.size();
+    usage.edgeCount = m_edgeArena.size();
+    usage.nodeBytes = m_nodeArena.allocatedBytes();
+    usage.edgeBytes = m_edgeArena.allocatedBytes();
+    usage.nameBytes = m_namePool.allocatedBytes();
+
+    // Sequences are stored packed, 2 bits per base. Count every buffer once:
+    // the reverse complement node normally is a view of the same buffer.
+    // Absent sequences take no space.
+    phmap::flat_hash_set<const void *> buffers;
+    for (const auto *node : m_deBruijnGraphNodes) {
+        const Sequence &sequence = node->getSequence();
+        if (sequence.buffer() && buffers.insert(sequence.buffer()).second)
+            usage.sequenceBytes += sequence.capacity();
+    }
+
+    // Flat hash map keeps a control byte per slot
+    usage.edgeIndexBytes = m_deBruijnGraphEdges.capacity() * (sizeof(decltype(m_deBruijnGraphEdges)::value_type) + 1);
+
+    return usage;
+}
+
 //The function returns a node name, replacing "+" at the end with "-" or
 //vice-versa.
 static QString getOppositeNodeName(QString nodeName) {
@@ -147,13 +199,13 @@ void AssemblyGraph::createDeBruijnEdge(const QString& node1Name, const QString&
     //for an edge to be its own pair.
     bool isOwnPair = (*node1 == *negNode2 && *node2 == *negNode1);
 
-    auto * forwardEdge = new DeBruijnEdge(*node1, *node2);
+    auto * forwardEdge = createEdge(*node1, *node2);
     DeBruijnEdge * backwardEdge;
 
     if (isOwnPair)
         backwardEdge = forwardEdge;
     else
-        backwardEdge = new DeBruijnEdge(*negNode2, *negNode1);
+        backwardEdge = createEdge(*negNode2, *negNode1);
 
     forwardEdge->setReverseComplement(backwardEdge);
     backwardEdge->setReverseComplement(forwardEdge);
@@ -505,7 +557,9 @@ bool AssemblyGraph::loadGraphFromFile(const QString& filename) {
     auto builder = io::AssemblyGraphBuilder::get(filename);
     if (!builder)
         return false;
-    
+
+    builder->setThreads(g_settings->threads);
+
     try {
         builder->build(*this);
     } catch (...) {
@@ -534,6 +588,13 @@ void AssemblyGraph::markNodesToDraw(const graph::Scope &scope,
                 entry->setAsDrawn();
         }
     } else {
+        const auto &adj = adjacency();
+        // Level at which the node was last queued, avoids queueing the same
+        // node twice within a level
+        std::vector<unsigned> queued(adj.nodeCount(), 0);
+        unsigned level = 0;
+        std::vector<graph::Adjacency::NodeId> worklist, next;
+
         for (auto *node : startingNodes) {
             //If we are in single mode, make sure that each node is positive.
             if (!g_settings->doubleMode && node->isNegativeNode())
@@ -541,7 +602,26 @@ void AssemblyGraph::markNodesToDraw(const graph::Scope &scope,
 
             node->setAsDrawn();
             node->setAsSpecial();
-            node->labelNeighbouringNodesAsDrawn(scope.distance());
+
+            // Label all nodes within a certain distance of this node as drawn.
+            // Nodes that are already drawn are not expanded further.
+            worklist.assign(1, adj.id(node));
+            for (int depth = 0; depth <= scope.distance() && !worklist.empty(); ++depth) {
+                level += 1;
+                next.clear();
+                for (auto id : worklist) {
+                    DeBruijnNode *nodeToMark = adj.node(g_settings->doubleMode ? id : id & ~1u);
+                    nodeToMark->setAsDrawn();
+
+                    adj.forEachNeighbour(id, [&](graph::Adjacency::NodeId other) {
+                        if (queued[other] == level || adj.node(other)->thisNodeOrReverseComplementIsDrawn())
+                            return;
+                        queued[other] = level;
+                        next.push_back(other);
+                    });
+                }
+                worklist.swap(next);
+            }
         }
     }
 
@@ -661,10 +741,9 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(const QString
             continue;
 
         bool found = false;
+        std::string query = queryName.toStdString();
         for (auto &entry : m_deBruijnGraphNodes) {
-            QString nodeName = entry->getName();
-
-            if (nodeName.contains(queryName))
+            if (entry->getNameView().find(query) != std::string_view::npos)
             {
                 found = true;
                 returnVector.push_back(entry);
@@ -846,10 +925,10 @@ void AssemblyGraph::deleteNodes(const std::vector<DeBruijnNode *> &nodes)
 
     // Remove the nodes from the graph.
     for (auto *node : nodesToDelete)
-        m_deBruijnGraphNodes.erase(node->getName().toStdString());
+        m_deBruijnGraphNodes.erase_ks(node->getNameView().data(), node->getNameView().size());
 
     for (auto *node : nodesToDelete)
-        delete node;
+        destroyNode(node);
 }
 
 void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
@@ -870,7 +949,7 @@ void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
         startingNode->removeEdge(edge);
         endingNode->removeEdge(edge);
 
-        delete edge;
+        destroyEdge(edge);
     }
 }
 
@@ -889,8 +968,9 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, BandageGraphicsScene
     double newDepth = node->getDepth() / 2.0;
 
     //Create the new nodes.
-    auto * newPosNode = new DeBruijnNode(newPosNodeName, newDepth, originalPosNode->getSequence());
-    auto * newNegNode = new DeBruijnNode(newNegNodeName, newDepth, originalNegNode->getSequence());
+    auto * newPosNode = createNode(newPosNodeName.toStdString(), newDepth, originalPosNode->getSequence());
+    auto * newNegNode = createNode(newNegNodeName.toStdString(), newDepth,
+                                   newPosNode->getSequence().GetReverseComplement());
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
 
@@ -1037,8 +1117,8 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
     for (auto it = orderedList.rbegin(); it != orderedList.rend(); ++it)
         revCompOrderedList.push_back((*it)->getReverseComplement());
 
-    Path negPath = Path::makeFromOrderedNodes(revCompOrderedList, false);
-    Sequence mergedNodeNegSequence{negPath.getPathSequence()};
+    // The negative node is a view of the same sequence buffer
+    Sequence mergedNodeNegSequence = mergedNodePosSequence.GetReverseComplement();
 
     QString newNodeBaseName;
     for (int i = 0; i < orderedList.size(); ++i) {
@@ -1052,8 +1132,8 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
 
     double mergedNodeDepth = getMeanDepth(orderedList);
 
-    auto newPosNode = new DeBruijnNode(newPosNodeName, mergedNodeDepth, mergedNodePosSequence);
-    auto newNegNode = new DeBruijnNode(newNegNodeName, mergedNodeDepth, mergedNodeNegSequence);
+    auto newPosNode = createNode(newPosNodeName.toStdString(), mergedNodeDepth, mergedNodePosSequence);
+    auto newNegNode = createNode(newNegNodeName.toStdString(), mergedNodeDepth, mergedNodeNegSequence);
 
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
@@ -1387,8 +1467,8 @@ void AssemblyGraph::changeNodeName(const QString& oldName, const QString& newNam
     QString posNewNodeName = newName + "+";
     QString negNewNodeName = newName + "-";
 
-    posNode->setName(posNewNodeName);
-    negNode->setName(negNewNodeName);
+    renameNode(posNode, posNewNodeName.toStdString());
+    renameNode(negNode, negNewNodeName.toStdString());
 
     m_deBruijnGraphNodes.emplace(posNewNodeName.toStdString(), posNode);
     m_deBruijnGraphNodes.emplace(negNewNodeName.toStdString(), negNode);
@@ -1438,258 +1518,6 @@ void AssemblyGraph::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
 }
 
 
-//This function returns the number of dead ends in the graph.
-//It looks only at positive nodes, which can have 0, 1 or 2 dead ends each.
-//This value therefore varies between zero and twice the node count (specifically
-//the positive node count).
-unsigned AssemblyGraph::getDeadEndCount() const
-{
-    int deadEndCount = 0;
-
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-            deadEndCount += node->getDeadEndCount();
-    }
-
-    return deadEndCount;
-}
-
-
-
-void AssemblyGraph::getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const
-{
-    if (m_totalLength == 0.0)
-        return;
-
-    std::vector<int> nodeLengths;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-            nodeLengths.push_back(node->getLength());
-    }
-
-    if (nodeLengths.empty())
-        return;
-
-    std::sort(nodeLengths.begin(), nodeLengths.end());
-
-    *shortestNode = nodeLengths.front();
-    *longestNode = nodeLengths.back();
-
-    double firstQuartileIndex = (nodeLengths.size() - 1) / 4.0;
-    double medianIndex = (nodeLengths.size() - 1) / 2.0;
-    double thirdQuartileIndex = (nodeLengths.size() - 1) * 3.0 / 4.0;
-
-    *firstQuartile = round(getValueUsingFractionalIndex(nodeLengths, firstQuartileIndex));
-    *median = round(getValueUsingFractionalIndex(nodeLengths, medianIndex));
-    *thirdQuartile = round(getValueUsingFractionalIndex(nodeLengths, thirdQuartileIndex));
-
-    double halfTotalLength = m_totalLength / 2.0;
-    long long totalSoFar = 0;
-    for (int i = int(nodeLengths.size()) - 1; i >= 0 ; --i)
-    {
-        totalSoFar += nodeLengths[i];
-        if (totalSoFar >= halfTotalLength)
-        {
-            *n50 = nodeLengths[i];
-            break;
-        }
-    }
-}
-
-
-
-//This function uses an algorithm adapted from: http://math.hws.edu/eck/cs327_s04/chapter9.pdf
-void AssemblyGraph::getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const
-{
-    *componentCount = 0;
-    *largestComponentLength = 0;
-
-    QSet<DeBruijnNode *> visitedNodes;
-    QList< QList<DeBruijnNode *> > connectedComponents;
-
-    //Loop through all positive nodes.
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * v = entry;
-        if (v->isNegativeNode())
-            continue;
-
-        //If the node has not yet been visited, then it must be the start of a new connected component.
-        if (!visitedNodes.contains(v))
-        {
-            QList<DeBruijnNode *> connectedComponent;
-
-            QQueue<DeBruijnNode *> q;
-            q.enqueue(v);
-            visitedNodes.insert(v);
-
-            while (!q.isEmpty())
-            {
-                DeBruijnNode * w = q.dequeue();
-                connectedComponent.push_back(w);
-
-                std::vector<DeBruijnNode *> connectedNodes = w->getAllConnectedPositiveNodes();
-                for (auto k : connectedNodes)
-                {
-                    if (!visitedNodes.contains(k))
-                    {
-                        visitedNodes.insert(k);
-                        q.enqueue(k);
-                    }
-                }
-            }
-
-            connectedComponents.push_back(connectedComponent);
-        }
-    }
-
-    //Now that the list of connected components is built, we look for the
-    //largest one (as measured by total node length).
-    *componentCount = connectedComponents.size();
-    for (int i = 0; i < *componentCount; ++i)
-    {
-        int componentLength = 0;
-        for (auto & j : connectedComponents[i])
-            componentLength += j->getLength();
-
-        if (componentLength > *largestComponentLength)
-            *largestComponentLength = componentLength;
-    }
-}
-
-bool compareNodeDepth(DeBruijnNode * a, DeBruijnNode * b) {return (a->getDepth() < b->getDepth());}
-
-//This function takes a node list sorted by depth and a target index (in terms of
-//the whole sequence length).  It returns the depth at that index.
-static double findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex)
-{
-    long long lengthSoFar = 0;
-    for (auto node : *nodeList)
-    {
-        lengthSoFar += node->getLength();
-        long long currentIndex = lengthSoFar - 1;
-
-        if (currentIndex >= targetIndex)
-            return node->getDepth();
-    }
-    return 0.0;
-}
-
-
-double AssemblyGraph::getMedianDepthByBase() const
-{
-    if (m_totalLength == 0)
-        return 0.0;
-
-    //Make a list of all nodes.
-    long long totalLength = 0;
-    QList<DeBruijnNode *> nodeList;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-        {
-            nodeList.push_back(node);
-            totalLength += node->getLength();
-        }
-    }
-
-    //If there is only one node, then its depth is the median.
-    if (nodeList.size() == 1)
-        return nodeList[0]->getDepth();
-
-    //Sort the node list from low to high depth.
-    std::sort(nodeList.begin(), nodeList.end(), compareNodeDepth);
-
-    if (totalLength % 2 == 0) //Even total length
-    {
-        long long medianIndex2 = totalLength / 2;
-        long long medianIndex1 = medianIndex2 - 1;
-        double depth1 = findDepthAtIndex(&nodeList, medianIndex1);
-        double depth2 = findDepthAtIndex(&nodeList, medianIndex2);
-        return (depth1 + depth2) / 2.0;
-    }
-    else //Odd total length
-    {
-        long long medianIndex = (totalLength - 1) / 2;
-        return findDepthAtIndex(&nodeList, medianIndex);
-    }
-}
-
-
-long long AssemblyGraph::getEstimatedSequenceLength(double medianDepthByBase) const
-{
-    long long estimatedSequenceLength = 0;
-    if (medianDepthByBase == 0.0)
-        return 0;
-
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-
-        if (node->isPositiveNode())
-        {
-            int nodeLength = node->getLengthWithoutTrailingOverlap();
-            double relativeDepth = node->getDepth() / medianDepthByBase;
-
-            int closestIntegerDepth = round(relativeDepth);
-            int lengthAdjustedForDepth = nodeLength * closestIntegerDepth;
-
-            estimatedSequenceLength += lengthAdjustedForDepth;
-        }
-    }
-
-    return estimatedSequenceLength;
-}
-
-
-
-long long AssemblyGraph::getTotalLengthMinusEdgeOverlaps() const
-{
-    long long totalLength = 0;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode())
-        {
-            totalLength += node->getLength();
-            int maxOverlap = 0;
-            for (const auto* edge : node->edges()) {
-                int edgeOverlap = edge->getOverlap();
-                maxOverlap = std::max(maxOverlap, edgeOverlap);
-            }
-            totalLength -= maxOverlap;
-        }
-    }
-
-    return totalLength;
-}
-
-
-QPair<int, int> AssemblyGraph::getOverlapRange() const
-{
-    int smallestOverlap = std::numeric_limits<int>::max();
-    int largestOverlap = 0;
-    for (auto &entry : m_deBruijnGraphEdges) {
-        int overlap = entry.second->getOverlap();
-        if (overlap < smallestOverlap)
-            smallestOverlap = overlap;
-        if (overlap > largestOverlap)
-            largestOverlap = overlap;
-    }
-    if (smallestOverlap == std::numeric_limits<int>::max())
-        smallestOverlap = 0;
-    return { smallestOverlap, largestOverlap };
-}
-
-long long AssemblyGraph::getTotalLengthOrphanedNodes() const {
-    long long total = 0;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
-        if (node->isPositiveNode() && node->getDeadEndCount() == 2)
-            total += node->getLength();
-    }
-    return total;
-}
-
 QStringList AssemblyGraph::getCustomLabelForDisplay(const DeBruijnNode *node) const {
     QStringList customLabelLines;
     QString label = getCustomLabel(node);
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "adjacency.h"
+#include "arena.h"
 #include "debruijnedge.h"
 #include "path.h"
 #include "annotation.h"
@@ -34,6 +36,8 @@
 #include <QString>
 #include <QPair>
 #include <QObject>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 class DeBruijnNode;
@@ -117,6 +121,37 @@ public:
     SequencesLoadedFromFasta m_sequencesLoadedFromFasta;
 
     void cleanUp();
+
+    // Nodes and edges are owned by the graph and must be created / destroyed
+    // through it. Node names are copied into the graph name pool.
+    DeBruijnNode *createNode(std::string_view name, float depth, const Sequence &sequence,
+                             unsigned length = 0);
+    DeBruijnEdge *createEdge(DeBruijnNode *startingNode, DeBruijnNode *endingNode);
+    void destroyNode(DeBruijnNode *node);
+    void destroyEdge(DeBruijnEdge *edge);
+    void renameNode(DeBruijnNode *node, std::string_view newName);
+
+    struct MemoryUsage {
+        size_t nodeCount;
+        size_t edgeCount;
+        size_t nodeBytes;
+        size_t edgeBytes;
+        size_t nameBytes;
+        size_t sequenceBytes;
+        size_t edgeIndexBytes;
+
+        size_t totalBytes() const {
+            return nodeBytes + edgeBytes + nameBytes + sequenceBytes + edgeIndexBytes;
+        }
+    };
+    MemoryUsage getMemoryUsage() const;
+
+    // Read-only CSR snapshot of the graph structure, built on first use after
+    // every structural change. References to it are invalidated by any node or
+    // edge creation / deletion. Safe to call from several threads at once as
+    // long as the graph is not changed meanwhile.
+    const graph::Adjacency &adjacency() const;
+
     void createDeBruijnEdge(const QString& node1Name, const QString& node2Name,
                             int overlap = 0,
                             EdgeOverlapType overlapType = UNKNOWN_OVERLAP);
@@ -161,16 +196,6 @@ public:
     void changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
                          double newDepth);
 
-    unsigned int getDeadEndCount() const;
-    void getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const;
-    void getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const;
-    double getMedianDepthByBase() const;
-
-    long long getEstimatedSequenceLength(double medianDepthByBase) const;
-    long long getTotalLengthMinusEdgeOverlaps() const;
-    QPair<int, int> getOverlapRange() const;
-    long long getTotalLengthOrphanedNodes() const;
-
     bool hasCustomColour(const DeBruijnNode* node) const;
     bool hasCustomColour(const DeBruijnEdge* edge) const;
     QColor getCustomColour(const DeBruijnNode* node) const;
@@ -202,6 +227,12 @@ public:
 
     std::vector<DeBruijnNode *> getNodesInDepthRange(double min, double max) const;
 private:
+    graph::ObjectArena<DeBruijnNode> m_nodeArena;
+    graph::ObjectArena<DeBruijnEdge> m_edgeArena;
+    graph::StringPool m_namePool;
+    mutable std::unique_ptr<graph::Adjacency> m_adjacency;
+    mutable std::mutex m_adjacencyMutex;
+
     std::vector<DeBruijnNode *> getNodesFromListExact(const QStringList& nodesList, std::vector<QString> * nodesNotInGraph) const;
     std::vector<DeBruijnNode *> getNodesFromListPartial(const QStringList& nodesList, std::vector<QString> * nodesNotInGraph) const;
     std::vector<int> makeOverlapCountVector();
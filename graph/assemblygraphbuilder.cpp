@@ -32,6 +32,9 @@
 #include <QDir>
 #include <QString>
 #include <QRegularExpression>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cstring>
 #include <memory>
 
 #include <zlib.h>
@@ -128,10 +131,10 @@ static ssize_t gzgetline(char **buf, size_t *bufsiz, gzFile fp) {
 }
 
 
-static std::string getOppositeNodeName(std::string nodeName) {
-    return (nodeName.back() == '-' ?
-            nodeName.substr(0, nodeName.size() - 1) + '+' :
-            nodeName.substr(0, nodeName.size() - 1) + '-');
+static std::string getOppositeNodeName(std::string_view nodeName) {
+    std::string oppositeName(nodeName.substr(0, nodeName.size() - 1));
+    oppositeName += nodeName.back() == '-' ? '+' : '-';
+    return oppositeName;
 }
 
 //This function will look to see if there is a FASTA file (.fa or .fasta) with
@@ -213,40 +216,41 @@ namespace io {
         }
 
 
-        static DeBruijnNode *maybeAddSegment(const std::string &nodeName,
+        static DeBruijnNode *maybeAddSegment(std::string_view nodeName,
                                              double nodeDepth, Sequence sequence,
                                              AssemblyGraph &graph) {
-            auto nodeStorage = graph.m_deBruijnGraphNodes.find(nodeName);
-            // If node already exists it should be a placeholder of zero length
-            if (nodeStorage != graph.m_deBruijnGraphNodes.end()) {
-                DeBruijnNode *placeholder = nodeStorage.value();
-                if (!placeholder->getSequence().empty())
-                    return nullptr;
+            auto [nodeStorage, inserted] =
+                    graph.m_deBruijnGraphNodes.insert_ks(nodeName.data(), nodeName.size(), nullptr);
+            if (inserted)
+                return (nodeStorage.value() = graph.createNode(nodeName, nodeDepth, sequence));
 
-                // Takeover the placeholder
-                placeholder->setDepth(nodeDepth);
-                placeholder->setSequence(sequence);
+            // If node already exists it should be a placeholder of zero length
+            DeBruijnNode *placeholder = nodeStorage.value();
+            if (!placeholder->getSequence().empty())
+                return nullptr;
 
-                return placeholder;
-            }
+            // Takeover the placeholder
+            placeholder->setDepth(nodeDepth);
+            placeholder->setSequence(sequence);
 
-            return (graph.m_deBruijnGraphNodes[nodeName] = new DeBruijnNode(nodeName.c_str(), nodeDepth, sequence));
+            return placeholder;
         }
 
-        static auto
-        addSegmentPair(const std::string &nodeName,
+        auto
+        addSegmentPair(std::string_view nodeName,
                        double nodeDepth, Sequence sequence,
                        AssemblyGraph &graph) {
-            std::string oppositeNodeName = getOppositeNodeName(nodeName);
-
             auto *nodePtr = maybeAddSegment(nodeName, nodeDepth, sequence, graph);
             if (!nodePtr)
-                throw AssemblyGraphError("Duplicate segment named: " + nodeName);
+                throw AssemblyGraphError("Duplicate segment named: " + std::string(nodeName));
 
+            // Reuse the buffer, this is called for every segment and every placeholder
+            oppositeName_.assign(nodeName);
+            oppositeName_.back() = nodeName.back() == '-' ? '+' : '-';
             auto oppositeNodePtr =
-                    maybeAddSegment(getOppositeNodeName(nodeName), nodeDepth, sequence.GetReverseComplement(), graph);
+                    maybeAddSegment(oppositeName_, nodeDepth, sequence.GetReverseComplement(), graph);
             if (!oppositeNodePtr)
-                throw AssemblyGraphError("Duplicate segment named: " + oppositeNodeName);
+                throw AssemblyGraphError("Duplicate segment named: " + oppositeName_);
 
             nodePtr->setReverseComplement(oppositeNodePtr);
             oppositeNodePtr->setReverseComplement(nodePtr);
@@ -255,12 +259,22 @@ namespace io {
         }
 
         // Add placeholder
-        static auto
-        addSegmentPair(const std::string &nodeName,
+        auto
+        addSegmentPair(std::string_view nodeName,
                        AssemblyGraph &graph) {
             return addSegmentPair(nodeName, 0, Sequence(), graph);
         }
 
+        // Appends the orientation sign to the segment name. The buffer is
+        // reused between records, so in the steady state no allocations are
+        // done here.
+        static std::string_view orientedName(std::string &buffer,
+                                             std::string_view name, bool revcomp) {
+            buffer.assign(name);
+            buffer.push_back(revcomp ? '-' : '+');
+            return buffer;
+        }
+
         template<class Container, class Key>
         static void maybeAddTags(Key k, Container &c,
                                  const std::vector<gfa::tag> &tags,
@@ -294,7 +308,7 @@ namespace io {
                            AssemblyGraph &graph) {
             bool sequencesAreMissing = false;
 
-            std::string nodeName{record.name};
+            std::string_view nodeName = record.name;
             const auto &seq = record.seq;
 
             // We check to see if the node ended in a "+" or "-".
@@ -302,7 +316,7 @@ namespace io {
             // And if it doesn't end in a "+" or "-", we assume "+" and add
             // that to the node name.
             if (nodeName.back() != '+' && nodeName.back() != '-')
-                nodeName.push_back('+');
+                nodeName = orientedName(fromName_, nodeName, false);
 
             // GFA can use * to indicate that the sequence is not in the
             // file.  In this case, try to use the LN tag for length.
@@ -338,7 +352,6 @@ namespace io {
                 nodeDepth = double(*fcTag) / double(length);
             }
 
-            // FIXME: get rid of copies and QString's
             auto [nodePtr, oppositeNodePtr] = addSegmentPair(nodeName, nodeDepth, sequence, graph);
 
             auto lb = gfa::getTag<std::string>("LB", record.tags);
@@ -356,9 +369,9 @@ namespace io {
             return sequencesAreMissing;
         }
 
-        static DeBruijnNode *getNode(const std::string &name,
-                                     AssemblyGraph &graph) {
-            auto nodeIt = graph.m_deBruijnGraphNodes.find(name);
+        DeBruijnNode *getNode(std::string_view name,
+                              AssemblyGraph &graph) {
+            auto nodeIt = graph.m_deBruijnGraphNodes.find_ks(name.data(), name.size());
             if (nodeIt != graph.m_deBruijnGraphNodes.end())
                 return *nodeIt;
 
@@ -369,8 +382,8 @@ namespace io {
             return nodePtr;
         }
 
-        auto addLink(const std::string &fromNode,
-                     const std::string &toNode,
+        auto addLink(std::string_view fromNode,
+                     std::string_view toNode,
                      const std::vector<gfa::tag> &tags,
                      AssemblyGraph &graph) {
             // Get source / dest nodes (or create placeholders to fill in)
@@ -383,7 +396,7 @@ namespace io {
             if (graph.m_deBruijnGraphEdges.count({fromNodePtr, toNodePtr}))
                 return std::make_pair(edgePtr, rcEdgePtr);
 
-            edgePtr = new DeBruijnEdge(fromNodePtr, toNodePtr);
+            edgePtr = graph.createEdge(fromNodePtr, toNodePtr);
 
             bool isOwnPair = fromNodePtr == toNodePtr->getReverseComplement() &&
                              toNodePtr == fromNodePtr->getReverseComplement();
@@ -396,7 +409,7 @@ namespace io {
             } else {
                 auto *rcFromNodePtr = fromNodePtr->getReverseComplement();
                 auto *rcToNodePtr = toNodePtr->getReverseComplement();
-                rcEdgePtr = new DeBruijnEdge(rcToNodePtr, rcFromNodePtr);
+                rcEdgePtr = graph.createEdge(rcToNodePtr, rcFromNodePtr);
                 rcFromNodePtr->addEdge(rcEdgePtr);
                 rcToNodePtr->addEdge(rcEdgePtr);
                 edgePtr->setReverseComplement(rcEdgePtr);
@@ -431,10 +444,8 @@ namespace io {
 
         void handleLink(const gfa::link &record,
                         AssemblyGraph &graph) {
-            std::string fromNode{record.lhs};
-            fromNode.push_back(record.lhs_revcomp ? '-' : '+');
-            std::string toNode{record.rhs};
-            toNode.push_back(record.rhs_revcomp ? '-' : '+');
+            auto fromNode = orientedName(fromName_, record.lhs, record.lhs_revcomp);
+            auto toNode = orientedName(toName_, record.rhs, record.rhs_revcomp);
 
             auto [edgePtr, rcEdgePtr] =
                     addLink(fromNode, toNode, record.tags, graph);
@@ -461,10 +472,8 @@ namespace io {
         void handleGapLink(const gfa::gaplink &record,
                            AssemblyGraph &graph) {
             // FIXME: get rid of severe duplication!
-            std::string fromNode{record.lhs};
-            fromNode.push_back(record.lhs_revcomp ? '-' : '+');
-            std::string toNode{record.rhs};
-            toNode.push_back(record.rhs_revcomp ? '-' : '+');
+            auto fromNode = orientedName(fromName_, record.lhs, record.lhs_revcomp);
+            auto toNode = orientedName(toName_, record.rhs, record.rhs_revcomp);
 
             auto [edgePtr, rcEdgePtr] =
                     addLink(fromNode, toNode, record.tags, graph);
@@ -512,17 +521,11 @@ namespace io {
 
             for (const auto &node: record.Walk) {
                 char orientation = node.front();
-                std::string nodeName;
-                nodeName.reserve(node.size());
-                nodeName = node.substr(1);
-                if (orientation == '>')
-                    nodeName.push_back('+');
-                else if (orientation == '<')
-                    nodeName.push_back('-');
-                else
+                if (orientation != '>' && orientation != '<')
                     throw AssemblyGraphError(std::string("invalid walk string: ").append(node));
 
-                walkNodes.push_back(graph.m_deBruijnGraphNodes.at(nodeName));
+                auto nodeName = orientedName(fromName_, node.substr(1), orientation == '<');
+                walkNodes.push_back(graph.m_deBruijnGraphNodes.at_ks(nodeName.data(), nodeName.size()));
             }
 
             Path p(Path::makeFromOrderedNodes(walkNodes, false));
@@ -542,47 +545,345 @@ namespace io {
                                                    std::move(p)});
         }
 
-    public:
-        using AssemblyGraphBuilder::AssemblyGraphBuilder;
+        // Returns true if the record is a segment without sequence
+        bool handleRecord(const gfa::record &record,
+                          AssemblyGraph &graph) {
+            bool sequencesAreMissing = false;
+            std::visit([&](const auto &record) {
+                           using T = std::decay_t<decltype(record)>;
+                           if constexpr (std::is_same_v<T, gfa::segment>) {
+                               sequencesAreMissing = handleSegment(record, graph);
+                           } else if constexpr (std::is_same_v<T, gfa::link>) {
+                               handleLink(record, graph);
+                           } else if constexpr (std::is_same_v<T, gfa::gaplink>) {
+                               handleGapLink(record, graph);
+                           } else if constexpr (std::is_same_v<T, gfa::path>) {
+                               handlePath(record, graph);
+                           } else if constexpr (std::is_same_v<T, gfa::walk>) {
+                               handleWalk(record, graph);
+                           }
+                       },
+                       record);
 
-        bool build(AssemblyGraph &graph) override {
-            graph.m_filename = fileName_;
+            return sequencesAreMissing;
+        }
+
+        // Parallel loading: the input is processed in large batches, every
+        // batch is split into line-aligned chunks which are parsed on worker
+        // threads. Parsed records are then merged into the graph on the calling
+        // thread strictly in file order, so the result is the same as for the
+        // serial load. Merging of one batch overlaps with parsing of the next one.
+        static constexpr size_t BATCH_BYTES_PER_THREAD = 16 << 20;
+        static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+        // Records keep views into the batch data, so the data must outlive
+        // them.
+        struct Chunk {
+            const char *begin;
+            const char *end;
+            std::vector<gfa::record> records;
+        };
+
+        // A batch is either a window into the memory-mapped input or, for
+        // compressed input, a buffer with the decompressed data.
+        struct Batch {
+            std::vector<char> buffer;
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            std::vector<Chunk> chunks;
+        };
+
+        // Calls fn for every non-empty line in [begin, end), the last line
+        // might not be newline-terminated.
+        template<class Fn>
+        static void forEachLine(const char *begin, const char *end, Fn &&fn) {
+            const char *line = begin;
+            while (line < end) {
+                const char *eol = static_cast<const char *>(std::memchr(line, '\n', end - line));
+                if (!eol)
+                    eol = end;
+
+                // skip empty lines
+                if (eol != line)
+                    fn(line, size_t(eol - line));
+
+                if (eol == end)
+                    break;
+                line = eol + 1;
+            }
+        }
+
+        // Mapped input might be processed in two passes: segments first and
+        // then everything else, so links never need placeholders for segments
+        // that are defined later in the file.
+        enum class Pass {
+            All,
+            Segments,
+            Rest
+        };
+
+        static bool inPass(Pass pass, const char *line) {
+            switch (pass) {
+                case Pass::All:
+                    return true;
+                case Pass::Segments:
+                    return line[0] == 'S';
+                case Pass::Rest:
+                    return line[0] != 'S';
+            }
+
+            return true;
+        }
+
+        static void parseChunk(Chunk &chunk, Pass pass) {
+            forEachLine(chunk.begin, chunk.end,
+                        [&](const char *line, size_t len) {
+                            if (!inPass(pass, line))
+                                return;
+                            if (auto result = gfa::parseRecord(line, len))
+                                chunk.records.emplace_back(std::move(*result));
+                        });
+        }
+
+        struct RecordCounts {
+            size_t links = 0;
+            bool linksBeforeSegments = false;
+        };
+
+        // Cheap first pass over the mapped input: counts the records without
+        // parsing them
+        static RecordCounts countRecords(const char *begin, const char *end) {
+            RecordCounts counts;
+            forEachLine(begin, end,
+                        [&](const char *line, size_t) {
+                            if (line[0] == 'S')
+                                counts.linksBeforeSegments |= counts.links > 0;
+                            else if (line[0] == 'L' || line[0] == 'J')
+                                counts.links += 1;
+                        });
+
+            return counts;
+        }
+
+        void splitIntoChunks(Batch &batch) const {
+            size_t chunkSize = std::max<size_t>((batch.end - batch.begin) / (CHUNKS_PER_THREAD * threads_), 1);
+            const char *chunkBegin = batch.begin;
+            while (chunkBegin < batch.end) {
+                const char *chunkEnd = chunkBegin + std::min<size_t>(chunkSize, batch.end - chunkBegin);
+                // Extend the chunk up to the end of the current line
+                const char *eol = static_cast<const char *>(std::memchr(chunkEnd - 1, '\n', batch.end - (chunkEnd - 1)));
+                chunkEnd = eol ? eol + 1 : batch.end;
+                batch.chunks.push_back({chunkBegin, chunkEnd, {}});
+                chunkBegin = chunkEnd;
+            }
+        }
+
+        // Fills the batch with the next portion of the compressed input that
+        // ends on a line boundary. The incomplete trailing line is saved into
+        // carry and is put in front of the next batch. Returns false if the
+        // input is exhausted.
+        bool readBatch(gzFile fp, Batch &batch, std::vector<char> &carry) const {
+            batch.chunks.clear();
+            batch.buffer.swap(carry);
+            carry.clear();
+
+            std::vector<char> &buffer = batch.buffer;
+            size_t filled = buffer.size(), end;
+            bool eof = false;
+            do {
+                buffer.resize(filled + BATCH_BYTES_PER_THREAD * threads_);
+                while (filled < buffer.size()) {
+                    unsigned toRead = unsigned(std::min<size_t>(buffer.size() - filled, 1u << 30));
+                    int read = gzread(fp, buffer.data() + filled, toRead);
+                    if (read < 0)
+                        throw AssemblyGraphError("failed to read file: " + fileName_.toStdString());
+                    if (read == 0) {
+                        eof = true;
+                        break;
+                    }
+                    filled += read;
+                }
+
+                end = filled;
+                if (!eof) {
+                    while (end > 0 && buffer[end - 1] != '\n')
+                        --end;
+                }
+                // Single line that is longer than the whole batch, read more
+            } while (!eof && end == 0);
+
+            carry.assign(buffer.begin() + end, buffer.begin() + filled);
+            buffer.resize(end);
+            if (buffer.empty())
+                return false;
 
+            batch.begin = buffer.data();
+            batch.end = buffer.data() + end;
+            splitIntoChunks(batch);
+
+            return true;
+        }
+
+        // Sets the batch to the next line-aligned window of the mapped input
+        // starting at pos, nothing is copied. Returns false if the input is
+        // exhausted.
+        bool mapBatch(const char *&pos, const char *inputEnd, Batch &batch) const {
+            batch.chunks.clear();
+            if (pos == inputEnd)
+                return false;
+
+            const char *end = pos + std::min<size_t>(BATCH_BYTES_PER_THREAD * threads_, inputEnd - pos);
+            const char *eol = static_cast<const char *>(std::memchr(end - 1, '\n', inputEnd - (end - 1)));
+            end = eol ? eol + 1 : inputEnd;
+
+            batch.begin = pos;
+            batch.end = end;
+            splitIntoChunks(batch);
+            pos = end;
+
+            return true;
+        }
+
+        template<class NextBatch>
+        bool buildParallel(NextBatch nextBatch, AssemblyGraph &graph, Pass pass = Pass::All) {
             bool sequencesAreMissing = false;
 
-            std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
-                    fp(gzopen(fileName_.toStdString().c_str(), "r"), gzclose);
-            if (!fp)
-                throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
+            QThreadPool pool;
+            pool.setMaxThreadCount(int(threads_));
+
+            Batch batches[2];
+            QFuture<void> parsing;
+            auto parse = [pass](Chunk &chunk) { parseChunk(chunk, pass); };
+
+            bool more = nextBatch(batches[0]);
+            if (more)
+                parsing = QtConcurrent::map(&pool, batches[0].chunks, parse);
+
+            for (unsigned current = 0; more; current ^= 1) {
+                parsing.waitForFinished();
+
+                Batch &next = batches[current ^ 1];
+                more = nextBatch(next);
+                if (more)
+                    parsing = QtConcurrent::map(&pool, next.chunks, parse);
+
+                try {
+                    for (const auto &chunk : batches[current].chunks)
+                        for (const auto &record : chunk.records)
+                            sequencesAreMissing |= handleRecord(record, graph);
+                } catch (...) {
+                    // Do not leave workers with dangling batch
+                    parsing.cancel();
+                    parsing.waitForFinished();
+                    throw;
+                }
+            }
+
+            return sequencesAreMissing;
+        }
+
+        bool buildSerial(gzFile fp, AssemblyGraph &graph) {
+            bool sequencesAreMissing = false;
 
-            size_t i = 0;
             char *line = nullptr;
             size_t len = 0;
             ssize_t read;
-            while ((read = gzgetline(&line, &len, fp.get())) != -1) {
-                if (read <= 1)
+            while ((read = gzgetline(&line, &len, fp)) != -1) {
+                // Last line might not be newline-terminated
+                size_t lineLength = read;
+                if (line[lineLength - 1] == '\n')
+                    lineLength -= 1;
+                if (!lineLength)
                     continue; // skip empty lines
 
-                auto result = gfa::parseRecord(line, read - 1);
+                auto result = gfa::parseRecord(line, lineLength);
                 if (!result)
                     continue;
 
-                std::visit([&](const auto &record) {
-                               using T = std::decay_t<decltype(record)>;
-                               if constexpr (std::is_same_v<T, gfa::segment>) {
-                                   sequencesAreMissing |= handleSegment(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::link>) {
-                                   handleLink(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::gaplink>) {
-                                   handleGapLink(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::path>) {
-                                   handlePath(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::walk>) {
-                                   handleWalk(record, graph);
-                               }
-                           },
-                           *result);
+                sequencesAreMissing |= handleRecord(*result, graph);
             }
+            free(line);
+
+            return sequencesAreMissing;
+        }
+
+        bool buildSerial(const char *begin, const char *end, AssemblyGraph &graph,
+                         Pass pass = Pass::All) {
+            bool sequencesAreMissing = false;
+
+            forEachLine(begin, end,
+                        [&](const char *line, size_t len) {
+                            if (!inPass(pass, line))
+                                return;
+                            if (auto result = gfa::parseRecord(line, len))
+                                sequencesAreMissing |= handleRecord(*result, graph);
+                        });
+
+            return sequencesAreMissing;
+        }
+
+        // Uncompressed input is mapped into memory and parsed in place, so
+        // names and sequences are only copied once into the graph. Returns
+        // false if the input is compressed or cannot be mapped.
+        bool buildMapped(AssemblyGraph &graph, bool &sequencesAreMissing) {
+            QFile file(fileName_);
+            if (!file.open(QIODevice::ReadOnly))
+                return false;
+
+            if (file.peek(2) == QByteArray("\x1f\x8b", 2))
+                return false;
+
+            auto *data = reinterpret_cast<const char *>(file.map(0, file.size()));
+            if (!data)
+                return false;
+
+            const char *begin = data, *end = data + file.size();
+            auto build = [&](Pass pass) {
+                if (threads_ == 1)
+                    return buildSerial(begin, end, graph, pass);
+
+                const char *pos = begin;
+                return buildParallel([&](Batch &batch) { return mapBatch(pos, end, batch); }, graph, pass);
+            };
+
+            // Every link (and its reverse complement) is an edge, so the edge
+            // table could be sized up front. The node trie cannot be reserved.
+            RecordCounts counts = countRecords(begin, end);
+            graph.m_deBruijnGraphEdges.reserve(graph.m_deBruijnGraphEdges.size() + 2 * counts.links);
+
+            if (counts.linksBeforeSegments) {
+                sequencesAreMissing = build(Pass::Segments);
+                sequencesAreMissing |= build(Pass::Rest);
+            } else
+                sequencesAreMissing = build(Pass::All);
+
+            return true;
+        }
+
+        bool buildCompressed(AssemblyGraph &graph) {
+            std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                    fp(gzopen(fileName_.toStdString().c_str(), "r"), gzclose);
+            if (!fp)
+                throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
+
+            if (threads_ == 1)
+                return buildSerial(fp.get(), graph);
+
+            std::vector<char> carry;
+            return buildParallel([&](Batch &batch) { return readBatch(fp.get(), batch, carry); }, graph);
+        }
+
+        std::string fromName_, toName_, oppositeName_;
+
+    public:
+        using AssemblyGraphBuilder::AssemblyGraphBuilder;
+
+        bool build(AssemblyGraph &graph) override {
+            graph.m_filename = fileName_;
+
+            bool sequencesAreMissing = false;
+            if (!buildMapped(graph, sequencesAreMissing))
+                sequencesAreMissing = buildCompressed(graph);
 
             graph.m_sequencesLoadedFromFasta = NOT_TRIED;
             if (sequencesAreMissing)
@@ -599,7 +900,7 @@ namespace io {
                 continue;
 
             if (DeBruijnNode *negativeNode =
-                    graph.m_deBruijnGraphNodes[getOppositeNodeName(positiveNode->getName().toStdString())]) {
+                    graph.m_deBruijnGraphNodes[getOppositeNodeName(positiveNode->getNameView())]) {
                 positiveNode->setReverseComplement(negativeNode);
                 negativeNode->setReverseComplement(positiveNode);
             }
@@ -607,12 +908,12 @@ namespace io {
     }
 
     static void makeReverseComplementNodeIfNecessary(AssemblyGraph &graph, DeBruijnNode *node) {
-        auto reverseComplementName = getOppositeNodeName(node->getName().toStdString());
+        auto reverseComplementName = getOppositeNodeName(node->getNameView());
         if (!graph.m_deBruijnGraphNodes.count(reverseComplementName)) {
             Sequence nodeSequence{};
             if (!node->sequenceIsMissing())
                 nodeSequence = node->getSequence();
-            auto newNode = new DeBruijnNode(reverseComplementName.c_str(), node->getDepth(),
+            auto newNode = graph.createNode(reverseComplementName, node->getDepth(),
                                             nodeSequence.GetReverseComplement(),
                                             node->getLength());
             graph.m_deBruijnGraphNodes.emplace(reverseComplementName, newNode);
@@ -704,7 +1005,7 @@ namespace io {
                 if (name.length() < 1)
                     throw "load error";
 
-                auto node = new DeBruijnNode(name, depth, sequence);
+                auto node = graph.createNode(name.toStdString(), depth, sequence);
                 graph.m_deBruijnGraphNodes.emplace(name.toStdString(), node);
                 makeReverseComplementNodeIfNecessary(graph, node);
             }
@@ -722,6 +1023,26 @@ namespace io {
     class FastgAssemblyGraphBuilder : public AssemblyGraphBuilder {
         using AssemblyGraphBuilder::AssemblyGraphBuilder;
 
+        // FASTG spells out both strands. If the opposite node was already
+        // read and its sequence is complementary, store a reverse complement
+        // view of its buffer instead of packing the same bases again.
+        static void setNodeSequence(AssemblyGraph &graph,
+                                    DeBruijnNode *node, const QByteArray &sequenceBytes) {
+            auto oppositeIt = graph.m_deBruijnGraphNodes.find(getOppositeNodeName(node->getNameView()));
+            if (oppositeIt != graph.m_deBruijnGraphNodes.end()) {
+                Sequence rc = (*oppositeIt)->getSequence().GetReverseComplement();
+                bool complementary = rc.size() == size_t(sequenceBytes.size());
+                for (size_t i = 0; complementary && i < rc.size(); ++i)
+                    complementary = rc[i] == nucl(sequenceBytes[qsizetype(i)]);
+                if (complementary && !rc.empty()) {
+                    node->setSequence(rc);
+                    return;
+                }
+            }
+
+            node->setSequence(sequenceBytes);
+        }
+
         bool build(AssemblyGraph &graph) override {
             graph.m_filename = fileName_;
             graph.m_depthTag = "KC";
@@ -743,7 +1064,7 @@ namespace io {
                     //If the line starts with a '>', then we are beginning a new node.
                     if (line.startsWith(">")) {
                         if (node != nullptr) {
-                            node->setSequence(sequenceBytes);
+                            setNodeSequence(graph, node, sequenceBytes);
                             sequenceBytes.clear();
                         }
                         line.remove(0, 1); //Remove '>' from start
@@ -777,7 +1098,7 @@ namespace io {
                         nodeDepth = nodeDepthString.toDouble();
 
                         //Make the node
-                        node = new DeBruijnNode(nodeName, nodeDepth,
+                        node = graph.createNode(nodeName.toStdString(), nodeDepth,
                                                 {}); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
                         graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
 
@@ -817,7 +1138,7 @@ namespace io {
                     }
                 }
                 if (node != nullptr) {
-                    node->setSequence(sequenceBytes);
+                    setNodeSequence(graph, node, sequenceBytes);
                     sequenceBytes.clear();
                 }
 
@@ -828,7 +1149,7 @@ namespace io {
                     std::vector<DeBruijnNode *> nodes;
                     for (const auto &entry: graph.m_deBruijnGraphNodes) {
                         DeBruijnNode *node = entry;
-                        if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
+                        if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getNameView())))
                             nodes.emplace_back(node);
                     }
 
@@ -900,7 +1221,7 @@ namespace io {
                         // ASQG files don't seem to include depth, so just set this to one for every node.
                         double nodeDepth = 1.0;
 
-                        auto node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
+                        auto node = graph.createNode(nodeName.toStdString(), nodeDepth, sequence, length);
                         graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
                     }
                         // Lines beginning with "ED" are edge lines
@@ -967,7 +1288,7 @@ namespace io {
                     std::vector<DeBruijnNode *> nodes;
                     for (const auto &entry: graph.m_deBruijnGraphNodes) {
                         DeBruijnNode *node = entry;
-                        if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
+                        if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getNameView())))
                             nodes.emplace_back(node);
                     }
 
@@ -1081,7 +1402,7 @@ namespace io {
 
                         Sequence nodeSequence = sequence.Subseq(nodeRangeStart, nodeRangeEnd + 1);
 
-                        auto node = new DeBruijnNode(nodeName, 1.0, nodeSequence);
+                        auto node = graph.createNode(nodeName.toStdString(), 1.0, nodeSequence);
                         graph.m_deBruijnGraphNodes.emplace(nodeName.toStdString(), node);
                     }
 
@@ -1100,7 +1421,7 @@ namespace io {
                 std::vector<DeBruijnNode *> nodes;
                 for (const auto &entry: graph.m_deBruijnGraphNodes) {
                     DeBruijnNode *node = entry;
-                    if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getName().toStdString())))
+                    if (!graph.m_deBruijnGraphNodes.count(getOppositeNodeName(node->getNameView())))
                         nodes.emplace_back(node);
                 }
 
@@ -86,7 +86,7 @@ bool DeBruijnEdge::isPositiveEdge() const
     //negative.  In this case, just choose the one with the first name
     //alphabetically - an arbitrary choice, but at least it is
     //consistent.
-    return (m_startingNode->getName() > m_reverseComplement->m_startingNode->getName());
+    return (m_startingNode->getNameView() > m_reverseComplement->m_startingNode->getNameView());
 }
 
 
@@ -325,28 +325,15 @@ bool DeBruijnEdge::testExactOverlap(int overlap) const
 
 
 bool DeBruijnEdge::compareEdgePointers(const DeBruijnEdge * a, const DeBruijnEdge * b) {
-    QString aStart = a->getStartingNode()->getName();
-    QString bStart = b->getStartingNode()->getName();
-    QString aStartNoSign = aStart;
-    aStartNoSign.chop(1);
-    QString bStartNoSign = bStart;
-    bStartNoSign.chop(1);
-    bool ok1;
-    long long aStartNumber = aStartNoSign.toLongLong(&ok1);
-    bool ok2;
-    long long bStartNumber = bStartNoSign.toLongLong(&ok2);
-
-    QString aEnd = a->getEndingNode()->getName();
-    QString bEnd = b->getEndingNode()->getName();
-    QString aEndNoSign = aEnd;
-    aEndNoSign.chop(1);
-    QString bEndNoSign = bEnd;
-    bEndNoSign.chop(1);
-    bool ok3;
-    long long aEndNumber = aEndNoSign.toLongLong(&ok3);
-    bool ok4;
-    long long bEndNumber = bEndNoSign.toLongLong(&ok4);
-
+    std::string_view aStart = a->getStartingNode()->getNameView();
+    std::string_view bStart = b->getStartingNode()->getNameView();
+    long long aStartNumber, bStartNumber;
+    bool ok1 = a->getStartingNode()->getNameNumber(aStartNumber);
+    bool ok2 = b->getStartingNode()->getNameNumber(bStartNumber);
+
+    long long aEndNumber, bEndNumber;
+    bool ok3 = a->getEndingNode()->getNameNumber(aEndNumber);
+    bool ok4 = b->getEndingNode()->getNameNumber(bEndNumber);
 
     //If the node names are essentially numbers, then sort them as numbers.
     if (ok1 && ok2 && ok3 && ok4)
@@ -25,18 +25,18 @@
 
 #include <thirdparty/seq/aa.hpp>
 
+#include <charconv>
 #include <cmath>
 
 #include <set>
 #include <string>
-#include <unordered_set>
 #include <QApplication>
 #include <QSet>
 
 //The length parameter is optional.  If it is set, then the node will use that
 //for its length.  If not set, it will just use the sequence length.
-DeBruijnNode::DeBruijnNode(QString name, float depth, const Sequence& sequence, unsigned length)
-        : m_name(std::move(name)),
+DeBruijnNode::DeBruijnNode(std::string_view name, float depth, const Sequence& sequence, unsigned length)
+        : m_name(name),
           m_depth(depth),
           m_sequence(sequence),
           m_reverseComplement(nullptr),
@@ -162,12 +162,24 @@ unsigned DeBruijnNode::getLengthWithoutTrailingOverlap() const {
 }
 
 
+bool DeBruijnNode::getNameNumber(long long &number) const
+{
+    if (m_name.empty())
+        return false;
+
+    const char *begin = m_name.data(), *end = m_name.data() + m_name.size() - 1;
+    auto [ptr, ec] = std::from_chars(begin, end, number);
+    return ec == std::errc() && ptr == end && begin != end;
+}
+
+
 QByteArray DeBruijnNode::getNodeNameForFasta(bool sign) const
 {
     QByteArray nodeNameForFasta;
 
     nodeNameForFasta += "NODE_";
-    nodeNameForFasta += sign ? qPrintable(getName()) : qPrintable(getNameWithoutSign());
+    std::string_view name = sign ? m_name : m_name.substr(0, m_name.size() - 1);
+    nodeNameForFasta.append(name.data(), qsizetype(name.size()));
 
     nodeNameForFasta += "_length_";
     nodeNameForFasta += QByteArray::number(getLength());
@@ -178,44 +190,15 @@ QByteArray DeBruijnNode::getNodeNameForFasta(bool sign) const
 }
 
 
-// This function recursively labels all nodes as drawn that are within a
-// certain distance of this node.  Whichever node called this will
-// definitely be drawn, so that one is excluded from the recursive call.
-// FIXME: this function does not belong here
-void DeBruijnNode::labelNeighbouringNodesAsDrawn(int nodeDistance) {
-    std::unordered_set<DeBruijnNode*> worklist, seen;
-    worklist.insert(this);
-    for (int depth = 0; depth <= nodeDistance; depth++) {
-        for (auto *node : worklist) {
-            auto *nodeToMark =
-                        g_settings->doubleMode ? node : node->getCanonical();
-            nodeToMark->m_drawn = true;
-
-            for (auto *m_edge : node->m_edges) {
-                DeBruijnNode * otherNode = m_edge->getOtherNode(node);
-                if (!otherNode->thisNodeOrReverseComplementIsDrawn())
-                    seen.insert(otherNode);
-            }
-        }
-
-        if (seen.empty())
-            break;
-        worklist.clear();
-        worklist.swap(seen);
-    }
-}
-
 bool DeBruijnNode::isPositiveNode() const
 {
-    QChar lastChar = m_name.at(m_name.length() - 1);
-    return lastChar == '+';
+    return m_name.back() == '+';
 }
 
 
 bool DeBruijnNode::isNegativeNode() const
 {
-    QChar lastChar = m_name.at(m_name.length() - 1);
-    return lastChar == '-';
+    return m_name.back() == '-';
 }
 
 
@@ -356,23 +339,6 @@ int DeBruijnNode::getDeadEndCount() const
 
 
 
-//This function returns all of the positive nodes that this node (or its
-//reverse complement) are connected to.
-std::vector<DeBruijnNode *> DeBruijnNode::getAllConnectedPositiveNodes() const
-{
-    std::unordered_set<DeBruijnNode *> connectedPositiveNodesSet;
-
-    for (auto *edge : m_edges) {
-        DeBruijnNode * connectedNode = edge->getOtherNode(this);
-        if (connectedNode->isNegativeNode())
-            connectedNode = connectedNode->getReverseComplement();
-
-        connectedPositiveNodesSet.insert(connectedNode);
-    }
-
-    return { connectedPositiveNodesSet.begin(), connectedPositiveNodesSet.end() };
-}
-
 float DeBruijnNode::getGC() const {
     size_t gc = 0;
     for (size_t i = 0; i < m_sequence.size(); ++i) {
@@ -23,6 +23,7 @@
 
 #include <QColor>
 #include <QByteArray>
+#include <string_view>
 #include <vector>
 
 class DeBruijnEdge;
@@ -32,13 +33,21 @@ class DeBruijnNode
 {
 public:
     //CREATORS
-    DeBruijnNode(QString name, float depth, const Sequence &sequence, unsigned length = 0);
+    //The name is not copied, it must outlive the node (normally it is kept in
+    //the name pool of the owning graph, see AssemblyGraph::createNode).
+    DeBruijnNode(std::string_view name, float depth, const Sequence &sequence, unsigned length = 0);
     ~DeBruijnNode() = default;
 
     //ACCESSORS
-    QString getName() const {return m_name;}
-    QString getNameWithoutSign() const {return m_name.left(m_name.length() - 1);}
-    QString getSign() const {if (m_name.length() > 0) return m_name.right(1); else return "+";}
+    //getName and getNameWithoutSign allocate a new string on every call, they
+    //are meant for the UI. Use getNameView or getNameNumber elsewhere.
+    QString getName() const {return QString::fromUtf8(m_name.data(), qsizetype(m_name.size()));}
+    QString getNameWithoutSign() const {return QString::fromUtf8(m_name.data(), qsizetype(m_name.size()) - 1);}
+    QString getSign() const {if (!m_name.empty()) return QString(QChar(m_name.back())); else return "+";}
+    std::string_view getNameView() const {return m_name;}
+    //Parses the name without the sign as a number, for the names which are
+    //numbers.
+    bool getNameNumber(long long &number) const;
 
     double getDepth() const {return m_depth;}
 
@@ -71,7 +80,6 @@ public:
     std::vector<DeBruijnEdge *> getLeavingEdges() const;
     std::vector<DeBruijnNode *> getDownstreamNodes() const;
     std::vector<DeBruijnNode *> getUpstreamNodes() const;
-    std::vector<DeBruijnNode *> getAllConnectedPositiveNodes() const;
     bool isSpecialNode() const {return m_specialNode;}
     bool isDrawn() const {return m_drawn;}
     bool thisNodeOrReverseComplementIsDrawn() const {return isDrawn() || getReverseComplement()->isDrawn();}
@@ -98,12 +106,11 @@ public:
     void resetNode();
     void addEdge(DeBruijnEdge * edge);
     void removeEdge(DeBruijnEdge * edge);
-    void labelNeighbouringNodesAsDrawn(int nodeDistance);
     void setDepth(double newDepth) {m_depth = newDepth;}
-    void setName(QString newName) {m_name = std::move(newName);}
+    void setName(std::string_view newName) {m_name = newName;}
 
 private:
-    QString m_name;
+    std::string_view m_name;
     Sequence m_sequence;
     DeBruijnNode * m_reverseComplement;
     adt::SmallPODVector<DeBruijnEdge *> m_edges;
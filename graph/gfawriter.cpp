@@ -20,124 +20,118 @@
 #include "assemblygraph.h"
 #include "debruijnedge.h"
 #include "path.h"
-#include "sequenceutils.h"
 #include "program/colormap.h"
 
-#include <QFile>
-#include <QTextStream>
+#include <algorithm>
+#include <string_view>
 
 namespace gfa {
-    static void printTags(QByteArray &out, const std::vector<gfa::tag> &tags) {
+    static void printTags(io::BufferedWriter &out, const std::vector<gfa::tag> &tags) {
         for (const auto &tag: tags) {
-            out += '\t';
-            out += tag.name[0];
-            out += tag.name[1];
-            out += ":";
-            out += tag.type;
-            out += ":";
+            out << '\t' << tag.name[0] << tag.name[1] << ':' << tag.type << ':';
             std::visit([&](const auto &val) {
                 using T = std::decay_t<decltype(val)>;
-                if constexpr (std::is_same_v<T, int64_t>) {
-                    out += qPrintable(QString::number(val));
-                } else if constexpr (std::is_same_v<T, float>) {
-                    out += qPrintable(QString::number(val));
+                if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, float>) {
+                    out << val;
                 } else if constexpr (std::is_same_v<T, std::string>) {
-                    out += val;
+                    out << std::string_view(val);
                 }
             }, tag.val);
         }
     }
 
-    // This function gets the node's sequence for a GFA file.
-    // If the sequence is missing, it will just give "*"
-    QByteArray getSequenceForGfa(const DeBruijnNode *node) {
-        if (node->sequenceIsMissing())
-            return {"*"};
+    static std::string_view nameWithoutSign(const DeBruijnNode *node) {
+        std::string_view name = node->getNameView();
+        name.remove_suffix(1);
+        return name;
+    }
 
-        return utils::sequenceToQByteArray(node->getSequence());
+    // Decodes the sequence straight into the output buffer. Large sequences
+    // are done in pieces, so no temporary copy of them is ever made.
+    static void printSequence(io::BufferedWriter &out, const Sequence &sequence) {
+        constexpr size_t CHUNK_SIZE = 1 << 16;
+        for (size_t pos = 0; pos < sequence.size(); pos += CHUNK_SIZE) {
+            size_t size = std::min(CHUNK_SIZE, sequence.size() - pos);
+            sequence.Subseq(pos, pos + size).CopyNucls(out.reserve(size));
+            out.commit(size);
+        }
     }
 
-    static QByteArray getGfaSegmentLine(const DeBruijnNode *node, const AssemblyGraph &graph,
-                                        const QString &depthTag) {
-        QByteArray gfaSequence = getSequenceForGfa(node);
+    static void printSegmentLine(io::BufferedWriter &out,
+                                 const DeBruijnNode *node, const AssemblyGraph &graph,
+                                 const QByteArray &depthTag) {
+        out << "S\t" << nameWithoutSign(node) << '\t';
+
+        // If the sequence is missing, it will just give "*"
+        if (node->sequenceIsMissing())
+            out << '*';
+        else
+            printSequence(out, node->getSequence());
 
-        QByteArray gfaSegmentLine = "S";
-        gfaSegmentLine += "\t" + node->getNameWithoutSign().toLatin1();
-        gfaSegmentLine += "\t" + gfaSequence;
-        gfaSegmentLine += "\tLN:i:" + QString::number(gfaSequence.length()).toLatin1();
+        unsigned length = node->getLength();
+        out << "\tLN:i:" << length;
 
         //We use the depthTag to guide how we save the node depth.
         //If it is empty, that implies that the loaded graph did not have depth
         //information and so we don't save depth.
         if (depthTag == "DP" || depthTag == "dp")
-            gfaSegmentLine += "\tDP:f:" + QString::number(node->getDepth()).toLatin1();
+            out << "\tDP:f:" << node->getDepth();
         else if (depthTag == "KC" || depthTag == "RC" || depthTag == "FC")
-            gfaSegmentLine += "\t" + depthTag.toLatin1() + ":i:" +
-                              QString::number(int(node->getDepth() * gfaSequence.length() + 0.5)).toLatin1();
+            out << '\t' << depthTag << ":i:" << int(node->getDepth() * length + 0.5);
 
         //If the user has included custom labels or colours, include those.
         QString label = graph.getCustomLabel(node);
         if (!label.isEmpty())
-            gfaSegmentLine += "\tLB:Z:" + label.toLatin1();
+            out << "\tLB:Z:" << label.toUtf8();
 
         QString rcLabel = graph.getCustomLabel(node->getReverseComplement());
         if (!rcLabel.isEmpty())
-            gfaSegmentLine += "\tL2:Z:" + rcLabel.toLatin1();
+            out << "\tL2:Z:" << rcLabel.toUtf8();
         if (graph.hasCustomColour(node))
-            gfaSegmentLine += "\tCL:Z:" + getColourName(graph.getCustomColour(node)).toLatin1();
+            out << "\tCL:Z:" << getColourName(graph.getCustomColour(node)).toLatin1();
         if (graph.hasCustomColour(node->getReverseComplement()))
-            gfaSegmentLine += "\tC2:Z:" + getColourName(graph.getCustomColour(node->getReverseComplement())).toLatin1();
+            out << "\tC2:Z:" << getColourName(graph.getCustomColour(node->getReverseComplement())).toLatin1();
 
         auto tagIt = graph.m_nodeTags.find(node);
         if (tagIt != graph.m_nodeTags.end())
-            printTags(gfaSegmentLine, tagIt->second);
+            printTags(out, tagIt->second);
 
-        return gfaSegmentLine;
+        out << '\n';
     }
 
-    static QByteArray getGfaLinkLine(const DeBruijnEdge *edge, const AssemblyGraph &graph) {
+    static void printLinkLine(io::BufferedWriter &out,
+                              const DeBruijnEdge *edge, const AssemblyGraph &graph) {
         const DeBruijnNode *startingNode = edge->getStartingNode();
         const DeBruijnNode *endingNode = edge->getEndingNode();
         bool isJump = edge->getOverlapType() == JUMP;
 
-        QByteArray gfaLinkLine = isJump ? "J\t" : "L\t";
-        gfaLinkLine += qPrintable(startingNode->getNameWithoutSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(startingNode->getSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(endingNode->getNameWithoutSign());
-        gfaLinkLine += '\t';
-        gfaLinkLine += qPrintable(endingNode->getSign());
-        gfaLinkLine += '\t';
+        out << (isJump ? "J\t" : "L\t")
+            << nameWithoutSign(startingNode) << '\t' << startingNode->getNameView().back() << '\t'
+            << nameWithoutSign(endingNode) << '\t' << endingNode->getNameView().back() << '\t';
         // Emit overlap for normal links and distance for jump links
         if (isJump) {
-            gfaLinkLine += edge->getOverlap() == 0 ? "*" : qPrintable(QString::number(edge->getOverlap()));
-        } else {
-            gfaLinkLine += qPrintable(QString::number(edge->getOverlap()));
-            gfaLinkLine += "M";
-        }
-
-        if (graph.hasCustomColour(edge)) {
-            gfaLinkLine += "\tCL:Z:";
-            gfaLinkLine += qPrintable(getColourName(graph.getCustomColour(edge)));
-        }
-        if (!edge->isOwnReverseComplement() && graph.hasCustomColour(edge->getReverseComplement())) {
-            gfaLinkLine += "\tC2:Z:";
-            gfaLinkLine += qPrintable(getColourName(graph.getCustomColour(edge->getReverseComplement())));
-        }
+            if (edge->getOverlap() == 0)
+                out << '*';
+            else
+                out << edge->getOverlap();
+        } else
+            out << edge->getOverlap() << 'M';
+
+        if (graph.hasCustomColour(edge))
+            out << "\tCL:Z:" << getColourName(graph.getCustomColour(edge)).toLatin1();
+        if (!edge->isOwnReverseComplement() && graph.hasCustomColour(edge->getReverseComplement()))
+            out << "\tC2:Z:" << getColourName(graph.getCustomColour(edge->getReverseComplement())).toLatin1();
 
         auto tagIt = graph.m_edgeTags.find(edge);
         if (tagIt != graph.m_edgeTags.end())
-            printTags(gfaLinkLine, tagIt->second);
+            printTags(out, tagIt->second);
 
-        return gfaLinkLine;
+        out << '\n';
     }
 
-    static QByteArray getGfaPathLine(const std::string &name, const Path &path,
-                                     const AssemblyGraph &graph) {
-        QByteArray gfaPathLine = "P\t";
-        gfaPathLine += name;
-        gfaPathLine += '\t';
+    static void printPathLine(io::BufferedWriter &out,
+                              const std::string &name, const Path &path) {
+        out << "P\t" << std::string_view(name) << '\t';
 
         const auto &nodes = path.nodes();
         const auto &edges = path.edges();
@@ -146,79 +140,61 @@ namespace gfa {
         // same length for circular paths
         for (size_t i = 0; i < edges.size(); ++i) {
             const auto *edge = edges[i];
-            gfaPathLine += qPrintable(nodes[i]->getName());
-            gfaPathLine += edge->getOverlapType() == JUMP ? ';' : ',';
+            out << nodes[i]->getNameView() << (edge->getOverlapType() == JUMP ? ';' : ',');
         }
         // Handle last node: for circular paths we're adding extra node here
         if (nodes.size() == edges.size()) { // circular path
-            gfaPathLine += qPrintable(nodes.front()->getName());
+            out << nodes.front()->getNameView();
         } else {
-            gfaPathLine += qPrintable(nodes.back()->getName());
+            out << nodes.back()->getNameView();
         }
 
-        return gfaPathLine;
+        out << '\n';
     }
 
-    bool saveEntireGraph(const QString &filename,
-                         const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    template<class NodeFilter>
+    static bool saveGraph(const QString &filename, const AssemblyGraph &graph,
+                          io::Compression compression, NodeFilter includeNode) {
+        io::BufferedWriter out;
+        if (!out.open(filename, compression))
             return false;
 
-        QTextStream out(&file);
-
+        QByteArray depthTag = graph.m_depthTag.toLatin1();
         for (const auto *node: graph.m_deBruijnGraphNodes) {
-            if (node->isPositiveNode())
-                out << getGfaSegmentLine(node, graph, graph.m_depthTag) << '\n';
+            if (node->isPositiveNode() && includeNode(node))
+                printSegmentLine(out, node, graph, depthTag);
         }
 
-        QList<const DeBruijnEdge *> edgesToSave;
+        std::vector<const DeBruijnEdge *> edgesToSave;
         for (auto &entry: graph.m_deBruijnGraphEdges) {
             const DeBruijnEdge *edge = entry.second;
-            if (edge->isPositiveEdge())
+            if (edge->isPositiveEdge() &&
+                includeNode(edge->getStartingNode()) && includeNode(edge->getEndingNode()))
                 edgesToSave.push_back(edge);
         }
 
         std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
 
         for (const auto *edge: edgesToSave)
-            out << getGfaLinkLine(edge, graph) << '\n';
+            printLinkLine(out, edge, graph);
 
         for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
-            out << getGfaPathLine(it.key(), *it, graph) << '\n';
+            printPathLine(out, it.key(), *it);
 
-        return true;
+        return out.close();
     }
 
-    bool saveVisibleGraph(const QString &filename, const AssemblyGraph &graph) {
-        QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-            return false;
-
-        QTextStream out(&file);
-
-        for (const auto *node: graph.m_deBruijnGraphNodes) {
-            if (node->thisNodeOrReverseComplementIsDrawn() && node->isPositiveNode())
-                out << getGfaSegmentLine(node, graph, graph.m_depthTag) << '\n';
-        }
-
-        QList<const DeBruijnEdge *> edgesToSave;
-        for (auto &entry: graph.m_deBruijnGraphEdges) {
-            const DeBruijnEdge *edge = entry.second;
-            if (edge->getStartingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->getEndingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->isPositiveEdge())
-                edgesToSave.push_back(edge);
-        }
-
-        std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
-
-        for (const auto *node: edgesToSave)
-            out << getGfaLinkLine(node, graph) << '\n';
-
-        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
-            out << getGfaPathLine(it.key(), *it, graph) << '\n';
+    bool saveEntireGraph(const QString &filename,
+                         const AssemblyGraph &graph,
+                         io::Compression compression) {
+        return saveGraph(filename, graph, compression,
+                         [](const DeBruijnNode *) { return true; });
+    }
 
-        return true;
+    bool saveVisibleGraph(const QString &filename,
+                          const AssemblyGraph &graph,
+                          io::Compression compression) {
+        return saveGraph(filename, graph, compression,
+                         [](const DeBruijnNode *node) { return node->thisNodeOrReverseComplementIsDrawn(); });
     }
 }
@@ -17,13 +17,18 @@
 
 #pragma once
 
+#include "io/bufferedwriter.h"
+
 #include <QString>
 
 class AssemblyGraph;
 
 namespace gfa {
+    // By default the output is gzip-compressed if the filename ends with .gz
     bool saveEntireGraph(const QString &filename,
-                         const AssemblyGraph &graph);
+                         const AssemblyGraph &graph,
+                         io::Compression compression = io::Compression::Auto);
     bool saveVisibleGraph(const QString &filename,
-                          const AssemblyGraph &graph);
+                          const AssemblyGraph &graph,
+                          io::Compression compression = io::Compression::Auto);
 }
\ No newline at end of file
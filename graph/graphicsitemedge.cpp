@@ -29,6 +29,13 @@
 #include <QPainter>
 #include <QPen>
 #include <QLineF>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+
+// Edges smaller than that many pixels on screen are drawn as straight lines,
+// the curvature would not be visible anyway
+static constexpr double LOD_EDGE_EXTENT = 10.0;
 
 GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent)
     : QGraphicsPathItem(parent), m_deBruijnEdge(deBruijnEdge) {
@@ -40,11 +47,31 @@ GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem *
     remakePath();
 }
 
-void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) {
-    QColor penColour = isSelected() ? g_settings->selectionColour : m_edgeColor;
-    QPen edgePen(QBrush(penColour), m_width, m_penStyle, Qt::RoundCap);
+// Simplified only in the view, see GraphicsItemNode::paint
+void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *widget) {
+    draw(painter, path(),
+         isSelected() ? g_settings->selectionColour : m_edgeColor, m_penStyle, m_width,
+         widget != nullptr && painter->device() == widget && g_settings->levelOfDetail);
+}
+
+void GraphicsItemEdge::draw(QPainter * painter, const QPainterPath &edgePath,
+                            const QColor &colour, Qt::PenStyle penStyle, float width,
+                            bool levelOfDetail) {
+    if (levelOfDetail) {
+        double scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+        QRectF bounds = edgePath.boundingRect();
+        if (std::max(bounds.width(), bounds.height()) * scale < LOD_EDGE_EXTENT) {
+            // Zero width is a cosmetic pen, one pixel wide regardless of the zoom
+            painter->setPen(QPen(QBrush(colour), width * scale < 1.0 ? 0.0 : width,
+                                 penStyle, Qt::RoundCap));
+            painter->drawLine(edgePath.elementAt(0), edgePath.currentPosition());
+            return;
+        }
+    }
+
+    QPen edgePen(QBrush(colour), width, penStyle, Qt::RoundCap);
     painter->setPen(edgePen);
-    painter->drawPath(path());
+    painter->drawPath(edgePath);
 }
 
 QPainterPath GraphicsItemEdge::shape() const {
@@ -56,25 +83,26 @@ QPainterPath GraphicsItemEdge::shape() const {
 }
 
 static void getControlPointLocations(const DeBruijnEdge *edge,
+                                     const GraphicsItemEdge::NodeDrawingLookup &drawingOf,
                                      QPointF &startLocation, QPointF &beforeStartLocation,
                                      QPointF &endLocation, QPointF &afterEndLocation) {
     DeBruijnNode * startingNode = edge->getStartingNode();
     DeBruijnNode * endingNode = edge->getEndingNode();
 
-    if (startingNode->hasGraphicsItem()) {
-        startLocation = startingNode->getGraphicsItemNode()->getLast();
-        beforeStartLocation = startingNode->getGraphicsItemNode()->getSecondLast();
-    } else if (startingNode->getReverseComplement()->hasGraphicsItem()) {
-        startLocation = startingNode->getReverseComplement()->getGraphicsItemNode()->getFirst();
-        beforeStartLocation = startingNode->getReverseComplement()->getGraphicsItemNode()->getSecond();
+    if (const NodeDrawing *drawing = drawingOf(startingNode)) {
+        startLocation = drawing->getLast();
+        beforeStartLocation = drawing->getSecondLast();
+    } else if (const NodeDrawing *rcDrawing = drawingOf(startingNode->getReverseComplement())) {
+        startLocation = rcDrawing->getFirst();
+        beforeStartLocation = rcDrawing->getSecond();
     }
 
-    if (endingNode->hasGraphicsItem()) {
-        endLocation = endingNode->getGraphicsItemNode()->getFirst();
-        afterEndLocation = endingNode->getGraphicsItemNode()->getSecond();
-    } else if (endingNode->getReverseComplement()->hasGraphicsItem()) {
-        endLocation = endingNode->getReverseComplement()->getGraphicsItemNode()->getLast();
-        afterEndLocation = endingNode->getReverseComplement()->getGraphicsItemNode()->getSecondLast();
+    if (const NodeDrawing *drawing = drawingOf(endingNode)) {
+        endLocation = drawing->getFirst();
+        afterEndLocation = drawing->getSecond();
+    } else if (const NodeDrawing *rcDrawing = drawingOf(endingNode->getReverseComplement())) {
+        endLocation = rcDrawing->getLast();
+        afterEndLocation = rcDrawing->getSecondLast();
     }
 }
 
@@ -147,8 +175,15 @@ static void makeOrdinaryPath(QPainterPath &path,
 
 
 void GraphicsItemEdge::remakePath() {
+    setPath(makePath(m_deBruijnEdge,
+                     [](const DeBruijnNode *node) -> const NodeDrawing * {
+                         return node->getGraphicsItemNode();
+                     }));
+}
+
+QPainterPath GraphicsItemEdge::makePath(const DeBruijnEdge *edge, const NodeDrawingLookup &drawingOf) {
     QPointF startLocation, beforeStartLocation, endLocation, afterEndLocation;
-    getControlPointLocations(m_deBruijnEdge,
+    getControlPointLocations(edge, drawingOf,
                              startLocation, beforeStartLocation,
                              endLocation, afterEndLocation);
 
@@ -158,13 +193,13 @@ void GraphicsItemEdge::remakePath() {
     // is made of only one line segment, then a special path is
     // required, otherwise the edge will be mostly hidden underneath
     // the node.
-    DeBruijnNode *startingNode = m_deBruijnEdge->getStartingNode();
-    DeBruijnNode *endingNode = m_deBruijnEdge->getEndingNode();
+    DeBruijnNode *startingNode = edge->getStartingNode();
+    DeBruijnNode *endingNode = edge->getEndingNode();
     if (startingNode == endingNode) {
-        GraphicsItemNode * graphicsItemNode = startingNode->getGraphicsItemNode();
-        if (!graphicsItemNode)
-            graphicsItemNode = startingNode->getReverseComplement()->getGraphicsItemNode();
-        if (graphicsItemNode && graphicsItemNode->m_linePoints.size() == 2)
+        const NodeDrawing * nodeDrawing = drawingOf(startingNode);
+        if (!nodeDrawing)
+            nodeDrawing = drawingOf(startingNode->getReverseComplement());
+        if (nodeDrawing && nodeDrawing->m_linePoints.size() == 2)
             makeSpecialPathConnectingNodeToSelf(path,
                                                 startLocation, beforeStartLocation,
                                                 endLocation, afterEndLocation);
@@ -182,5 +217,5 @@ void GraphicsItemEdge::remakePath() {
         makeOrdinaryPath(path, startLocation, beforeStartLocation,
                          endLocation, afterEndLocation);
 
-    setPath(path);
+    return path;
 }
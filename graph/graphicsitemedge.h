@@ -23,7 +23,11 @@
 #include <QPainterPath>
 #include <QPointF>
 
+#include <functional>
+
 class DeBruijnEdge;
+class DeBruijnNode;
+class NodeDrawing;
 
 class GraphicsItemEdge : public QGraphicsPathItem {
 public:
@@ -34,6 +38,16 @@ public:
 
     void remakePath();
     DeBruijnEdge *edge() const { return m_deBruijnEdge; }
+
+    // Returns the drawing of a node or nullptr if the node is not drawn
+    using NodeDrawingLookup = std::function<const NodeDrawing *(const DeBruijnNode *)>;
+
+    // Builds the path of the edge between the given node drawings. Shared
+    // with the command line renderer, which has no graphics items.
+    static QPainterPath makePath(const DeBruijnEdge *edge, const NodeDrawingLookup &drawingOf);
+    static void draw(QPainter * painter, const QPainterPath &edgePath,
+                     const QColor &colour, Qt::PenStyle penStyle, float width,
+                     bool levelOfDetail = false);
 private:
     DeBruijnEdge *m_deBruijnEdge;
     QColor m_edgeColor;
@@ -0,0 +1,331 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphstatistics.h"
+
+#include "adjacency.h"
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace graph;
+
+namespace {
+    // Number of complementary pairs processed by a single task
+    constexpr size_t BLOCK_SIZE = 16384;
+
+    struct Block {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // Runs fn(Block, blockIndex) over [0, count) split into blocks
+    template<class Fn>
+    void parallelFor(uint32_t count, unsigned threads, Fn fn) {
+        std::vector<std::pair<Block, size_t>> blocks;
+        for (uint32_t begin = 0; begin < count; begin += BLOCK_SIZE)
+            blocks.push_back({ { begin, uint32_t(std::min<size_t>(size_t(begin) + BLOCK_SIZE, count)) },
+                               blocks.size() });
+
+        if (threads <= 1 || blocks.size() <= 1) {
+            for (const auto &block : blocks)
+                fn(block.first, block.second);
+            return;
+        }
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(threads));
+        QtConcurrent::blockingMap(&pool, blocks,
+                                  [&](const std::pair<Block, size_t> &block) { fn(block.first, block.second); });
+    }
+
+    size_t blockCount(uint32_t count) {
+        return (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    // Partial results of the fused pass, one per block
+    struct Partial {
+        int nodeCount = 0;
+        int edgeCount = 0;
+        int smallestOverlap = std::numeric_limits<int>::max();
+        int largestOverlap = 0;
+        long long totalLength = 0;
+        long long totalLengthNoOverlaps = 0;
+        long long totalLengthOrphanedNodes = 0;
+        unsigned deadEnds = 0;
+
+        void merge(const Partial &other) {
+            nodeCount += other.nodeCount;
+            edgeCount += other.edgeCount;
+            smallestOverlap = std::min(smallestOverlap, other.smallestOverlap);
+            largestOverlap = std::max(largestOverlap, other.largestOverlap);
+            totalLength += other.totalLength;
+            totalLengthNoOverlaps += other.totalLengthNoOverlaps;
+            totalLengthOrphanedNodes += other.totalLengthOrphanedNodes;
+            deadEnds += other.deadEnds;
+        }
+    };
+
+    // Union-find over complementary pairs that could be updated from several
+    // threads at once. Roots are only changed by a successful CAS from the
+    // root to its new parent, the larger root is always linked to the
+    // smaller one.
+    class ConcurrentUnionFind {
+    public:
+        explicit ConcurrentUnionFind(uint32_t size)
+                : m_parent(size) {
+            for (uint32_t i = 0; i < size; ++i)
+                m_parent[i].store(i, std::memory_order_relaxed);
+        }
+
+        uint32_t find(uint32_t x) {
+            while (true) {
+                uint32_t parent = m_parent[x].load(std::memory_order_relaxed);
+                if (parent == x)
+                    return x;
+
+                // Path halving
+                uint32_t grandparent = m_parent[parent].load(std::memory_order_relaxed);
+                if (parent != grandparent)
+                    m_parent[x].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                x = grandparent;
+            }
+        }
+
+        void unite(uint32_t a, uint32_t b) {
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b)
+                    return;
+                if (a < b)
+                    std::swap(a, b);
+
+                uint32_t expected = a;
+                if (m_parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                    return;
+            }
+        }
+
+    private:
+        std::vector<std::atomic<uint32_t>> m_parent;
+    };
+
+    // Returns the value of the item covering the given base index, when items
+    // are ordered by their values using comp and every item spans as many bases
+    // as its weight. Weighted quickselect, items are reordered.
+    template<class Comp>
+    double valueAtBaseIndex(std::vector<std::pair<double, long long>> &items, long long index, Comp comp) {
+        auto lo = items.begin(), hi = items.end();
+        while (lo != hi) {
+            auto mid = lo + (hi - lo) / 2;
+            std::nth_element(lo, mid, hi,
+                             [&](const auto &a, const auto &b) { return comp(a.first, b.first); });
+
+            long long before = 0;
+            for (auto it = lo; it != mid; ++it)
+                before += it->second;
+
+            if (index < before)
+                hi = mid;
+            else if (index < before + mid->second)
+                return mid->first;
+            else {
+                index -= before + mid->second;
+                lo = mid + 1;
+            }
+        }
+
+        return 0.0;
+    }
+
+    // Same as interpolating the sorted values at the fractional index, but
+    // using selection instead of sorting. Values are reordered.
+    double valueAtFractionalIndex(std::vector<int> &values, double index) {
+        if (values.empty())
+            return 0.0;
+
+        long long wholePart = std::floor(index);
+        if (wholePart < 0)
+            return *std::min_element(values.begin(), values.end());
+        if (wholePart >= (long long)values.size() - 1)
+            return *std::max_element(values.begin(), values.end());
+
+        auto nth = values.begin() + wholePart;
+        std::nth_element(values.begin(), nth, values.end());
+        double piece1 = *nth;
+        double piece2 = *std::min_element(nth + 1, values.end());
+
+        double fractionalPart = index - double(wholePart);
+        return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
+    }
+}
+
+Statistics graph::computeStatistics(const AssemblyGraph &graph, unsigned threads) {
+    Statistics stats;
+
+    const auto &adj = graph.adjacency();
+    auto pairs = uint32_t(adj.pairCount());
+
+    // Per-pair data that is needed after the pass
+    std::vector<int> lengths(pairs);
+    std::vector<double> depths(pairs);
+    std::vector<int> trimmedLengths(pairs);
+
+    ConcurrentUnionFind components(pairs);
+    std::vector<Partial> partials(blockCount(pairs));
+
+    parallelFor(pairs, threads, [&](Block block, size_t blockIndex) {
+        Partial &partial = partials[blockIndex];
+        for (uint32_t pair = block.begin; pair < block.end; ++pair) {
+            Adjacency::NodeId id = 2 * pair, rcId = id + 1;
+            const DeBruijnNode *node = adj.node(id);
+
+            int length = int(node->getLength());
+            lengths[pair] = length;
+            depths[pair] = node->getDepth();
+
+            partial.nodeCount += 1;
+            partial.totalLength += length;
+
+            // Edges entering the node are complements of the ones leaving its
+            // complement and have the same overlap
+            int maxLeavingOverlap = 0, maxOverlap = 0;
+            for (Adjacency::NodeId nodeId : { id, rcId }) {
+                for (const auto *edge : adj.outgoingEdges(nodeId)) {
+                    int overlap = edge->getOverlap();
+                    if (nodeId == id)
+                        maxLeavingOverlap = std::max(maxLeavingOverlap, overlap);
+                    maxOverlap = std::max(maxOverlap, overlap);
+
+                    partial.smallestOverlap = std::min(partial.smallestOverlap, overlap);
+                    partial.largestOverlap = std::max(partial.largestOverlap, overlap);
+                    partial.edgeCount += edge->isPositiveEdge();
+                }
+
+                for (auto target : adj.outgoing(nodeId))
+                    components.unite(pair, target >> 1);
+            }
+            partial.totalLengthNoOverlaps += length - maxOverlap;
+
+            // See DeBruijnNode::getLengthWithoutTrailingOverlap()
+            trimmedLengths[pair] = maxLeavingOverlap > length ? 0 : length - maxLeavingOverlap;
+
+            bool noLeaving = adj.outDegree(id) == 0, noEntering = adj.outDegree(rcId) == 0;
+            partial.deadEnds += noLeaving + noEntering;
+            if (noLeaving && noEntering)
+                partial.totalLengthOrphanedNodes += length;
+        }
+    });
+
+    Partial total;
+    for (const auto &partial : partials)
+        total.merge(partial);
+
+    stats.nodeCount = total.nodeCount;
+    stats.edgeCount = total.edgeCount;
+    stats.smallestOverlap = total.smallestOverlap == std::numeric_limits<int>::max() ? 0 : total.smallestOverlap;
+    stats.largestOverlap = total.largestOverlap;
+    stats.totalLength = total.totalLength;
+    stats.totalLengthNoOverlaps = total.totalLengthNoOverlaps;
+    stats.totalLengthOrphanedNodes = total.totalLengthOrphanedNodes;
+    stats.deadEnds = total.deadEnds;
+    if (stats.nodeCount > 0)
+        stats.percentageDeadEnds = 100.0 * double(stats.deadEnds) / (2 * stats.nodeCount);
+
+    // Connected components: sum up the lengths at the component roots
+    {
+        std::vector<long long> componentLengths(pairs, 0);
+        for (uint32_t pair = 0; pair < pairs; ++pair) {
+            uint32_t root = components.find(pair);
+            stats.componentCount += (root == pair);
+            componentLengths[root] += lengths[pair];
+        }
+        if (pairs)
+            stats.largestComponentLength = *std::max_element(componentLengths.begin(), componentLengths.end());
+    }
+
+    if (stats.totalLength == 0 || pairs == 0)
+        return stats;
+
+    // Node length statistics
+    {
+        stats.shortestNode = *std::min_element(lengths.begin(), lengths.end());
+        stats.longestNode = *std::max_element(lengths.begin(), lengths.end());
+
+        // Selection reorders the values, so work on a copy
+        std::vector<int> values(lengths);
+        stats.firstQuartile = int(std::round(valueAtFractionalIndex(values, (values.size() - 1) / 4.0)));
+        stats.median = int(std::round(valueAtFractionalIndex(values, (values.size() - 1) / 2.0)));
+        stats.thirdQuartile = int(std::round(valueAtFractionalIndex(values, (values.size() - 1) * 3.0 / 4.0)));
+
+        // N50 is the length of the node covering the middle base when nodes
+        // are ordered from the longest to the shortest
+        std::vector<std::pair<double, long long>> items(pairs);
+        for (uint32_t pair = 0; pair < pairs; ++pair)
+            items[pair] = { lengths[pair], lengths[pair] };
+        long long halfIndex = (long long)std::ceil(double(stats.totalLength) / 2.0) - 1;
+        stats.n50 = int(valueAtBaseIndex(items, halfIndex, std::greater<>()));
+    }
+
+    // Median depth by base
+    {
+        if (pairs == 1)
+            stats.medianDepthByBase = depths.front();
+        else {
+            std::vector<std::pair<double, long long>> items(pairs);
+            for (uint32_t pair = 0; pair < pairs; ++pair)
+                items[pair] = { depths[pair], lengths[pair] };
+
+            if (stats.totalLength % 2 == 0) {
+                long long medianIndex2 = stats.totalLength / 2;
+                double depth1 = valueAtBaseIndex(items, medianIndex2 - 1, std::less<>());
+                double depth2 = valueAtBaseIndex(items, medianIndex2, std::less<>());
+                stats.medianDepthByBase = (depth1 + depth2) / 2.0;
+            } else
+                stats.medianDepthByBase = valueAtBaseIndex(items, (stats.totalLength - 1) / 2, std::less<>());
+        }
+    }
+
+    // Estimated sequence length needs the median depth, so it is a separate
+    // (cheap) pass over the collected data
+    if (stats.medianDepthByBase != 0.0) {
+        std::vector<long long> estimated(blockCount(pairs), 0);
+        parallelFor(pairs, threads, [&](Block block, size_t blockIndex) {
+            for (uint32_t pair = block.begin; pair < block.end; ++pair) {
+                double relativeDepth = depths[pair] / stats.medianDepthByBase;
+                int closestIntegerDepth = int(std::round(relativeDepth));
+                estimated[blockIndex] += (long long)trimmedLengths[pair] * closestIntegerDepth;
+            }
+        });
+        for (long long partial : estimated)
+            stats.estimatedSequenceLength += partial;
+    }
+
+    return stats;
+}
@@ -0,0 +1,51 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+class AssemblyGraph;
+
+namespace graph {
+    // Summary statistics of the graph as shown by "bandage info" and the graph
+    // information dialog. Node statistics only take positive nodes into
+    // account, i.e. each complementary pair counts once.
+    struct Statistics {
+        int nodeCount = 0;
+        int edgeCount = 0;
+        int smallestOverlap = 0;
+        int largestOverlap = 0;
+        long long totalLength = 0;
+        long long totalLengthNoOverlaps = 0;
+        unsigned deadEnds = 0;
+        double percentageDeadEnds = 0.0;
+        int componentCount = 0;
+        long long largestComponentLength = 0;
+        long long totalLengthOrphanedNodes = 0;
+        int n50 = 0;
+        int shortestNode = 0;
+        int firstQuartile = 0;
+        int median = 0;
+        int thirdQuartile = 0;
+        int longestNode = 0;
+        double medianDepthByBase = 0.0;
+        long long estimatedSequenceLength = 0;
+    };
+
+    // Computes all the statistics in a single pass over the graph adjacency
+    // snapshot, the pass is split between the given number of threads.
+    Statistics computeStatistics(const AssemblyGraph &graph, unsigned threads = 1);
+}
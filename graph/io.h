@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QString>
+#include <algorithm>
 #include <memory>
 
 class AssemblyGraph;
@@ -34,6 +35,11 @@ namespace io {
         [[nodiscard]] bool hasCustomColours() const { return hasCustomColours_; }
         [[nodiscard]] bool hasComplexOverlaps() const { return hasComplexOverlaps_; }
 
+        // Number of worker threads the builder is allowed to use. Builders that
+        // do not support parallel loading simply ignore this.
+        void setThreads(unsigned threads) { threads_ = std::max(threads, 1u); }
+        [[nodiscard]] unsigned threads() const { return threads_; }
+
     protected:
         explicit AssemblyGraphBuilder(QString fileName)
                 : fileName_(std::move(fileName)) {}
@@ -42,6 +48,7 @@ namespace io {
         bool hasCustomLabels_ = false;
         bool hasCustomColours_ = false;
         bool hasComplexOverlaps_ = false;
+        unsigned threads_ = 1;
     };
 
     bool loadGFAPaths(AssemblyGraph &graph, QString fileName);
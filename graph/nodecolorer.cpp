@@ -20,7 +20,7 @@
 
 #include "assemblygraph.h"
 #include "debruijnnode.h"
-#include "graphicsitemnode.h"
+#include "nodedrawing.h"
 
 #include "program/globals.h"
 #include "program/settings.h"
@@ -37,8 +37,8 @@ INodeColorer::INodeColorer(NodeColorScheme scheme)
     : m_graph(g_assemblyGraph), m_scheme(scheme) {
 }
 
-std::pair<QColor, QColor> INodeColorer::get(const GraphicsItemNode *node,
-                                            const GraphicsItemNode *rcNode) {
+std::pair<QColor, QColor> INodeColorer::get(const NodeDrawing *node,
+                                            const NodeDrawing *rcNode) {
     QColor posColor = this->get(node);
     QColor negColor = rcNode ? this->get(rcNode) : posColor;
 
@@ -70,7 +70,7 @@ std::unique_ptr<INodeColorer> INodeColorer::create(NodeColorScheme scheme) {
     return nullptr;
 }
 
-QColor DepthNodeColorer::get(const GraphicsItemNode *node) {
+QColor DepthNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
     double depth = deBruijnNode->getDepth();
 
@@ -84,7 +84,7 @@ QColor DepthNodeColorer::get(const GraphicsItemNode *node) {
     return tinycolormap::GetColor(fraction, colorMap(g_settings->colorMap)).ConvertToQColor();
 }
 
-QColor UniformNodeColorer::get(const GraphicsItemNode *node) {
+QColor UniformNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     if (deBruijnNode->isSpecialNode())
@@ -95,7 +95,7 @@ QColor UniformNodeColorer::get(const GraphicsItemNode *node) {
         return g_settings->uniformNegativeNodeColour;
 }
 
-QColor RandomNodeColorer::get(const GraphicsItemNode *node) {
+QColor RandomNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     // Make a colour with a random hue.
@@ -118,7 +118,7 @@ QColor RandomNodeColorer::get(const GraphicsItemNode *node) {
     return posColour;
 }
 
-std::pair<QColor, QColor> RandomNodeColorer::get(const GraphicsItemNode *node, const GraphicsItemNode *rcNode) {
+std::pair<QColor, QColor> RandomNodeColorer::get(const NodeDrawing *node, const NodeDrawing *rcNode) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     // Make a colour with a random hue.  Assign a colour to both this node and
@@ -142,11 +142,11 @@ std::pair<QColor, QColor> RandomNodeColorer::get(const GraphicsItemNode *node, c
     return { posColour, negColour };
 }
 
-QColor GrayNodeColorer::get(const GraphicsItemNode *node) {
+QColor GrayNodeColorer::get(const NodeDrawing *node) {
     return g_settings->grayColor;
 }
 
-QColor CustomNodeColorer::get(const GraphicsItemNode *node) {
+QColor CustomNodeColorer::get(const NodeDrawing *node) {
     return m_graph->getCustomColourForDisplay(node->m_deBruijnNode);;
 }
 
@@ -299,7 +299,7 @@ void ContiguityNodeColorer::determineContiguity(DeBruijnNode* node) {
 }
 
 
-QColor ContiguityNodeColorer::get(const GraphicsItemNode *node) {
+QColor ContiguityNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     // For single nodes, display the colour of whichever of the
@@ -325,14 +325,14 @@ QColor ContiguityNodeColorer::get(const GraphicsItemNode *node) {
     }
 }
 
-QColor GCNodeColorer::get(const GraphicsItemNode *node) {
+QColor GCNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
     float lowValue = 0.2, highValue = 0.8, value = deBruijnNode->getGC();
     float fraction = (value - lowValue) / (highValue - lowValue);
     return tinycolormap::GetColor(fraction, colorMap(g_settings->colorMap)).ConvertToQColor();
 }
 
-QColor TagValueNodeColorer::get(const GraphicsItemNode *node) {
+QColor TagValueNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     auto tags = m_graph->m_nodeTags.find(deBruijnNode);
@@ -378,7 +378,7 @@ void TagValueNodeColorer::reset() {
         m_tagName = *m_tagNames.begin();
 }
 
-QColor CSVNodeColorer::get(const GraphicsItemNode *node) {
+QColor CSVNodeColorer::get(const NodeDrawing *node) {
     const DeBruijnNode *deBruijnNode = node->m_deBruijnNode;
 
     auto val = m_graph->getCsvLine(deBruijnNode, m_colIdx);
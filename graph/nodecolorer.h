@@ -21,7 +21,7 @@
 #include <QSharedPointer>
 
 class AssemblyGraph;
-class GraphicsItemNode;
+class NodeDrawing;
 
 // This needs to be synchronizes with selection combo box!
 enum NodeColorScheme : int {
@@ -42,9 +42,9 @@ public:
     explicit INodeColorer(NodeColorScheme scheme);
     virtual ~INodeColorer() = default;
 
-    [[nodiscard]] virtual QColor get(const GraphicsItemNode *node) = 0;
-    [[nodiscard]] virtual std::pair<QColor, QColor> get(const GraphicsItemNode *node,
-                                                        const GraphicsItemNode *rcNode);
+    [[nodiscard]] virtual QColor get(const NodeDrawing *node) = 0;
+    [[nodiscard]] virtual std::pair<QColor, QColor> get(const NodeDrawing *node,
+                                                        const NodeDrawing *rcNode);
     virtual void reset() {};
     [[nodiscard]] virtual const char* name() const = 0;
 
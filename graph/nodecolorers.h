@@ -29,7 +29,7 @@ class DepthNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Color by depth"; };
 };
 
@@ -37,7 +37,7 @@ class UniformNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Uniform color"; };
 };
 
@@ -45,9 +45,9 @@ class RandomNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
-    [[nodiscard]] std::pair<QColor, QColor> get(const GraphicsItemNode *node,
-                                                const GraphicsItemNode *rcNode) override;
+    QColor get(const NodeDrawing *node) override;
+    [[nodiscard]] std::pair<QColor, QColor> get(const NodeDrawing *node,
+                                                const NodeDrawing *rcNode) override;
     [[nodiscard]] const char* name() const override { return "Random colors"; };
 };
 
@@ -55,7 +55,7 @@ class GrayNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Gray colors"; };
 };
 
@@ -63,7 +63,7 @@ class CustomNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Custom colors"; };
 };
 
@@ -76,7 +76,7 @@ public:
     void reset() override { return m_nodeStatuses.clear(); }
     bool empty() const { return m_nodeStatuses.empty(); }
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Color by contiguity"; };
 
     void determineContiguity(DeBruijnNode*);
@@ -91,7 +91,7 @@ class GCNodeColorer : public INodeColorer {
 public:
     using INodeColorer::INodeColorer;
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     [[nodiscard]] const char* name() const override { return "Color by GC content"; };
 };
 
@@ -103,7 +103,7 @@ public:
             TagValueNodeColorer::reset();
     }
 
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     void reset() override;
     [[nodiscard]] const char* name() const override { return "Color by tag value"; };
 
@@ -127,7 +127,7 @@ public:
         if (m_graph)
             CSVNodeColorer::reset();
     }
-    QColor get(const GraphicsItemNode *node) override;
+    QColor get(const NodeDrawing *node) override;
     void reset() override;
     [[nodiscard]] const char* name() const override { return "Color by CSV columns"; };
 
@@ -0,0 +1,113 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "small_vector/small_pod_vector.hpp"
+
+#include <QColor>
+#include <QPainterPath>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+class DeBruijnNode;
+class Path;
+class QPainter;
+
+// Geometry of a drawn node and the way it is painted, without anything
+// specific to QGraphicsItem. GraphicsItemNode makes it interactive, while
+// the command line renderer uses it as is, so both draw the nodes the same
+// way.
+class NodeDrawing
+{
+public:
+    NodeDrawing(DeBruijnNode * deBruijnNode,
+                const NodeDrawing &toCopy);
+    NodeDrawing(DeBruijnNode * deBruijnNode,
+                double depthRelativeToMeanDrawnDepth,
+                const std::vector<QPointF> &linePoints);
+    NodeDrawing(DeBruijnNode * deBruijnNode,
+                double depthRelativeToMeanDrawnDepth,
+                const adt::SmallPODVector<QPointF> &linePoints);
+
+    DeBruijnNode * m_deBruijnNode;
+    adt::SmallPODVector<QPointF> m_linePoints;
+    QColor m_colour;
+    QPainterPath m_path;
+    float m_width;
+    bool m_hasArrow;
+
+    static QSize getNodeTextSize(const QString& text);
+    static float getNodeWidth(double depthRelativeToMeanDrawnDepth,
+                              double depthPower,
+                              double depthEffectOnWidth,
+                              double averageNodeWidth);
+    static void drawTextPathAtLocation(QPainter *painter, const QPainterPath& textPath, QPointF centre);
+
+    // Paints the node with its annotations and labels, the painter is in
+    // the coordinates of the line points. With levelOfDetail, a node only a
+    // few pixels wide is drawn simplified.
+    void draw(QPainter * painter, bool selected, bool levelOfDetail = false);
+    QPainterPath shape() const;
+    QRectF shapeBounds() const;
+    void remakePath();
+    // Drops the cached shape, to be called whenever the geometry of the
+    // node changes
+    void invalidateShape();
+    bool usePositiveNodeColour() const;
+    QPointF getFirst() const {return m_linePoints.front();}
+    QPointF getSecond() const {return m_linePoints[1];}
+    QPointF getLast() const {return m_linePoints.back();}
+    QPointF getSecondLast() const {return m_linePoints[m_linePoints.size()-2];}
+    std::vector<QPointF> getCentres() const;
+    void setNodeColour(QColor color) { m_colour = color; }
+    QStringList getNodeText() const;
+    void setWidth(double depthRelativeToMeanDrawnDepth,
+                  double averageNodeWidth = 5.0,
+                  double depthPower = 0.5, double depthEffectOnWidth = 0.5);
+    QPainterPath makePartialPath(double startFraction, double endFraction);
+    double getNodePathLength();
+    QPointF findLocationOnPath(double fraction);
+    void shiftPointsLeft();
+    void shiftPointsRight();
+    double indexToFraction(int64_t pos) const;
+
+private:
+    QPainterPath makeShape() const;
+    const QPainterPath &outline() const;
+    void drawSimplified(QPainter * painter, double scale, bool selected) const;
+    void exactPathHighlightNode(QPainter * painter);
+    void queryPathHighlightNode(QPainter * painter);
+    void pathHighlightNode2(QPainter * painter, DeBruijnNode * node, bool reverse, Path * path);
+    QPainterPath buildPartialHighlightPath(double startFraction, double endFraction, bool reverse);
+    void shiftPointSideways(bool left);
+
+    // Stroked node shape (with the arrowhead), its bounds and the simplified
+    // outline drawn around the node. Stroking is expensive and Qt asks for
+    // the shape on every paint and hit test, so these are only computed on
+    // demand and kept until invalidateShape().
+    mutable QPainterPath m_shape;
+    mutable QPainterPath m_outline;
+    mutable QRectF m_shapeBounds;
+    mutable bool m_shapeValid = false;
+    mutable bool m_outlineValid = false;
+};
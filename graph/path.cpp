@@ -24,7 +24,6 @@
 
 #include <QRegularExpression>
 #include <QStringList>
-#include <QApplication>
 #include <limits>
 #include <unordered_set>
 
@@ -617,58 +616,6 @@ bool Path::hasNodeSubset(const Path& other) const {
                        m_nodes.begin(), m_nodes.end()) != other.m_nodes.end();
 }
 
-//This function builds all possible paths between the given start and end,
-//within the given restrictions.
-QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
-                                      GraphLocation endLocation,
-                                      int nodeSearchDepth,
-                                      int minDistance, int maxDistance) {
-    QList<Path> finishedPaths;
-    QList<Path> unfinishedPaths;
-
-    unfinishedPaths.emplace_back(startLocation);
-
-    for (int i = 0; i <= nodeSearchDepth; ++i)
-    {
-        QApplication::processEvents();
-
-        //Look at each of the unfinished paths to see if they end with the end
-        //node.  If so, see if it has the appropriate length.
-        //If it does, it will go into the final returned list.
-        //If it doesn't and it's over length, then it will be removed.
-        QList<Path>::iterator j = unfinishedPaths.begin();
-        while (j != unfinishedPaths.end())
-        {
-            DeBruijnNode * lastNode = (*j).m_nodes.back();
-            if (lastNode == endLocation.getNode())
-            {
-                Path potentialFinishedPath = *j;
-                potentialFinishedPath.m_endLocation = endLocation;
-                int length = potentialFinishedPath.getLength();
-                if (length >= minDistance && length <= maxDistance)
-                    finishedPaths.push_back(potentialFinishedPath);
-                ++j;
-            }
-            else
-            {
-                if ((*j).getLength() > maxDistance)
-                    j = unfinishedPaths.erase(j);
-                else
-                    ++j;
-            }
-        }
-
-        //Make new unfinished paths by extending each of the paths.
-        QList<Path> newUnfinishedPaths;
-        for (auto & unfinishedPath : unfinishedPaths)
-            newUnfinishedPaths.append(unfinishedPath.extendPathInAllPossibleWays());
-        unfinishedPaths = newUnfinishedPaths;
-    }
-
-    return finishedPaths;
-}
-
-
 void Path::extendPathToIncludeEntirityOfNodes() {
     if (m_nodes.empty())
         return;
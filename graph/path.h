@@ -31,6 +31,10 @@ class DeBruijnNode;
 class DeBruijnEdge;
 class AssemblyGraph;
 
+namespace graph {
+    class PathFinder;
+}
+
 class Path {
 public:
     // [from, to] since UI does this
@@ -98,13 +102,9 @@ public:
     void extendPathToIncludeEntirityOfNodes();
     void trim(int start = 0, int end = 0);
 
-    //STATIC
-    static QList<Path> getAllPossiblePaths(GraphLocation startLocation,
-                                           GraphLocation endLocation,
-                                           int nodeSearchDepth,
-                                           int minDistance, int maxDistance);
-
 private:
+    friend class graph::PathFinder;
+
     GraphLocation m_startLocation;
     GraphLocation m_endLocation;
     std::vector<DeBruijnNode *> m_nodes;
@@ -0,0 +1,203 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "pathfinder.h"
+
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+using namespace graph;
+
+// Large enough to never pass a length limit, small enough to never overflow
+// when a length is added
+static constexpr long long UNREACHABLE = std::numeric_limits<long long>::max() / 4;
+
+static constexpr size_t NO_PARENT = std::numeric_limits<size_t>::max();
+
+PathFinder::PathFinder(GraphLocation endLocation, int maxNodes, int maxLength)
+        : m_endLocation(endLocation), m_maxEdges(std::max(maxNodes - 1, 0)) {
+    const DeBruijnNode *endNode = endLocation.getNode();
+    if (endNode == nullptr)
+        return;
+
+    // Breadth-first backwards from the end gives the smallest number of edges
+    // to it. Only the nodes reached here can be a part of any walk.
+    std::vector<const DeBruijnNode *> level{ endNode };
+    m_bounds.emplace(endNode, Bound{ 0, UNREACHABLE });
+    for (int edges = 1; edges <= m_maxEdges && !level.empty(); ++edges) {
+        std::vector<const DeBruijnNode *> nextLevel;
+        for (const auto *node : level) {
+            for (const auto *edge : node->edges()) {
+                if (edge->getEndingNode() != node)
+                    continue;
+
+                const DeBruijnNode *previous = edge->getStartingNode();
+                if (m_bounds.emplace(previous, Bound{ edges, UNREACHABLE }).second)
+                    nextLevel.push_back(previous);
+            }
+        }
+        level.swap(nextLevel);
+    }
+
+    // An edge with the overlap longer than the node it leads to shortens the
+    // walk, the shortest lengths cannot be found (and used to drop partial
+    // walks) then. Every edge relaxed below leads to a reached node.
+    for (const auto &bound : m_bounds) {
+        const DeBruijnNode *node = bound.first;
+        for (const auto *edge : node->edges()) {
+            if (edge->getEndingNode() == node && edge->getOverlap() > int(node->getLength())) {
+                m_lengthBounds = false;
+                return;
+            }
+        }
+    }
+
+    // Dijkstra backwards from the end gives the smallest length still to be
+    // added to a walk ending at the node. The walk ending at the end node is
+    // cut at the end location, hence the negative length there. Nodes
+    // farther than maxLength are never settled and stay unreachable.
+    using Item = std::pair<long long, const DeBruijnNode *>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<>> queue;
+    long long endLength = (long long)endLocation.getPosition() - endNode->getLength();
+    m_bounds[endNode].length = endLength;
+    queue.emplace(endLength, endNode);
+    while (!queue.empty()) {
+        auto [length, node] = queue.top();
+        queue.pop();
+        if (length > maxLength)
+            break;
+        if (length != m_bounds.find(node)->second.length)
+            continue;
+
+        for (const auto *edge : node->edges()) {
+            if (edge->getEndingNode() != node)
+                continue;
+
+            auto it = m_bounds.find(edge->getStartingNode());
+            if (it == m_bounds.end())
+                continue;
+
+            long long previousLength = length + node->getLength() - edge->getOverlap();
+            if (previousLength < it->second.length) {
+                it->second.length = previousLength;
+                queue.emplace(previousLength, it->first);
+            }
+        }
+    }
+}
+
+const PathFinder::Bound *PathFinder::bound(const DeBruijnNode *node) const {
+    auto it = m_bounds.find(node);
+    return it != m_bounds.end() ? &it->second : nullptr;
+}
+
+bool PathFinder::findPaths(GraphLocation startLocation,
+                           int minLength, int maxLength,
+                           size_t &budget, std::vector<Path> &paths) const {
+    DeBruijnNode *startNode = startLocation.getNode(), *endNode = m_endLocation.getNode();
+    if (startNode == nullptr || endNode == nullptr)
+        return true;
+
+    // A partial walk: its last node, the edge leading to it and the index
+    // of the walk it extends. The length counts the last node entirely.
+    struct Step {
+        size_t parent;
+        DeBruijnEdge *edge;
+        DeBruijnNode *node;
+        int edges;
+        long long length;
+    };
+    std::vector<Step> steps;
+
+    using Item = std::pair<long long, size_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<>> queue;
+
+    auto push = [&](size_t parent, DeBruijnEdge *edge, DeBruijnNode *node, int edges, long long length) {
+        const Bound *nodeBound = bound(node);
+        if (nodeBound == nullptr || edges + nodeBound->edges > m_maxEdges)
+            return;
+
+        // Without the bounds a walk too long already might still get
+        // shorter, only the number of edges limits it then
+        long long priority = length;
+        if (m_lengthBounds) {
+            priority += nodeBound->length;
+            if (priority > maxLength)
+                return;
+        }
+
+        steps.push_back({ parent, edge, node, edges, length });
+        // The index breaks the ties, so the order is always the same
+        queue.emplace(priority, steps.size() - 1);
+    };
+
+    auto makePath = [&](size_t idx) {
+        Path path;
+        for (size_t i = idx; i != NO_PARENT; i = steps[i].parent) {
+            path.m_nodes.push_back(steps[i].node);
+            if (steps[i].edge)
+                path.m_edges.push_back(steps[i].edge);
+        }
+        std::reverse(path.m_nodes.begin(), path.m_nodes.end());
+        std::reverse(path.m_edges.begin(), path.m_edges.end());
+        path.m_startLocation = startLocation;
+        path.m_endLocation = m_endLocation;
+        return path;
+    };
+
+    push(NO_PARENT, nullptr, startNode, 0,
+         (long long)startNode->getLength() - (startLocation.getPosition() - 1));
+
+    while (!queue.empty()) {
+        if (budget == 0)
+            return false;
+        --budget;
+
+        size_t idx = queue.top().second;
+        queue.pop();
+        // Copied, as the steps might be reallocated below
+        Step step = steps[idx];
+
+        // A walk reaching the end might still be extended, it could come
+        // back to the end later
+        if (step.node == endNode) {
+            long long length = step.length - ((long long)endNode->getLength() - m_endLocation.getPosition());
+            if (length >= minLength && length <= maxLength)
+                paths.push_back(makePath(idx));
+        }
+
+        if (step.edges == m_maxEdges)
+            continue;
+
+        for (auto *edge : step.node->edges()) {
+            if (edge->getStartingNode() != step.node)
+                continue;
+
+            DeBruijnNode *nextNode = edge->getEndingNode();
+            push(idx, edge, nextNode, step.edges + 1,
+                 step.length + nextNode->getLength() - edge->getOverlap());
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlocation.h"
+#include "path.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <cstddef>
+#include <vector>
+
+class DeBruijnNode;
+
+namespace graph {
+    // Finds all the walks through the graph from a start location to the
+    // given end location, within a limit on the number of nodes and on the
+    // length.
+    //
+    // For every node which can still reach the end, the smallest number of
+    // edges and the smallest length needed to get there are computed once
+    // (backwards from the end) and shared by all the start locations. A
+    // partial walk which cannot be finished within the limits is dropped as
+    // soon as it is made.
+    //
+    // The partial walks form a tree: every one only stores its last edge and
+    // the index of the walk it extends, so the common prefixes are never
+    // copied. They are expanded best-first by the smallest length they could
+    // be finished with.
+    class PathFinder {
+    public:
+        PathFinder(GraphLocation endLocation, int maxNodes, int maxLength);
+
+        // Appends the walks from startLocation with the length within
+        // [minLength, maxLength] to paths. maxLength must not exceed the one
+        // given to the constructor. Every partial walk expanded takes a step
+        // from the budget; returns false once it is exhausted, some of the
+        // walks might not have been found then.
+        bool findPaths(GraphLocation startLocation,
+                       int minLength, int maxLength,
+                       size_t &budget, std::vector<Path> &paths) const;
+
+    private:
+        struct Bound {
+            int edges;
+            long long length;
+        };
+        [[nodiscard]] const Bound *bound(const DeBruijnNode *node) const;
+
+        GraphLocation m_endLocation;
+        int m_maxEdges;
+        // The length bounds are only valid if no edge overlap is longer than
+        // the node it leads to, they are not used otherwise
+        bool m_lengthBounds = true;
+        phmap::flat_hash_map<const DeBruijnNode *, Bound> m_bounds;
+    };
+}
@@ -25,8 +25,9 @@
 
 namespace utils {
     static inline QByteArray sequenceToQByteArray(const Sequence &sequence) {
-        auto sequence_str = sequence.str();
-        return {sequence_str.c_str(), static_cast<qsizetype>(sequence_str.size())};
+        QByteArray res(static_cast<qsizetype>(sequence.size()), Qt::Uninitialized);
+        sequence.CopyNucls(res.data());
+        return res;
     }
 
     // This function is used when making FASTA outputs - it breaks a sequence into
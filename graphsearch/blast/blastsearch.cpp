@@ -19,6 +19,7 @@
 
 #include "blastsearch.h"
 
+#include "graphsearch/hitparser.h"
 #include "program/settings.h"
 
 #include "graph/assemblygraph.h"
@@ -26,14 +27,18 @@
 
 #include <QDir>
 #include <QProcess>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <numeric>
 
 using namespace search;
 
 BlastSearch::BlastSearch(const QDir &workDir, QObject *parent)
-  : GraphSearch(workDir, parent) {}
+  : GraphSearch(workDir, parent), m_database(temporaryDir().path()) {}
 
 bool BlastSearch::findTools() {
     if (!findProgram("makeblastdb", &m_makeblastdbCommand)) {
@@ -52,6 +57,29 @@ bool BlastSearch::findTools() {
     return true;
 }
 
+// The BLAST database of a volume is kept in the volume directory
+static QString blastDatabaseDirectory(const QString &volume) {
+    return QDir(volume).filePath("blastdb");
+}
+
+static QString blastDatabase(const QString &volume) {
+    return QDir(blastDatabaseDirectory(volume)).filePath("nodes");
+}
+
+// The volumes are written before makeblastdb runs, so a failed or cancelled
+// build leaves volumes without the BLAST databases
+bool BlastSearch::hasDatabase() const {
+    if (m_database.empty())
+        return false;
+
+    for (const auto &volume : m_database.volumes()) {
+        if (!QDir(blastDatabaseDirectory(volume)).exists())
+            return false;
+    }
+
+    return true;
+}
+
 QString BlastSearch::buildDatabase(const AssemblyGraph &graph, bool includePaths) {
     DbBuildFinishedRAII watcher(this);
 
@@ -64,29 +92,6 @@ QString BlastSearch::buildDatabase(const AssemblyGraph &graph, bool includePaths
 
     m_cancelBuildDatabase = false;
 
-    QFile file(temporaryDir().filePath("all_nodes.fasta"));
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-        return (m_lastError = "Failed to open: " + file.fileName());
-
-    {
-        QTextStream out(&file);
-        for (const auto *node : graph.m_deBruijnGraphNodes) {
-            if (m_cancelBuildDatabase)
-                return (m_lastError = "Build cancelled.");
-
-            out << node->getFasta(true, false, false);
-        }
-
-        if (includePaths) {
-            for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it) {
-                if (m_cancelBuildDatabase)
-                    return (m_lastError = "Build cancelled.");
-
-                out << it.value().getFasta(it.key().c_str());
-            }
-        }
-    }
-
     // Make sure the graph has sequences
     bool atLeastOneSequence = false;
     for (const auto *node : graph.m_deBruijnGraphNodes) {
@@ -97,27 +102,50 @@ QString BlastSearch::buildDatabase(const AssemblyGraph &graph, bool includePaths
     }
 
     if (!atLeastOneSequence)
-        return (m_lastError = "Cannot build the Minimap2 database as this graph contains no sequences");
+        return (m_lastError = "Cannot build the BLAST database as this graph contains no sequences");
 
-    QStringList makeBlastdbOptions;
-    makeBlastdbOptions << "-in" << temporaryDir().filePath("all_nodes.fasta")
-                       << "-dbtype" << "nucl";
+    // Only the sequences not in the cached database are written out
+    m_lastError = m_database.build(graph, includePaths, m_cancelBuildDatabase);
+    if (!m_lastError.isEmpty())
+        return m_lastError;
 
-    m_buildDb = new QProcess();
-    m_buildDb->start(m_makeblastdbCommand, makeBlastdbOptions);
+    for (const auto &volume : m_database.volumes()) {
+        if (QDir(blastDatabaseDirectory(volume)).exists())
+            continue;
+
+        // Built aside and renamed, so a concurrent search never sees a
+        // partially built database
+        QTemporaryDir tempDir(blastDatabaseDirectory(volume) + ".XXXXXX");
+        if (!tempDir.isValid())
+            return (m_lastError = "Failed to create: " + tempDir.path());
+
+        QStringList makeBlastdbOptions;
+        makeBlastdbOptions << "-in" << SearchDatabase::fastaFile(volume)
+                           << "-dbtype" << "nucl"
+                           << "-out" << QDir(tempDir.path()).filePath("nodes");
+
+        m_buildDb = new QProcess();
+        m_buildDb->start(m_makeblastdbCommand, makeBlastdbOptions);
+
+        bool finished = m_buildDb->waitForFinished(-1);
+        if (m_buildDb->exitCode() != 0 || !finished) {
+            m_lastError = "There was a problem building BLAST database";
+            QString stdErr = m_buildDb->readAllStandardError();
+            m_lastError += stdErr.isEmpty() ? "." : ":\n\n" + stdErr;
+        }
+        if (m_cancelBuildDatabase)
+            m_lastError = "Build cancelled.";
 
-    bool finished = m_buildDb->waitForFinished(-1);
-    if (m_buildDb->exitCode() != 0 || !finished) {
-        m_lastError = "There was a problem building minimap2 database";
-        QString stdErr = m_buildDb->readAllStandardError();
-        m_lastError += stdErr.isEmpty() ? "." : ":\n\n" + stdErr;
-    } else if (m_cancelBuildDatabase)
-        m_lastError = "Build cancelled.";
-    else
-        m_lastError = "";
+        m_buildDb->deleteLater();
+        m_buildDb = nullptr;
 
-    m_buildDb->deleteLater();
-    m_buildDb = nullptr;
+        if (!m_lastError.isEmpty())
+            return m_lastError;
+
+        tempDir.setAutoRemove(false);
+        if (!QDir().rename(tempDir.path(), blastDatabaseDirectory(volume)))
+            QDir(tempDir.path()).removeRecursively();
+    }
 
     return m_lastError;
 }
@@ -127,71 +155,52 @@ QString BlastSearch::doSearch(QString extraParameters) {
 }
 
 static void writeQueryFile(QFile *file,
-                           const Queries &queries,
-                           QuerySequenceType sequenceType) {
+                           const std::vector<const Query *> &queries) {
     QTextStream out(file);
-    for (const auto *query: queries.queries()) {
-        if (query->getSequenceType() != sequenceType)
-            continue;
-
+    for (const auto *query: queries) {
         out << '>' << query->getName() << '\n'
             << query->getSequence()
             << '\n';
     }
 }
 
-QString BlastSearch::runOneBlastSearch(QuerySequenceType sequenceType,
-                                       const Queries &queries,
-                                       const QString &extraParameters,
-                                       bool &success) {
-    QTemporaryFile tmpFile(temporaryDir().filePath(sequenceType == NUCLEOTIDE ?
-                                                   "nucl_queries.XXXXXX.fasta" : "prot_queries.XXXXXX.fasta"));
-    if (!tmpFile.open()) {
-        m_lastError = "Failed to create temporary query file";
-        success = false;
-        return "";
+// Splits the queries of the given type into at most maxShards groups of
+// about the same total length. The longest queries are placed first, each
+// into the group with the least sequence so far; the queries keep their
+// order within a group.
+static std::vector<std::vector<const Query *>> splitQueries(const Queries &queries,
+                                                            QuerySequenceType sequenceType,
+                                                            size_t maxShards) {
+    std::vector<const Query *> typed;
+    for (const auto *query: queries.queries()) {
+        if (query->getSequenceType() == sequenceType)
+            typed.push_back(query);
     }
 
-    writeQueryFile(&tmpFile, queries, sequenceType);
-
-    QStringList blastOptions;
-    blastOptions << "-query" << tmpFile.fileName()
-                 << "-db" << temporaryDir().filePath("all_nodes.fasta")
-                 << "-outfmt" << "6";
-    blastOptions << extraParameters.split(" ", Qt::SkipEmptyParts);
-
-    m_doSearch = new QProcess();
-    m_doSearch->start(sequenceType == NUCLEOTIDE ? m_blastnCommand : m_tblastnCommand,
-                      blastOptions);
-
-    bool finished = m_doSearch->waitForFinished(-1);
-    if (m_doSearch->exitCode() != 0 || !finished) {
-        if (m_cancelSearch) {
-            m_lastError = "BLAST search cancelled.";
-        } else {
-            m_lastError = "There was a problem running the BLAST search";
-            QString stdErr = m_doSearch->readAllStandardError();
-            m_lastError += stdErr.isEmpty() ? "." : ":\n\n" + stdErr;
-        }
-        m_doSearch->deleteLater();
-        m_doSearch = nullptr;
-
-        success = false;
-        return m_lastError;
+    size_t shardCount = std::min(std::max<size_t>(maxShards, 1), typed.size());
+    if (shardCount == 0)
+        return {};
+
+    std::vector<size_t> order(typed.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return typed[a]->getLength() > typed[b]->getLength(); });
+
+    std::vector<size_t> shardOf(typed.size());
+    std::vector<uint64_t> shardLength(shardCount, 0);
+    for (size_t idx : order) {
+        size_t shard = std::min_element(shardLength.begin(), shardLength.end()) - shardLength.begin();
+        shardOf[idx] = shard;
+        shardLength[shard] += typed[idx]->getLength();
     }
 
-    QString blastOutput = m_doSearch->readAllStandardOutput();
-    m_doSearch->deleteLater();
-    m_doSearch = nullptr;
+    std::vector<std::vector<const Query *>> shards(shardCount);
+    for (size_t i = 0; i < typed.size(); ++i)
+        shards[shardOf[i]].push_back(typed[i]);
 
-    success = true;
-    return blastOutput;
+    return shards;
 }
 
-static std::pair<NodeHits, PathHits>
-buildHitsFromBlastOutput(QString blastOutput,
-                         Queries &queries);
-
 QString BlastSearch::doSearch(Queries &queries, QString extraParameters) {
     GraphSearchFinishedRAII watcher(this);
 
@@ -199,31 +208,60 @@ QString BlastSearch::doSearch(Queries &queries, QString extraParameters) {
     if (!findTools())
         return m_lastError;
 
-    // FIXME: Do we need proper mutex here?
-    if (m_doSearch)
+    if (searchInProgress())
         return (m_lastError = "Search is already in progress");
 
-    m_cancelSearch = false;
+    if (!hasDatabase())
+        return (m_lastError = "The BLAST database has not been built.");
 
-    QString blastOutput;
-    bool success = false;
-    if (queries.getQueryCount(NUCLEOTIDE) > 0 && !m_cancelSearch) {
-        blastOutput += runOneBlastSearch(NUCLEOTIDE, queries, extraParameters, success);
-        if (!success)
-            return m_lastError;
-    }
+    m_cancelSearch = false;
 
-    if (queries.getQueryCount(PROTEIN) > 0 && !m_cancelSearch) {
-        blastOutput += runOneBlastSearch(PROTEIN, queries, extraParameters, success);
-        if (!success)
-            return m_lastError;
+    // Several databases are given as a single space-separated list
+    QStringList databases;
+    for (const auto &volume : m_database.volumes())
+        databases << '"' + blastDatabase(volume) + '"';
+
+    QStringList extraOptions = extraParameters.split(" ", Qt::SkipEmptyParts);
+    bool userThreads = extraOptions.contains("-num_threads");
+
+    // The queries are split into shards searched by separate BLAST
+    // processes, the threads left over are given to the processes
+    size_t threads = g_settings->threads;
+    std::vector<std::unique_ptr<QTemporaryFile>> queryFiles;
+    std::vector<SearchShard> shards;
+    for (auto sequenceType : { NUCLEOTIDE, PROTEIN }) {
+        auto queryShards = splitQueries(queries, sequenceType, threads);
+        for (const auto &queryShard : queryShards) {
+            auto &queryFile = queryFiles.emplace_back(
+                    std::make_unique<QTemporaryFile>(temporaryDir().filePath(sequenceType == NUCLEOTIDE ?
+                                                                             "nucl_queries.XXXXXX.fasta" : "prot_queries.XXXXXX.fasta")));
+            if (!queryFile->open())
+                return (m_lastError = "Failed to create temporary query file");
+
+            writeQueryFile(queryFile.get(), queryShard);
+            queryFile->flush();
+
+            QStringList blastOptions;
+            blastOptions << "-query" << queryFile->fileName()
+                         << "-db" << databases.join(' ')
+                         << "-outfmt" << "6";
+            if (!userThreads)
+                blastOptions << "-num_threads" << QString::number(std::max<size_t>(threads / queryShards.size(), 1));
+            blastOptions << extraOptions;
+
+            shards.push_back({ sequenceType == NUCLEOTIDE ? m_blastnCommand : m_tblastnCommand,
+                               blastOptions, HitParser::BLAST_TABULAR });
+        }
     }
 
-    if (m_cancelSearch)
-        return (m_lastError = "BLAST search cancelled");
+    // Hits are parsed while BLAST is still running, so the whole output is
+    // never kept in memory
+    NodeHits nodeHits;
+    PathHits pathHits;
+    if (!runSearchShards(shards, queries, 1, m_cancelSearch, nodeHits, pathHits))
+        return m_lastError;
 
     // If the code got here, then the search completed successfully.
-    auto [nodeHits, pathHits] = buildHitsFromBlastOutput(blastOutput, queries);
     queries.addNodeHits(nodeHits);
     queries.findQueryPaths();
     queries.addPathHits(pathHits);
@@ -280,132 +318,15 @@ int BlastSearch::loadQueriesFromFile(QString fullFileName) {
 }
 
 void BlastSearch::cancelDatabaseBuild() {
-    if (!m_buildDb)
-        return;
-
     m_cancelBuildDatabase = true;
     if (m_buildDb)
         m_buildDb->kill();
 }
 
 void BlastSearch::cancelSearch() {
-    if (!m_doSearch)
-        return;
-
     m_cancelSearch = true;
-    if (m_doSearch)
-        m_doSearch->kill();
 }
 
 QString BlastSearch::annotationGroupName() const {
     return g_settings->blastAnnotationGroupName;
 }
-
-static QString getNodeNameFromString(const QString &nodeString) {
-    QStringList nodeStringParts = nodeString.split("_");
-
-    // The node string format should look like this:
-    // NODE_nodename_length_123_cov_1.23
-    if (nodeStringParts.size() < 6)
-        return "";
-
-    if (nodeStringParts.size() == 6)
-        return nodeStringParts[1];
-
-    // If the code got here, there are more than 6 parts.  This means there are
-    // underscores in the node name (happens a lot with Trinity graphs).  So we
-    // need to pull out the parts which constitute the name.
-    int underscoreCount = nodeStringParts.size() - 6;
-    QString nodeName = "";
-    for (int i = 0; i <= underscoreCount; ++i) {
-        nodeName += nodeStringParts[1+i];
-        if (i < underscoreCount)
-            nodeName += "_";
-    }
-
-    return nodeName;
-}
-
-// This function uses the contents of blastOutput (the raw output from the
-// BLAST search) to construct the Hit objects.
-// It looks at the filters to possibly exclude hits which fail to meet user-
-// defined thresholds.
-static std::pair<NodeHits, PathHits>
-buildHitsFromBlastOutput(QString blastOutput,
-                         Queries &queries) {
-    NodeHits nodeHits; PathHits pathHits;
-
-    QStringList blastHitList = blastOutput.split("\n", Qt::SkipEmptyParts);
-
-    for (const auto &hitString : blastHitList) {
-        QStringList alignmentParts = hitString.split('\t');
-
-        if (alignmentParts.size() < 12)
-            continue;
-
-        QString queryName = alignmentParts[0];
-        QString nodeLabel = alignmentParts[1];
-        double percentIdentity = alignmentParts[2].toDouble();
-        int alignmentLength = alignmentParts[3].toInt();
-        int numberMismatches = alignmentParts[4].toInt();
-        int numberGapOpens = alignmentParts[5].toInt();
-        int queryStart = alignmentParts[6].toInt();
-        int queryEnd = alignmentParts[7].toInt();
-        int nodeStart = alignmentParts[8].toInt();
-        int nodeEnd = alignmentParts[9].toInt();
-        SciNot eValue(alignmentParts[10]);
-        double bitScore = alignmentParts[11].toDouble();
-
-        Query *query = queries.getQueryFromName(queryName);
-        if (query == nullptr)
-            continue;
-
-        // Check the user-defined filters.
-        if (g_settings->blastIdentityFilter.on &&
-            percentIdentity < g_settings->blastIdentityFilter)
-            continue;
-
-        if (g_settings->blastEValueFilter.on &&
-            eValue > g_settings->blastEValueFilter)
-            continue;
-
-        if (g_settings->blastBitScoreFilter.on &&
-            bitScore < g_settings->blastBitScoreFilter)
-            continue;
-
-        if (g_settings->blastAlignmentLengthFilter.on &&
-            alignmentLength < g_settings->blastAlignmentLengthFilter)
-            continue;
-
-        if (g_settings->blastQueryCoverageFilter.on) {
-            double hitCoveragePercentage = 100.0 * Hit::getQueryCoverageFraction(query,
-                                                                                 queryStart, queryEnd);
-            if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
-                continue;
-        }
-
-        auto nodeIt = g_assemblyGraph->m_deBruijnGraphNodes.find(getNodeNameFromString(nodeLabel).toStdString());
-        if (nodeIt != g_assemblyGraph->m_deBruijnGraphNodes.end()) {
-            // Only save BLAST hits that are on forward strands.
-            if (nodeStart > nodeEnd)
-                continue;
-
-            nodeHits.emplace_back(query,
-                                  new Hit(query, nodeIt.value(),
-                                          percentIdentity, alignmentLength,
-                                          numberMismatches, numberGapOpens,
-                                          queryStart, queryEnd,
-                                          nodeStart, nodeEnd, eValue, bitScore));
-        }
-
-        auto pathIt = g_assemblyGraph->m_deBruijnGraphPaths.find(nodeLabel.toStdString());
-        if (pathIt != g_assemblyGraph->m_deBruijnGraphPaths.end()) {
-            pathHits.emplace_back(query, &pathIt.value(),
-                                  Path::MappingRange{queryStart, queryEnd,
-                                                     nodeStart, nodeEnd});
-        }
-
-    }
-
-    return { nodeHits, pathHits };
-}
@@ -19,10 +19,13 @@
 #pragma once
 
 #include "graphsearch/graphsearch.h"
+#include "graphsearch/searchdatabase.h"
 
 #include <QDir>
 #include <QString>
 
+#include <atomic>
+
 // This is a class to hold all BLAST search related stuff.
 // An instance of it is made available to the whole program
 // as a global.
@@ -51,6 +54,7 @@ public:
     QString name() const override { return "BLAST"; }
     QString queryFormat() const override { return "FASTA"; }
     QString annotationGroupName() const override;
+    bool hasDatabase() const override;
 
 public slots:
     void cancelDatabaseBuild() override;
@@ -59,13 +63,9 @@ public slots:
 private:
     bool findTools();
 
-    QString runOneBlastSearch(search::QuerySequenceType sequenceType,
-                              const search::Queries &queries,
-                              const QString &extraParameters,
-                              bool &success);
-
-    bool m_cancelBuildDatabase = false, m_cancelSearch = false;
-    QProcess *m_buildDb = nullptr, *m_doSearch = nullptr;
+    SearchDatabase m_database;
+    std::atomic<bool> m_cancelBuildDatabase = false, m_cancelSearch = false;
+    QProcess *m_buildDb = nullptr;
     QString m_makeblastdbCommand, m_blastnCommand, m_tblastnCommand;
 };
 
@@ -16,15 +16,24 @@
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "graphsearch.h"
+#include "hitparser.h"
 #include "graph/annotationsmanager.h"
 
 #include "graph/assemblygraph.h"
 #include "program/globals.h"
+#include "program/settings.h"
 
 #include <QDir>
 #include <QRegularExpression>
 #include <QApplication>
 #include <QProcess>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
 
 using namespace search;
 
@@ -135,6 +144,122 @@ GraphSearch::GraphSearchFinishedRAII::~GraphSearchFinishedRAII() {
 }
 
 
+// How often a running shard checks if it has to stop
+static constexpr int SHARD_POLL_MS = 100;
+
+// Feeds the output of the started process to the parser while the process
+// runs. The process is killed once stop() returns true. Returns false if the
+// process failed or was killed.
+static bool parseProcessOutput(QProcess &process, HitParser &parser,
+                               const std::function<bool()> &stop,
+                               const std::function<void()> &progress) {
+    while (process.state() != QProcess::NotRunning) {
+        if (stop()) {
+            process.kill();
+            break;
+        }
+        if (process.waitForReadyRead(SHARD_POLL_MS)) {
+            parser.addData(process.readAllStandardOutput());
+            progress();
+        }
+    }
+
+    if (process.state() != QProcess::NotRunning)
+        process.waitForFinished(-1);
+    parser.addData(process.readAllStandardOutput());
+    parser.finish();
+    progress();
+
+    return process.error() != QProcess::FailedToStart &&
+           process.exitStatus() == QProcess::NormalExit &&
+           process.exitCode() == 0;
+}
+
+bool GraphSearch::runSearchShards(const std::vector<SearchShard> &shards, const Queries &queries,
+                                  size_t queryPasses, const std::atomic<bool> &cancel,
+                                  NodeHits &nodeHits, PathHits &pathHits) {
+    if (m_searchInProgress.exchange(true)) {
+        m_lastError = "Search is already in progress";
+        return false;
+    }
+
+    std::vector<std::unique_ptr<HitParser>> parsers;
+    for (const auto &shard : shards)
+        parsers.emplace_back(std::make_unique<HitParser>(shard.format, queries));
+
+    // Totals over all the shards, every shard adds what it parsed since its
+    // last report
+    std::atomic<size_t> totalQueriesSeen = 0, totalHitCount = 0;
+    queryPasses = std::max<size_t>(queryPasses, 1);
+
+    // Every shard kills its own process, so the processes are only ever
+    // touched by the thread which started them
+    std::atomic<bool> failed = false;
+    QString error;
+    auto stop = [&]() { return cancel || failed; };
+    auto runShard = [&](size_t i) {
+        const SearchShard &shard = shards[i];
+        HitParser &parser = *parsers[i];
+
+        if (stop())
+            return;
+        QProcess process;
+        process.start(shard.program, shard.arguments);
+
+        size_t queriesSeen = 0, hitCount = 0;
+        bool success = parseProcessOutput(process, parser, stop, [&]() {
+            size_t queriesTotal = totalQueriesSeen += parser.queriesSeen() - queriesSeen;
+            size_t hitsTotal = totalHitCount += parser.hitCount() - hitCount;
+            queriesSeen = parser.queriesSeen();
+            hitCount = parser.hitCount();
+            emit searchProgress(int(queriesTotal / queryPasses), int(hitsTotal));
+        });
+
+        if (success || cancel)
+            return;
+
+        // The first failure stops the whole search, the errors of the shards
+        // killed because of it are not interesting
+        if (failed.exchange(true))
+            return;
+        error = "There was a problem running the " + name() + " search";
+        QString stdErr = process.readAllStandardError();
+        error += stdErr.isEmpty() ? "." : ":\n\n" + stdErr;
+    };
+
+    std::vector<size_t> indices(shards.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    size_t threads = std::min<size_t>(g_settings->threads, shards.size());
+    if (threads <= 1) {
+        for (size_t i : indices)
+            runShard(i);
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(threads));
+        QtConcurrent::blockingMap(&pool, indices, runShard);
+    }
+
+    m_searchInProgress = false;
+
+    if (cancel) {
+        m_lastError = name() + " search cancelled.";
+        return false;
+    }
+    if (failed) {
+        m_lastError = error;
+        return false;
+    }
+
+    for (auto &parser : parsers) {
+        NodeHits shardNodeHits = parser->takeNodeHits();
+        nodeHits.insert(nodeHits.end(), shardNodeHits.begin(), shardNodeHits.end());
+        PathHits shardPathHits = parser->takePathHits();
+        pathHits.insert(pathHits.end(), shardPathHits.begin(), shardPathHits.end());
+    }
+
+    return true;
+}
+
 void GraphSearch::addPathHit(Query *query, Path *path,
                              int queryStart, int queryEnd,
                              int pathStart, int pathEnd) {
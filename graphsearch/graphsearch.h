@@ -17,17 +17,26 @@
 
 #pragma once
 
+#include "hitparser.h"
 #include "queries.h"
 
 #include <QDir>
 #include <QString>
+#include <QStringList>
 #include <QTemporaryDir>
 
+#include <atomic>
+#include <vector>
+
+class QProcess;
+
 namespace search {
+
 enum GraphSearchKind {
     BLAST = 0,
     Minimap2,
     NHMMER,
+    Minimizer,
 };
 
 // This is a class to hold all graph node search related stuff.
@@ -93,6 +102,10 @@ public:
     [[nodiscard]] virtual QString queryFormat() const = 0;
     [[nodiscard]] virtual QString annotationGroupName() const = 0;
     [[nodiscard]] virtual bool allowManualQueries() const { return true; }
+    // Whether doSearch() uses the extra parameters, they are ignored otherwise
+    [[nodiscard]] virtual bool allowParameters() const { return true; }
+    // Whether the database was built and could be searched
+    [[nodiscard]] virtual bool hasDatabase() const = 0;
 
     static std::unique_ptr<GraphSearch> get(GraphSearchKind kind,
                                             const QDir &workDir = QDir::temp(), QObject *parent = nullptr);
@@ -102,6 +115,26 @@ protected:
                            int queryStart, int queryEnd,
                            int pathStart, int pathEnd);
 
+    // A single run of an external search tool over a part of the queries or
+    // of the database
+    struct SearchShard {
+        QString program;
+        QStringList arguments;
+        HitParser::Format format;
+    };
+
+    // Runs the shards concurrently, up to g_settings->threads at a time, and
+    // parses the output of every one while it runs. The hits are returned in
+    // the shard order, so they do not depend on the scheduling. Every query
+    // is searched by queryPasses shards, this is only used to report the
+    // progress. Once a shard fails or cancel is set (from any thread), the
+    // running shards kill their processes within a fraction of a second and
+    // false is returned with m_lastError set.
+    bool runSearchShards(const std::vector<SearchShard> &shards, const Queries &queries,
+                         size_t queryPasses, const std::atomic<bool> &cancel,
+                         NodeHits &nodeHits, PathHits &pathHits);
+    [[nodiscard]] bool searchInProgress() const { return m_searchInProgress; }
+
 public slots:
     virtual void cancelDatabaseBuild() {};
     virtual void cancelSearch() {};
@@ -109,6 +142,8 @@ public slots:
 signals:
     void finishedDbBuild(QString error);
     void finishedSearch(QString error);
+    // Number of queries with the output seen so far and the hits kept
+    void searchProgress(int queriesSeen, int hitCount);
 
 protected:
     QString m_lastError;
@@ -116,6 +151,8 @@ protected:
 private:
     Queries m_queries;
     QTemporaryDir m_tempDirectory;
+
+    std::atomic<bool> m_searchInProgress = false;
 };
 
 }
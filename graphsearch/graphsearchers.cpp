@@ -20,6 +20,7 @@
 #include "blast/blastsearch.h"
 #include "minimap2/minimap2search.h"
 #include "hmmer/hmmersearch.h"
+#include "minimizer/minimizersearch.h"
 
 #include <memory>
 
@@ -39,6 +40,9 @@ std::unique_ptr<GraphSearch> GraphSearch::get(GraphSearchKind kind,
         case NHMMER:
             res = std::make_unique<HmmerSearch>(workDir, parent);
             break;
+        case Minimizer:
+            res = std::make_unique<MinimizerSearch>(workDir, parent);
+            break;
     }
 
     return res;
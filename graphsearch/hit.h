@@ -22,6 +22,7 @@
 #include "program/scinot.h"
 
 #include <QString>
+#include <cmath>
 #include <vector>
 
 class DeBruijnNode;
@@ -50,6 +51,12 @@ namespace search {
         SciNot m_eValue;
         double m_bitScore;
 
+        // Hits which are not aligned base by base (e.g. the minimizer ones or
+        // the ones mapped through paths) have no e-value (NaN) and no
+        // identity (negative), they are left out of anything using them
+        bool hasEValue() const { return !std::isnan(m_eValue.toDouble()); }
+        bool hasPercentIdentity() const { return m_percentIdentity >= 0.0; }
+
         double getQueryCoverageFraction() const;
         static double getQueryCoverageFraction(Query *query,
                                                int queryStart, int queryEnd);
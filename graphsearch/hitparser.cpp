@@ -0,0 +1,288 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "hitparser.h"
+
+#include "hit.h"
+#include "queries.h"
+#include "query.h"
+
+#include "graph/assemblygraph.h"
+#include "program/globals.h"
+#include "program/settings.h"
+
+#include <QByteArrayView>
+
+#include <charconv>
+
+using namespace search;
+
+// Both formats have 12 mandatory columns
+static constexpr size_t NUM_FIELDS = 12;
+
+static bool parseInt(std::string_view field, int &value) {
+    auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+// std::from_chars for floating point is not available everywhere yet, the
+// Qt one is locale-independent as well
+static bool parseDouble(std::string_view field, double &value) {
+    bool ok = false;
+    value = QByteArrayView(field.data(), qsizetype(field.size())).toDouble(&ok);
+    return ok;
+}
+
+static bool parseSciNot(std::string_view field, SciNot &value) {
+    size_t e = field.find('e');
+    double coefficient;
+    if (e == std::string_view::npos) {
+        if (!parseDouble(field, coefficient))
+            return false;
+        value = SciNot(coefficient);
+        return true;
+    }
+
+    // Exponent is written with an explicit sign, e.g. 1e-10 or 2e+05
+    std::string_view exponentField = field.substr(e + 1);
+    if (!exponentField.empty() && exponentField.front() == '+')
+        exponentField.remove_prefix(1);
+
+    int exponent;
+    if (!parseDouble(field.substr(0, e), coefficient) || !parseInt(exponentField, exponent))
+        return false;
+
+    value = SciNot(coefficient, exponent);
+    return true;
+}
+
+// The node string format should look like this:
+// NODE_nodename_length_123_cov_1.23
+// There might be underscores in the node name (happens a lot with Trinity
+// graphs), so the name is everything between the first underscore and the
+// fourth one from the end.
+static std::string_view getNodeNameFromLabel(std::string_view label) {
+    size_t begin = label.find('_');
+    if (begin == std::string_view::npos)
+        return {};
+
+    size_t end = label.size();
+    for (unsigned i = 0; i < 4; ++i) {
+        if (end == 0)
+            return {};
+        end = label.rfind('_', end - 1);
+        if (end == std::string_view::npos || end <= begin)
+            return {};
+    }
+
+    return label.substr(begin + 1, end - begin - 1);
+}
+
+HitParser::HitParser(Format format, const Queries &queries)
+        : m_format(format) {
+    for (auto *query : queries.queries())
+        m_queriesByName.emplace(query->getName().toStdString(), query);
+}
+
+HitParser::~HitParser() {
+    for (auto &hit : m_nodeHits)
+        delete hit.second;
+}
+
+void HitParser::addData(std::string_view data) {
+    while (!data.empty()) {
+        size_t newline = data.find('\n');
+        if (newline == std::string_view::npos) {
+            m_pending.append(data);
+            return;
+        }
+
+        // Only the line split between the chunks is copied
+        if (m_pending.empty()) {
+            parseLine(data.substr(0, newline));
+        } else {
+            m_pending.append(data.substr(0, newline));
+            parseLine(m_pending);
+            m_pending.clear();
+        }
+        data.remove_prefix(newline + 1);
+    }
+}
+
+void HitParser::finish() {
+    if (m_pending.empty())
+        return;
+
+    parseLine(m_pending);
+    m_pending.clear();
+}
+
+NodeHits HitParser::takeNodeHits() {
+    NodeHits res;
+    res.swap(m_nodeHits);
+    return res;
+}
+
+PathHits HitParser::takePathHits() {
+    PathHits res;
+    res.swap(m_pathHits);
+    return res;
+}
+
+Query *HitParser::findQuery(std::string_view name) {
+    // All the hits of a query come together
+    if (m_queriesSeen && name == m_lastQueryName)
+        return m_lastQuery;
+
+    m_lastQueryName.assign(name);
+    ++m_queriesSeen;
+
+    auto it = m_queriesByName.find(m_lastQueryName);
+    m_lastQuery = it != m_queriesByName.end() ? it->second : nullptr;
+    return m_lastQuery;
+}
+
+void HitParser::parseLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    if (line.empty())
+        return;
+
+    std::string_view fields[NUM_FIELDS];
+    size_t numFields = 0;
+    while (numFields < NUM_FIELDS) {
+        size_t tab = line.find('\t');
+        fields[numFields++] = line.substr(0, tab);
+        if (tab == std::string_view::npos)
+            break;
+        line.remove_prefix(tab + 1);
+    }
+
+    if (numFields < NUM_FIELDS)
+        return;
+
+    switch (m_format) {
+        case BLAST_TABULAR:
+            parseBlastLine(fields);
+            break;
+        case PAF:
+            parsePAFLine(fields);
+            break;
+    }
+}
+
+void HitParser::parseBlastLine(const std::string_view *fields) {
+    double percentIdentity, bitScore;
+    int alignmentLength, numberMismatches, numberGapOpens;
+    int queryStart, queryEnd, nodeStart, nodeEnd;
+    SciNot eValue;
+    if (!parseDouble(fields[2], percentIdentity) ||
+        !parseInt(fields[3], alignmentLength) ||
+        !parseInt(fields[4], numberMismatches) ||
+        !parseInt(fields[5], numberGapOpens) ||
+        !parseInt(fields[6], queryStart) ||
+        !parseInt(fields[7], queryEnd) ||
+        !parseInt(fields[8], nodeStart) ||
+        !parseInt(fields[9], nodeEnd) ||
+        !parseSciNot(fields[10], eValue) ||
+        !parseDouble(fields[11], bitScore))
+        return;
+
+    Query *query = findQuery(fields[0]);
+    if (query == nullptr)
+        return;
+
+    if (g_settings->blastEValueFilter.on &&
+        eValue > g_settings->blastEValueFilter)
+        return;
+
+    if (g_settings->blastBitScoreFilter.on &&
+        bitScore < g_settings->blastBitScoreFilter)
+        return;
+
+    // Only save BLAST hits that are on forward strands.
+    addHit(query, fields[1], nodeStart <= nodeEnd,
+           percentIdentity, alignmentLength,
+           numberMismatches, numberGapOpens,
+           queryStart, queryEnd,
+           nodeStart, nodeEnd, eValue, bitScore);
+}
+
+void HitParser::parsePAFLine(const std::string_view *fields) {
+    int queryStart, queryEnd, nodeStart, nodeEnd;
+    int matches, alignmentLength;
+    if (!parseInt(fields[2], queryStart) ||
+        !parseInt(fields[3], queryEnd) ||
+        !parseInt(fields[7], nodeStart) ||
+        !parseInt(fields[8], nodeEnd) ||
+        !parseInt(fields[9], matches) ||
+        !parseInt(fields[10], alignmentLength))
+        return;
+
+    Query *query = findQuery(fields[0]);
+    if (query == nullptr)
+        return;
+
+    // PAF coordinates are 0-based, half-open
+    double percentIdentity = alignmentLength > 0 ? 100.0 * matches / alignmentLength : 0.0;
+    addHit(query, fields[5], fields[4] == "+",
+           percentIdentity, alignmentLength,
+           -1, -1,
+           queryStart + 1, queryEnd,
+           nodeStart + 1, nodeEnd, 0, 0);
+}
+
+// Checks the user-defined filters common to all the tools and creates the
+// hits for the node or the path the label refers to
+void HitParser::addHit(Query *query, std::string_view nodeLabel, bool forwardStrand,
+                       double percentIdentity, int alignmentLength,
+                       int numberMismatches, int numberGapOpens,
+                       int queryStart, int queryEnd,
+                       int nodeStart, int nodeEnd, SciNot eValue, double bitScore) {
+    if (g_settings->blastIdentityFilter.on &&
+        percentIdentity < g_settings->blastIdentityFilter)
+        return;
+
+    if (g_settings->blastAlignmentLengthFilter.on &&
+        alignmentLength < g_settings->blastAlignmentLengthFilter)
+        return;
+
+    if (g_settings->blastQueryCoverageFilter.on) {
+        double hitCoveragePercentage = 100.0 * Hit::getQueryCoverageFraction(query,
+                                                                             queryStart, queryEnd);
+        if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
+            return;
+    }
+
+    std::string_view nodeName = getNodeNameFromLabel(nodeLabel);
+    auto nodeIt = g_assemblyGraph->m_deBruijnGraphNodes.find_ks(nodeName.data(), nodeName.size());
+    if (nodeIt != g_assemblyGraph->m_deBruijnGraphNodes.end() && forwardStrand) {
+        m_nodeHits.emplace_back(query,
+                                new Hit(query, nodeIt.value(),
+                                        percentIdentity, alignmentLength,
+                                        numberMismatches, numberGapOpens,
+                                        queryStart, queryEnd,
+                                        nodeStart, nodeEnd, eValue, bitScore));
+    }
+
+    auto pathIt = g_assemblyGraph->m_deBruijnGraphPaths.find_ks(nodeLabel.data(), nodeLabel.size());
+    if (pathIt != g_assemblyGraph->m_deBruijnGraphPaths.end()) {
+        m_pathHits.emplace_back(query, &pathIt.value(),
+                                Path::MappingRange{queryStart, queryEnd,
+                                                   nodeStart, nodeEnd});
+    }
+}
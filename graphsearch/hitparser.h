@@ -0,0 +1,93 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "hits.h"
+#include "program/scinot.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QByteArray>
+
+#include <string>
+#include <string_view>
+
+namespace search {
+
+class Queries;
+class Query;
+
+// Builds the hits from the tabular output of a search tool while it is
+// still being produced: the output is fed in chunks as it comes from the
+// process, every complete line is parsed in place and checked against the
+// hit filters right away, so the whole output is never kept in memory.
+class HitParser {
+public:
+    enum Format {
+        BLAST_TABULAR, // -outfmt 6
+        PAF,
+    };
+
+    HitParser(Format format, const Queries &queries);
+    ~HitParser();
+
+    HitParser(const HitParser &) = delete;
+    HitParser &operator=(const HitParser &) = delete;
+
+    void setFormat(Format format) { m_format = format; }
+
+    // The last line might be incomplete, it is kept until the rest of it
+    // arrives
+    void addData(std::string_view data);
+    void addData(const QByteArray &data) { addData(std::string_view(data.constData(), size_t(data.size()))); }
+    // Parses the last line if it has no newline at the end
+    void finish();
+
+    // The tools report the hits grouped by query, so this is the number of
+    // queries done so far
+    [[nodiscard]] size_t queriesSeen() const { return m_queriesSeen; }
+    [[nodiscard]] size_t hitCount() const { return m_nodeHits.size() + m_pathHits.size(); }
+
+    // Hits not taken are deleted with the parser
+    NodeHits takeNodeHits();
+    PathHits takePathHits();
+
+private:
+    void parseLine(std::string_view line);
+    void parseBlastLine(const std::string_view *fields);
+    void parsePAFLine(const std::string_view *fields);
+    Query *findQuery(std::string_view name);
+    void addHit(Query *query, std::string_view nodeLabel, bool forwardStrand,
+                double percentIdentity, int alignmentLength,
+                int numberMismatches, int numberGapOpens,
+                int queryStart, int queryEnd,
+                int nodeStart, int nodeEnd, SciNot eValue, double bitScore);
+
+    Format m_format;
+    phmap::flat_hash_map<std::string, Query *> m_queriesByName;
+    std::string m_pending;
+
+    std::string m_lastQueryName;
+    Query *m_lastQuery = nullptr;
+    size_t m_queriesSeen = 0;
+
+    NodeHits m_nodeHits;
+    PathHits m_pathHits;
+};
+
+}
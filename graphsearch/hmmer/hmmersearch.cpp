@@ -136,6 +136,10 @@ QString HmmerSearch::buildDatabase(const AssemblyGraph &graph, bool includePaths
     return m_lastError;
 }
 
+bool HmmerSearch::hasDatabase() const {
+    return QFile::exists(temporaryDir().filePath("all_nodes.fna"));
+}
+
 QString HmmerSearch::doSearch(QString extraParameters) {
     return doSearch(queries(), extraParameters);
 }
@@ -240,9 +244,12 @@ QString HmmerSearch::doOneSearch(search::QuerySequenceType sequenceType,
 
     tmpOutFile.setAutoRemove(false);
 
+    QStringList extraOptions = extraParameters.split(" ", Qt::SkipEmptyParts);
     QStringList hmmerOptions;
-    hmmerOptions << (sequenceType == search::PROTEIN ? "--domtblout" : "--tblout") << tmpOutFile.fileName()
-                 << extraParameters.split(" ", Qt::SkipEmptyParts)
+    hmmerOptions << (sequenceType == search::PROTEIN ? "--domtblout" : "--tblout") << tmpOutFile.fileName();
+    if (!extraOptions.contains("--cpu"))
+        hmmerOptions << "--cpu" << QString::number(int(g_settings->threads));
+    hmmerOptions << extraOptions
                  << tmpQueryFile.fileName()
                  << temporaryDir().filePath(sequenceType == search::PROTEIN ?
                                             "all_nodes.faa" : "all_nodes.fna");
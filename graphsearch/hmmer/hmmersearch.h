@@ -48,6 +48,7 @@ public:
     QString name() const override { return "HMMER"; }
     QString queryFormat() const override { return "HMM"; }
     QString annotationGroupName() const override { return "HMMER hits"; };
+    bool hasDatabase() const override;
 
 public slots:
     void cancelDatabaseBuild() override;
@@ -19,6 +19,7 @@
 #include "minimap2search.h"
 
 #include "graphsearch/graphsearch.h"
+#include "graphsearch/hitparser.h"
 #include "program/settings.h"
 
 #include "graph/assemblygraph.h"
@@ -27,12 +28,14 @@
 #include <QDir>
 #include <QProcess>
 #include <QTemporaryFile>
+
+#include <algorithm>
 #include <cmath>
 
 using namespace search;
 
 Minimap2Search::Minimap2Search(const QDir &workDir, QObject *parent)
-        : GraphSearch(workDir, parent) {}
+        : GraphSearch(workDir, parent), m_database(temporaryDir().path()) {}
 
 bool Minimap2Search::findTools() {
     if (!findProgram("minimap2", &m_minimap2Command)) {
@@ -54,29 +57,6 @@ QString Minimap2Search::buildDatabase(const AssemblyGraph &graph, bool includePa
 
     m_cancelBuildDatabase = false;
 
-    QFile file(temporaryDir().filePath("all_nodes.fasta"));
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-        return (m_lastError = "Failed to open: " + file.fileName());
-
-    {
-        QTextStream out(&file);
-        for (const auto *node : graph.m_deBruijnGraphNodes) {
-            if (m_cancelBuildDatabase)
-                return (m_lastError = "Build cancelled.");
-
-            out << node->getFasta(true, false, false);
-        }
-
-        if (includePaths) {
-            for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it) {
-                if (m_cancelBuildDatabase)
-                    return (m_lastError = "Build cancelled.");
-
-                out << it.value().getFasta(it.key().c_str());
-            }
-        }
-    }
-
     // Make sure the graph has sequences
     bool atLeastOneSequence = false;
     for (const auto *node : graph.m_deBruijnGraphNodes) {
@@ -89,6 +69,8 @@ QString Minimap2Search::buildDatabase(const AssemblyGraph &graph, bool includePa
     if (!atLeastOneSequence)
         return (m_lastError = "Cannot build the Minimap2 database as this graph contains no sequences");
 
+    // Only the sequences not in the cached database are written out
+    m_lastError = m_database.build(graph, includePaths, m_cancelBuildDatabase);
     return m_lastError;
 }
 
@@ -106,93 +88,6 @@ static void writeQueryFile(QFile *file,
     }
 }
 
-// FIXME: Factor out common functionality
-static QString getNodeNameFromString(const QString &nodeString) {
-    QStringList nodeStringParts = nodeString.split("_");
-
-    // The node string format should look like this:
-    // NODE_nodename_length_123_cov_1.23
-    if (nodeStringParts.size() < 6)
-        return "";
-
-    if (nodeStringParts.size() == 6)
-        return nodeStringParts[1];
-
-    // If the code got here, there are more than 6 parts.  This means there are
-    // underscores in the node name (happens a lot with Trinity graphs).  So we
-    // need to pull out the parts which constitute the name.
-    int underscoreCount = nodeStringParts.size() - 6;
-    QString nodeName = "";
-    for (int i = 0; i <= underscoreCount; ++i) {
-        nodeName += nodeStringParts[1+i];
-        if (i < underscoreCount)
-            nodeName += "_";
-    }
-
-    return nodeName;
-}
-
-static std::pair<NodeHits, PathHits>
-buildHitsFromPAF(const QString &PAF,
-                 Queries &queries) {
-    NodeHits nodeHits; PathHits pathHits;
-
-    for (const auto &hitString : PAF.split("\n", Qt::SkipEmptyParts)) {
-        QStringList alignmentParts = hitString.split('\t');
-        if (alignmentParts.size() < 12)
-            continue;
-
-        QString queryName = alignmentParts[0];
-        int queryStart = alignmentParts[2].toInt() + 1;
-        int queryEnd = alignmentParts[3].toInt();
-        bool strand = alignmentParts[4] == '+';
-
-        QString nodeLabel = alignmentParts[5];
-        int nodeStart = alignmentParts[7].toInt() + 1;
-        int nodeEnd = alignmentParts[8].toInt();
-
-        int alignmentLength = alignmentParts[10].toInt();
-
-        Query *query = queries.getQueryFromName(queryName);
-        if (query == nullptr)
-            continue;
-
-        if (g_settings->blastAlignmentLengthFilter.on &&
-            alignmentLength < g_settings->blastAlignmentLengthFilter)
-            continue;
-
-        if (g_settings->blastQueryCoverageFilter.on) {
-            double hitCoveragePercentage = 100.0 * Hit::getQueryCoverageFraction(query,
-                                                                                 queryStart, queryEnd);
-            if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
-                continue;
-        }
-
-        auto nodeIt = g_assemblyGraph->m_deBruijnGraphNodes.find(getNodeNameFromString(nodeLabel).toStdString());
-        if (nodeIt != g_assemblyGraph->m_deBruijnGraphNodes.end()) {
-            if (!strand)
-                continue;
-
-            nodeHits.emplace_back(query,
-                                  new Hit(query, nodeIt.value(),
-                                          -1, alignmentLength,
-                                          -1, -1,
-                                          queryStart, queryEnd,
-                                          nodeStart, nodeEnd, 0, 0));
-        }
-
-        auto pathIt = g_assemblyGraph->m_deBruijnGraphPaths.find(nodeLabel.toStdString());
-        if (pathIt != g_assemblyGraph->m_deBruijnGraphPaths.end()) {
-            pathHits.emplace_back(query, &pathIt.value(),
-                                  Path::MappingRange{queryStart, queryEnd,
-                                                     nodeStart, nodeEnd});
-        }
-
-    }
-
-    return { nodeHits, pathHits };
-}
-
 QString Minimap2Search::doSearch(Queries &queries, QString extraParameters) {
     GraphSearchFinishedRAII watcher(this);
 
@@ -200,8 +95,7 @@ QString Minimap2Search::doSearch(Queries &queries, QString extraParameters) {
     if (!findTools())
         return m_lastError;
 
-    // FIXME: Do we need proper mutex here?
-    if (m_doSearch)
+    if (searchInProgress())
         return (m_lastError = "Search is already in progress");
 
     for (const auto *query: queries.queries()) {
@@ -209,46 +103,41 @@ QString Minimap2Search::doSearch(Queries &queries, QString extraParameters) {
             return (m_lastError = "Cannot handle non-nucleotide query: " + query->getName() + ". Remove it and retry search.");
     }
 
+    if (m_database.empty())
+        return (m_lastError = "The Minimap2 database has not been built.");
+
     QTemporaryFile tmpFile(temporaryDir().filePath("queries.XXXXXX.fasta"));
     if (!tmpFile.open())
         return (m_lastError = "Failed to create temporary query file");
 
     writeQueryFile(&tmpFile, queries);
 
-    QStringList minimap2Options;
-    minimap2Options << extraParameters.split(" ", Qt::SkipEmptyParts)
-                    << temporaryDir().filePath("all_nodes.fasta")
-                    << tmpFile.fileName();
-
+    // minimap2 takes a single target, so every volume of the database is
+    // searched by its own process, the threads left over are given to the
+    // processes. Hits are parsed while minimap2 is still running, so the
+    // whole output is never kept in memory.
     m_cancelSearch = false;
-    m_doSearch = new QProcess();
-    m_doSearch->start(m_minimap2Command, minimap2Options);
-
-    bool finished = m_doSearch->waitForFinished(-1);
-
-    if (m_doSearch->exitCode() != 0 || !finished) {
-        if (m_cancelSearch) {
-            m_lastError = "Minimap2 search cancelled.";
-        } else {
-            m_lastError = "There was a problem running the Minimap2 search";
-            QString stdErr = m_doSearch->readAllStandardError();
-            m_lastError += stdErr.isEmpty() ? "." : ":\n\n" + stdErr;
-        }
-
-        m_doSearch->deleteLater();
-        m_doSearch = nullptr;
-
-        return m_lastError;
+    QStringList extraOptions = extraParameters.split(" ", Qt::SkipEmptyParts);
+    bool userThreads = extraOptions.contains("-t");
+    size_t volumeCount = m_database.volumes().size();
+    size_t threadsPerShard = std::max<size_t>(size_t(g_settings->threads) / volumeCount, 1);
+
+    std::vector<SearchShard> shards;
+    for (const auto &volume : m_database.volumes()) {
+        QStringList minimap2Options;
+        if (!userThreads)
+            minimap2Options << "-t" << QString::number(threadsPerShard);
+        minimap2Options << extraOptions
+                        << SearchDatabase::fastaFile(volume)
+                        << tmpFile.fileName();
+        shards.push_back({ m_minimap2Command, minimap2Options, HitParser::PAF });
     }
 
-    QString minimap2Output = m_doSearch->readAllStandardOutput();
-    m_doSearch->deleteLater();
-    m_doSearch = nullptr;
-
-    if (m_cancelSearch)
-        return (m_lastError = "Minimap2 search cancelled");
+    NodeHits nodeHits;
+    PathHits pathHits;
+    if (!runSearchShards(shards, queries, volumeCount, m_cancelSearch, nodeHits, pathHits))
+        return m_lastError;
 
-    auto [nodeHits, pathHits] = buildHitsFromPAF(minimap2Output, queries);
     queries.addNodeHits(nodeHits);
     queries.findQueryPaths();
     queries.addPathHits(pathHits);
@@ -304,19 +193,11 @@ int Minimap2Search::loadQueriesFromFile(QString fullFileName) {
 }
 
 void Minimap2Search::cancelDatabaseBuild() {
-    if (!m_buildDb)
-        return;
-
     m_cancelBuildDatabase = true;
     if (m_buildDb)
         m_buildDb->kill();
 }
 
 void Minimap2Search::cancelSearch() {
-    if (!m_doSearch)
-        return;
-
     m_cancelSearch = true;
-    if (m_doSearch)
-        m_doSearch->kill();
 }
@@ -18,10 +18,13 @@
 #pragma once
 
 #include "graphsearch/graphsearch.h"
+#include "graphsearch/searchdatabase.h"
 
 #include <QDir>
 #include <QString>
 
+#include <atomic>
+
 class QProcess;
 
 namespace search {
@@ -47,6 +50,7 @@ public:
     QString name() const override { return "Minimap2"; }
     QString queryFormat() const override { return "FASTA"; }
     QString annotationGroupName() const override { return "Minimap2 hits"; };
+    bool hasDatabase() const override { return !m_database.empty(); }
 
 public slots:
     void cancelDatabaseBuild() override;
@@ -55,9 +59,10 @@ public slots:
 private:
     bool findTools();
 
-    bool m_cancelBuildDatabase = false, m_cancelSearch = false;
+    SearchDatabase m_database;
+    std::atomic<bool> m_cancelBuildDatabase = false, m_cancelSearch = false;
 
-    QProcess *m_buildDb = nullptr, *m_doSearch = nullptr;
+    QProcess *m_buildDb = nullptr;
     QString m_minimap2Command;
 };
 
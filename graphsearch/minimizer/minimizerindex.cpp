@@ -0,0 +1,176 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "minimizerindex.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnedge.h"
+#include "graph/debruijnnode.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <string>
+
+using namespace search;
+
+// Nodes are indexed in chunks of about that many bases, a few per thread
+static constexpr size_t CHUNK_BASES = 1 << 22;
+
+// Invertible integer hash of minimap2, so the minimizers are not biased
+// towards poly-A k-mers
+uint32_t MinimizerIndex::hash(uint64_t kmer) {
+    constexpr uint64_t mask = (uint64_t(1) << (2 * K)) - 1;
+    kmer = (~kmer + (kmer << 21)) & mask;
+    kmer = kmer ^ kmer >> 24;
+    kmer = ((kmer + (kmer << 3)) + (kmer << 8)) & mask;
+    kmer = kmer ^ kmer >> 14;
+    kmer = ((kmer + (kmer << 2)) + (kmer << 4)) & mask;
+    kmer = kmer ^ kmer >> 28;
+    kmer = (kmer + (kmer << 31)) & mask;
+    return uint32_t(kmer);
+}
+
+static void indexNode(uint32_t idx, const DeBruijnNode *node,
+                      std::string &buffer, std::string &junction,
+                      std::vector<MinimizerIndex::Entry> &entries) {
+    const Sequence &sequence = node->getSequence();
+    size_t length = sequence.size();
+    if (sequence.missing())
+        return;
+
+    // Unpacked with the vectorized kernels straight from the 2-bit buffer
+    buffer.resize(length);
+    sequence.CopyNucls(buffer.data());
+    MinimizerIndex::forEachMinimizer(buffer.data(), length, [&](uint32_t hash, uint32_t pos) {
+        entries.push_back({ hash, idx, pos });
+    });
+
+    // The k-mers crossing into the following nodes. The junction starts a
+    // whole window before the end of the node, so the same k-mers are
+    // selected as in the concatenated sequence.
+    constexpr size_t span = MinimizerIndex::K + MinimizerIndex::W - 2;
+    size_t tail = std::min(length, span);
+    for (const DeBruijnEdge *edge : node->edges()) {
+        if (edge->getStartingNode() != node)
+            continue;
+
+        const Sequence &next = edge->getEndingNode()->getSequence();
+        size_t overlap = size_t(std::max(edge->getOverlap(), 0));
+        if (overlap >= next.size() || next.absent())
+            continue;
+
+        size_t head = std::min(next.size() - overlap, span);
+        junction.assign(buffer, length - tail, tail);
+        junction.resize(tail + head);
+        next.Subseq(overlap, overlap + head).CopyNucls(junction.data() + tail);
+        MinimizerIndex::forEachMinimizer(junction.data(), junction.size(), [&](uint32_t hash, uint32_t pos) {
+            if (pos < tail && pos + MinimizerIndex::K > tail)
+                entries.push_back({ hash, idx, uint32_t(length - tail + pos) });
+        });
+    }
+}
+
+bool MinimizerIndex::build(const AssemblyGraph &graph, unsigned threads,
+                           const std::atomic<bool> &cancel) {
+    clear();
+    m_graph = &graph;
+    for (auto *node : graph.m_deBruijnGraphNodes)
+        m_nodes.push_back(node);
+
+    struct Chunk {
+        uint32_t begin, end;
+        std::vector<Entry> entries;
+    };
+    std::vector<Chunk> chunks;
+    size_t bases = 0;
+    for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+        if (chunks.empty() || bases >= CHUNK_BASES) {
+            chunks.push_back({ i, i, {} });
+            bases = 0;
+        }
+        chunks.back().end = i + 1;
+        bases += m_nodes[i]->getLength();
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(std::max(threads, 1u)));
+    QtConcurrent::blockingMap(&pool, chunks, [&](Chunk &chunk) {
+        std::string buffer, junction;
+        for (uint32_t i = chunk.begin; i < chunk.end && !cancel; ++i)
+            indexNode(i, m_nodes[i], buffer, junction, chunk.entries);
+
+        // Several edges could add the same crossing k-mer
+        std::sort(chunk.entries.begin(), chunk.entries.end());
+        chunk.entries.erase(std::unique(chunk.entries.begin(), chunk.entries.end()),
+                            chunk.entries.end());
+    });
+    if (cancel) {
+        clear();
+        return false;
+    }
+
+    // The sorted chunks are concatenated and merged pairwise
+    size_t total = 0;
+    for (const auto &chunk : chunks)
+        total += chunk.entries.size();
+    m_entries.reserve(total);
+
+    std::vector<size_t> bounds{0};
+    for (auto &chunk : chunks) {
+        m_entries.insert(m_entries.end(), chunk.entries.begin(), chunk.entries.end());
+        bounds.push_back(m_entries.size());
+        std::vector<Entry>().swap(chunk.entries);
+    }
+
+    while (bounds.size() > 2) {
+        std::vector<std::pair<size_t, size_t>> merges;
+        std::vector<size_t> merged{0};
+        for (size_t i = 0; i + 2 < bounds.size(); i += 2) {
+            merges.emplace_back(i, i + 2);
+            merged.push_back(bounds[i + 2]);
+        }
+        if (bounds.size() % 2 == 0)
+            merged.push_back(bounds.back());
+
+        QtConcurrent::blockingMap(&pool, merges, [&](const std::pair<size_t, size_t> &merge) {
+            std::inplace_merge(m_entries.begin() + ptrdiff_t(bounds[merge.first]),
+                               m_entries.begin() + ptrdiff_t(bounds[merge.first + 1]),
+                               m_entries.begin() + ptrdiff_t(bounds[merge.second]));
+        });
+        bounds.swap(merged);
+    }
+
+    return true;
+}
+
+void MinimizerIndex::clear() {
+    std::vector<Entry>().swap(m_entries);
+    m_nodes.clear();
+    m_graph = nullptr;
+}
+
+std::pair<const MinimizerIndex::Entry *, const MinimizerIndex::Entry *>
+MinimizerIndex::lookup(uint32_t hash) const {
+    auto begin = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+                                  [](const Entry &entry, uint32_t h) { return entry.hash < h; });
+    auto end = std::upper_bound(begin, m_entries.end(), hash,
+                                [](uint32_t h, const Entry &entry) { return h < entry.hash; });
+    return { m_entries.data() + (begin - m_entries.begin()),
+             m_entries.data() + (end - m_entries.begin()) };
+}
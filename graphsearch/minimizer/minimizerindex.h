@@ -0,0 +1,132 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+
+namespace search {
+
+// (w,k)-minimizers of the sequences of all graph nodes, same sampling as
+// minimap2 uses. Every node is indexed on its own strand only, the reverse
+// complement strand is a node on its own. The k-mers crossing the end of a
+// node into the following nodes (after the edge overlap) are indexed as
+// well, they are attributed to the node they start in.
+class MinimizerIndex {
+public:
+    static constexpr unsigned K = 15;
+    static constexpr unsigned W = 10;
+
+    struct Entry {
+        uint32_t hash;
+        uint32_t node;
+        uint32_t pos;
+
+        bool operator<(const Entry &other) const {
+            return std::tie(hash, node, pos) < std::tie(other.hash, other.node, other.pos);
+        }
+        bool operator==(const Entry &other) const {
+            return hash == other.hash && node == other.node && pos == other.pos;
+        }
+    };
+
+    // Returns false if cancelled
+    bool build(const AssemblyGraph &graph, unsigned threads,
+               const std::atomic<bool> &cancel);
+    void clear();
+
+    [[nodiscard]] bool empty() const { return m_entries.empty(); }
+    [[nodiscard]] size_t size() const { return m_entries.size(); }
+    [[nodiscard]] DeBruijnNode *node(uint32_t idx) const { return m_nodes[idx]; }
+    [[nodiscard]] const AssemblyGraph *graph() const { return m_graph; }
+
+    // Occurrences of the minimizer with the given hash
+    [[nodiscard]] std::pair<const Entry *, const Entry *> lookup(uint32_t hash) const;
+
+    // Calls f(hash, pos) for every minimizer of the sequence. Bases other
+    // than ACGT break the k-mers.
+    template<class F>
+    static void forEachMinimizer(const char *seq, size_t length, F &&f);
+
+private:
+    static uint32_t hash(uint64_t kmer);
+
+    std::vector<Entry> m_entries;
+    std::vector<DeBruijnNode *> m_nodes;
+    const AssemblyGraph *m_graph = nullptr;
+};
+
+namespace details {
+    inline uint8_t nuclCode(char c) {
+        switch (c) {
+            case 'A': case 'a': return 0;
+            case 'C': case 'c': return 1;
+            case 'G': case 'g': return 2;
+            case 'T': case 't': return 3;
+            default: return 4;
+        }
+    }
+}
+
+template<class F>
+void MinimizerIndex::forEachMinimizer(const char *seq, size_t length, F &&f) {
+    static_assert(2 * K <= 32, "k-mers should fit into 32-bit hashes");
+    constexpr uint64_t mask = (uint64_t(1) << (2 * K)) - 1;
+
+    // Hashes of the current window in increasing order, a candidate is
+    // dropped as soon as a smaller k-mer follows it
+    std::deque<std::pair<uint32_t, uint32_t>> window;
+    uint64_t kmer = 0;
+    size_t valid = 0, last = size_t(-1);
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t c = details::nuclCode(seq[i]);
+        if (c > 3) {
+            valid = 0;
+            window.clear();
+            continue;
+        }
+
+        kmer = ((kmer << 2) | c) & mask;
+        if (++valid < K)
+            continue;
+
+        uint32_t pos = uint32_t(i + 1 - K), h = hash(kmer);
+        while (!window.empty() && window.back().first >= h)
+            window.pop_back();
+        window.emplace_back(h, pos);
+        while (window.front().second + W <= pos)
+            window.pop_front();
+
+        // Sequences shorter than a window still get their smallest k-mer
+        bool fullWindow = valid >= K + W - 1 || i + 1 == length;
+        if (fullWindow && window.front().second != last) {
+            last = window.front().second;
+            f(window.front().first, window.front().second);
+        }
+    }
+}
+
+}
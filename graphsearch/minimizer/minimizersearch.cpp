@@ -0,0 +1,319 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "minimizersearch.h"
+
+#include "graphsearch/hits.h"
+#include "program/globals.h"
+#include "program/settings.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "io/fileutils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace search;
+
+// Minimizers occurring more often than that are repeats, they would only
+// make spurious seeds
+static constexpr size_t MAX_OCCURRENCES = 1000;
+
+// Chaining parameters, same as the minimap2 defaults: the number of the
+// previous seeds tried, the largest distance and the largest gap between
+// the chained seeds, the smallest number of seeds and score of a chain
+static constexpr size_t MAX_CHAIN_ITERATIONS = 50;
+static constexpr uint32_t MAX_CHAIN_DISTANCE = 5000;
+static constexpr uint32_t MAX_CHAIN_GAP = 5000;
+static constexpr size_t MIN_CHAIN_SEEDS = 3;
+static constexpr double MIN_CHAIN_SCORE = 40;
+
+namespace {
+    struct Seed {
+        uint32_t node;
+        uint32_t nodePos;
+        uint32_t queryPos;
+
+        bool operator<(const Seed &other) const {
+            return std::tie(node, nodePos, queryPos) < std::tie(other.node, other.nodePos, other.queryPos);
+        }
+    };
+
+    struct Chain {
+        size_t first, last; // indices of the first and the last seed
+        double score;
+    };
+}
+
+MinimizerSearch::MinimizerSearch(const QDir &workDir, QObject *parent)
+        : GraphSearch(workDir, parent) {}
+
+QString MinimizerSearch::buildDatabase(const AssemblyGraph &graph, bool) {
+    DbBuildFinishedRAII watcher(this);
+    m_lastError = "";
+    m_cancelBuildDatabase = false;
+
+    // Make sure the graph has sequences
+    bool atLeastOneSequence = false;
+    for (const auto *node : graph.m_deBruijnGraphNodes) {
+        if (!node->sequenceIsMissing()) {
+            atLeastOneSequence = true;
+            break;
+        }
+    }
+
+    if (!atLeastOneSequence)
+        return (m_lastError = "Cannot build the Minimizer database as this graph contains no sequences");
+
+    // Paths are not indexed, the query paths are found from the node hits
+    if (!m_index.build(graph, g_settings->threads, m_cancelBuildDatabase))
+        return (m_lastError = "Build cancelled.");
+
+    return m_lastError;
+}
+
+QString MinimizerSearch::doSearch(QString extraParameters) {
+    return doSearch(queries(), extraParameters);
+}
+
+// Chains colinear seeds on the same node: dynamic programming over a few
+// preceding seeds with the gap cost of minimap2, then the chains are picked
+// greedily from the best scoring ends, every seed used once
+static std::vector<Chain> chainSeeds(const std::vector<Seed> &seeds, size_t begin, size_t end) {
+    size_t n = end - begin;
+    std::vector<double> score(n);
+    std::vector<ptrdiff_t> prev(n, -1);
+    for (size_t i = 0; i < n; ++i) {
+        const Seed &si = seeds[begin + i];
+        score[i] = MinimizerIndex::K;
+        for (size_t j = i; j-- > 0 && i - j <= MAX_CHAIN_ITERATIONS;) {
+            const Seed &sj = seeds[begin + j];
+            uint32_t dn = si.nodePos - sj.nodePos;
+            if (dn > MAX_CHAIN_DISTANCE)
+                break;
+            if (dn == 0 || si.queryPos <= sj.queryPos)
+                continue;
+
+            uint32_t dq = si.queryPos - sj.queryPos;
+            if (dq > MAX_CHAIN_DISTANCE)
+                continue;
+
+            uint32_t gap = dq > dn ? dq - dn : dn - dq;
+            if (gap > MAX_CHAIN_GAP)
+                continue;
+
+            double matched = std::min({ dq, dn, uint32_t(MinimizerIndex::K) });
+            double gapCost = gap ? 0.01 * MinimizerIndex::K * gap + 0.5 * std::log2(gap) : 0.0;
+            if (score[j] + matched - gapCost > score[i]) {
+                score[i] = score[j] + matched - gapCost;
+                prev[i] = ptrdiff_t(j);
+            }
+        }
+    }
+
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return score[a] > score[b]; });
+
+    std::vector<Chain> chains;
+    std::vector<bool> used(n, false);
+    for (size_t last : order) {
+        if (used[last])
+            continue;
+
+        size_t first = last, count = 0;
+        ptrdiff_t i = ptrdiff_t(last);
+        for (; i >= 0 && !used[size_t(i)]; i = prev[size_t(i)]) {
+            used[size_t(i)] = true;
+            first = size_t(i);
+            ++count;
+        }
+
+        // A chain ending in the already used seeds only counts from there
+        double chainScore = score[last] - (i >= 0 ? score[size_t(i)] : 0.0);
+        if (count >= MIN_CHAIN_SEEDS && chainScore >= MIN_CHAIN_SCORE)
+            chains.push_back({ begin + first, begin + last, chainScore });
+    }
+
+    return chains;
+}
+
+static NodeHits searchQuery(const MinimizerIndex &index, Query *query,
+                            const std::atomic<bool> &cancel) {
+    NodeHits nodeHits;
+
+    QByteArray querySequence = query->getSequence().toUpper().toLatin1();
+    std::vector<Seed> seeds;
+    MinimizerIndex::forEachMinimizer(querySequence.constData(), size_t(querySequence.size()),
+                                     [&](uint32_t hash, uint32_t queryPos) {
+        auto [begin, end] = index.lookup(hash);
+        if (size_t(end - begin) > MAX_OCCURRENCES)
+            return;
+
+        for (auto *entry = begin; entry != end; ++entry)
+            seeds.push_back({ entry->node, entry->pos, queryPos });
+    });
+    std::sort(seeds.begin(), seeds.end());
+
+    for (size_t begin = 0, end; begin < seeds.size() && !cancel; begin = end) {
+        end = begin + 1;
+        while (end < seeds.size() && seeds[end].node == seeds[begin].node)
+            ++end;
+
+        std::vector<Chain> chains = chainSeeds(seeds, begin, end);
+        if (chains.empty())
+            continue;
+
+        DeBruijnNode *node = index.node(seeds[begin].node);
+        const Sequence &nodeSequence = node->getSequence();
+        int64_t nodeLength = int64_t(nodeSequence.size()), queryLength = querySequence.size();
+        for (const Chain &chain : chains) {
+            const Seed &first = seeds[chain.first], &last = seeds[chain.last];
+            int64_t queryStart = first.queryPos, queryEnd = last.queryPos + MinimizerIndex::K;
+            int64_t nodeStart = first.nodePos, nodeEnd = last.nodePos + MinimizerIndex::K;
+
+            // The seeds crossing into the next node end past this one
+            if (nodeEnd > nodeLength) {
+                queryEnd -= nodeEnd - nodeLength;
+                nodeEnd = nodeLength;
+            }
+
+            // Seeds are only sampled, the matching bases around the chain
+            // belong to the hit as well
+            while (queryStart > 0 && nodeStart > 0 &&
+                   querySequence[queryStart - 1] == nodeSequence[size_t(nodeStart - 1)])
+                --queryStart, --nodeStart;
+            while (queryEnd < queryLength && nodeEnd < nodeLength &&
+                   querySequence[queryEnd] == nodeSequence[size_t(nodeEnd)])
+                ++queryEnd, ++nodeEnd;
+
+            // The hits are not aligned base by base, so they have neither the
+            // e-value nor the identity and the filters on them do not apply
+            int alignmentLength = int(std::max(queryEnd - queryStart, nodeEnd - nodeStart));
+            if (g_settings->blastAlignmentLengthFilter.on &&
+                alignmentLength < g_settings->blastAlignmentLengthFilter)
+                continue;
+
+            if (g_settings->blastQueryCoverageFilter.on) {
+                double hitCoveragePercentage = 100.0 * Hit::getQueryCoverageFraction(query,
+                                                                                     int(queryStart + 1), int(queryEnd));
+                if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
+                    continue;
+            }
+
+            nodeHits.emplace_back(query,
+                                  new Hit(query, node,
+                                          -1, alignmentLength,
+                                          -1, -1,
+                                          int(queryStart + 1), int(queryEnd),
+                                          int(nodeStart + 1), int(nodeEnd), NAN, chain.score));
+        }
+    }
+
+    return nodeHits;
+}
+
+// There are no parameters to pass, see allowParameters()
+QString MinimizerSearch::doSearch(Queries &queries, QString) {
+    GraphSearchFinishedRAII watcher(this);
+
+    m_lastError = "";
+    if (m_index.empty())
+        return (m_lastError = "The Minimizer database has not been built.");
+
+    for (const auto *query: queries.queries()) {
+        if (query->getSequenceType() != search::NUCLEOTIDE)
+            return (m_lastError = "Cannot handle non-nucleotide query: " + query->getName() + ". Remove it and retry search.");
+    }
+
+    m_cancelSearch = false;
+    NodeHits nodeHits;
+    for (size_t i = 0; i < queries.getQueryCount() && !m_cancelSearch; ++i) {
+        NodeHits queryHits = searchQuery(m_index, queries.query(i), m_cancelSearch);
+        nodeHits.insert(nodeHits.end(), queryHits.begin(), queryHits.end());
+        emit searchProgress(int(i + 1), int(nodeHits.size()));
+    }
+
+    if (m_cancelSearch) {
+        for (auto &hit : nodeHits)
+            delete hit.second;
+        return (m_lastError = "Minimizer search cancelled.");
+    }
+
+    queries.addNodeHits(nodeHits);
+    queries.findQueryPaths();
+    queries.searchOccurred();
+
+    return m_lastError;
+}
+
+QString MinimizerSearch::doAutoGraphSearch(const AssemblyGraph &graph, QString queriesFilename,
+                                           bool includePaths,
+                                           QString extraParameters) {
+    cleanUp();
+
+    QString maybeError = buildDatabase(graph, includePaths); // It is expected that buildDatabase will setup last error as well
+    if (!maybeError.isEmpty())
+        return maybeError;
+
+    loadQueriesFromFile(queriesFilename);
+
+    maybeError = doSearch(queries(), extraParameters);
+    if (!maybeError.isEmpty())
+        return maybeError;
+
+    return "";
+}
+
+//This function returns the number of queries loaded from the FASTA file.
+int MinimizerSearch::loadQueriesFromFile(QString fullFileName) {
+    m_lastError = "";
+    int queriesBefore = int(getQueryCount());
+
+    std::vector<QString> queryNames;
+    std::vector<QByteArray> querySequences;
+    if (!utils::readFastxFile(fullFileName, queryNames, querySequences)) {
+        m_lastError = "Failed to parse FASTA file: " + fullFileName;
+        return 0;
+    }
+
+    for (size_t i = 0; i < queryNames.size(); ++i) {
+        //We only use the part of the query name up to the first space.
+        QStringList queryNameParts = queryNames[i].split(" ");
+        QString queryName;
+        if (!queryNameParts.empty())
+            queryName = cleanQueryName(queryNameParts[0]);
+
+        addQuery(new Query(queryName, querySequences[i]));
+    }
+
+    int queriesAfter = int(getQueryCount());
+    return queriesAfter - queriesBefore;
+}
+
+void MinimizerSearch::cancelDatabaseBuild() {
+    m_cancelBuildDatabase = true;
+}
+
+void MinimizerSearch::cancelSearch() {
+    m_cancelSearch = true;
+}
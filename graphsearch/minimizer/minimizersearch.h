@@ -0,0 +1,67 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphsearch/graphsearch.h"
+#include "minimizerindex.h"
+
+#include <QDir>
+#include <QString>
+
+#include <atomic>
+
+namespace search {
+
+class Queries;
+
+// Nucleotide search without any external tools: the queries are seeded
+// with the minimizers of the graph nodes and the colinear seeds are chained
+// into hits, much like minimap2 does but without the base-level alignment.
+// The index is kept until the database is built again, so any number of
+// searches could be run against it.
+class MinimizerSearch : public GraphSearch {
+    Q_OBJECT
+public:
+    explicit MinimizerSearch(const QDir &workDir = QDir::temp(), QObject *parent = nullptr);
+    virtual ~MinimizerSearch() = default;
+
+    QString doAutoGraphSearch(const AssemblyGraph &graph, QString queriesFilename,
+                              bool includePaths = false,
+                              QString extraParameters = "") override;
+    int loadQueriesFromFile(QString fullFileName) override;
+    QString buildDatabase(const AssemblyGraph &graph,
+                          bool includePaths = true) override;
+    QString doSearch(QString extraParameters) override;
+    QString doSearch(search::Queries &queries, QString extraParameters) override;
+
+    QString name() const override { return "Minimizer"; }
+    QString queryFormat() const override { return "FASTA"; }
+    QString annotationGroupName() const override { return "Minimizer hits"; };
+    bool hasDatabase() const override { return !m_index.empty(); }
+    bool allowParameters() const override { return false; }
+
+public slots:
+    void cancelDatabaseBuild() override;
+    void cancelSearch() override;
+
+private:
+    MinimizerIndex m_index;
+    std::atomic<bool> m_cancelBuildDatabase = false, m_cancelSearch = false;
+};
+
+}
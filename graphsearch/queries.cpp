@@ -26,6 +26,10 @@
 #include "program/globals.h"
 #include "program/settings.h"
 
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
 #include <unordered_set>
 
 using namespace search;
@@ -148,10 +152,20 @@ bool Queries::isQueryPresent(const Query * query) const {
 }
 
 // This function looks at each BLAST query and tries to find a path through
-// the graph which covers the maximal amount of the query.
+// the graph which covers the maximal amount of the query. The queries only
+// read the graph, so they are done in parallel.
 void Queries::findQueryPaths() {
-    for (auto *query : m_queries)
-        query->findQueryPaths();
+    size_t threads = std::min<size_t>(g_settings->threads, m_queries.size());
+    if (threads <= 1) {
+        for (auto *query : m_queries)
+            query->findQueryPaths();
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(threads));
+    QtConcurrent::blockingMap(&pool, m_queries,
+                              [](Query *query) { query->findQueryPaths(); });
 }
 
 size_t Queries::numHits() const {
@@ -19,7 +19,10 @@
 #include "query.h"
 #include "program/settings.h"
 #include "graph/path.h"
+#include "graph/pathfinder.h"
 #include "graph/debruijnnode.h"
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <utility>
 #include <vector>
@@ -78,6 +81,32 @@ void Query::clearSearchResults() {
     m_hits.clear();
 }
 
+// Determines the minimum and maximum lengths allowed for the path covering the
+// given part of the query.
+static std::pair<int, int> allowedPathLengths(int partialQueryLength) {
+    int minLength;
+    if (g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //both on
+        minLength = std::max(int(partialQueryLength * g_settings->minLengthPercentage + 0.5), partialQueryLength + g_settings->minLengthBaseDiscrepancy);
+    else if (g_settings->minLengthPercentage.on && !g_settings->minLengthBaseDiscrepancy.on) //just relative
+        minLength = int(partialQueryLength * g_settings->minLengthPercentage + 0.5);
+    else if (!g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //just absolute
+        minLength = partialQueryLength + g_settings->minLengthBaseDiscrepancy;
+    else //neither are on
+        minLength = 1;
+
+    int maxLength;
+    if (g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //both on
+        maxLength = std::min(int(partialQueryLength * g_settings->maxLengthPercentage + 0.5), partialQueryLength + g_settings->maxLengthBaseDiscrepancy);
+    else if (g_settings->maxLengthPercentage.on && !g_settings->maxLengthBaseDiscrepancy.on) //just relative
+        maxLength = int(partialQueryLength * g_settings->maxLengthPercentage + 0.5);
+    else if (!g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //just absolute
+        maxLength = partialQueryLength + g_settings->maxLengthBaseDiscrepancy;
+    else //neither are on
+        maxLength = std::numeric_limits<int>::max();
+
+    return { minLength, maxLength };
+}
+
 // This function tries to find the paths through the graph which cover the query.
 void Query::findQueryPaths() {
     m_paths.clear();
@@ -105,20 +134,19 @@ void Query::findQueryPaths() {
             possibleEnds.push_back(hit.get());
     }
 
-    // For each possible start, find paths to each possible end.
-    QList<Path> possiblePaths;
-    for (auto start : possibleStarts) {
-        GraphLocation startLocation = start->getHitStart();
-
-        for (auto end : possibleEnds) {
-            GraphLocation endLocation = end->getHitEnd();
+    if (possibleStarts.empty() || possibleEnds.empty())
+        return;
 
-            //Assuming there is a path from the start hit to the end hit,
-            //determine the ideal length.  This is the query length minus the
-            //parts of the query not covered by the start and end.
+    // Assuming there is a path from the start hit to the end hit, determine
+    // the ideal length.  This is the query length minus the parts of the
+    // query not covered by the start and end.
+    std::vector<std::vector<std::pair<int, int>>> allowedLengths(possibleStarts.size());
+    std::vector<int> maxEndLengths(possibleEnds.size(), std::numeric_limits<int>::min());
+    for (size_t i = 0; i < possibleStarts.size(); ++i) {
+        for (size_t j = 0; j < possibleEnds.size(); ++j) {
             int partialQueryLength = queryLength;
-            int pathStart = start->m_queryStart - 1;
-            int pathEnd = end->m_queryEnd;
+            int pathStart = possibleStarts[i]->m_queryStart - 1;
+            int pathEnd = possibleEnds[j]->m_queryEnd;
             if (m_sequenceType == PROTEIN) {
                 pathStart *= 3;
                 pathEnd *= 3;
@@ -126,32 +154,31 @@ void Query::findQueryPaths() {
             partialQueryLength -= pathStart;
             partialQueryLength -= queryLength - pathEnd;
 
-            //Determine the minimum and maximum lengths allowed for the path.
-            int minLength;
-            if (g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //both on
-                minLength = std::max(int(partialQueryLength * g_settings->minLengthPercentage + 0.5), partialQueryLength + g_settings->minLengthBaseDiscrepancy);
-            else if (g_settings->minLengthPercentage.on && !g_settings->minLengthBaseDiscrepancy.on) //just relative
-                minLength = int(partialQueryLength * g_settings->minLengthPercentage + 0.5);
-            else if (!g_settings->minLengthPercentage.on && g_settings->minLengthBaseDiscrepancy.on) //just absolute
-                minLength = partialQueryLength + g_settings->minLengthBaseDiscrepancy;
-            else //neither are on
-                minLength = 1;
-
-            int maxLength;
-            if (g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //both on
-                maxLength = std::min(int(partialQueryLength * g_settings->maxLengthPercentage + 0.5), partialQueryLength + g_settings->maxLengthBaseDiscrepancy);
-            else if (g_settings->maxLengthPercentage.on && !g_settings->maxLengthBaseDiscrepancy.on) //just relative
-                maxLength = int(partialQueryLength * g_settings->maxLengthPercentage + 0.5);
-            else if (!g_settings->maxLengthPercentage.on && g_settings->maxLengthBaseDiscrepancy.on) //just absolute
-                maxLength = partialQueryLength + g_settings->maxLengthBaseDiscrepancy;
-            else //neither are on
-                maxLength = std::numeric_limits<int>::max();
-
-            possiblePaths.append(Path::getAllPossiblePaths(startLocation,
-                                                           endLocation,
-                                                           g_settings->maxQueryPathNodes - 1,
-                                                           minLength,
-                                                           maxLength));
+            auto lengths = allowedPathLengths(partialQueryLength);
+            allowedLengths[i].push_back(lengths);
+            maxEndLengths[j] = std::max(maxEndLengths[j], lengths.second);
+        }
+    }
+
+    // The bounds for the path search are computed once per end and shared
+    // by all the starts
+    std::vector<graph::PathFinder> pathFinders;
+    pathFinders.reserve(possibleEnds.size());
+    for (size_t j = 0; j < possibleEnds.size(); ++j)
+        pathFinders.emplace_back(possibleEnds[j]->getHitEnd(), g_settings->maxQueryPathNodes, maxEndLengths[j]);
+
+    // For each possible start, find paths to each possible end. The search
+    // stops with the paths found so far once the work limit is reached.
+    size_t budget = g_settings->queryPathSearchLimit > 0 ?
+                    size_t(g_settings->queryPathSearchLimit) : std::numeric_limits<size_t>::max();
+    std::vector<Path> possiblePaths;
+    bool exhausted = false;
+    for (size_t i = 0; i < possibleStarts.size() && !exhausted; ++i) {
+        GraphLocation startLocation = possibleStarts[i]->getHitStart();
+        for (size_t j = 0; j < possibleEnds.size() && !exhausted; ++j) {
+            auto [minLength, maxLength] = allowedLengths[i][j];
+            exhausted = !pathFinders[j].findPaths(startLocation, minLength, maxLength,
+                                                  budget, possiblePaths);
         }
     }
 
@@ -159,7 +186,7 @@ void Query::findQueryPaths() {
     //BLAST-specific information that the Path class doesn't.
     QList<QueryPath> blastQueryPaths;
     for (auto &possiblePath : possiblePaths)
-        blastQueryPaths.push_back(QueryPath(possiblePath, this));
+        blastQueryPaths.push_back(QueryPath(std::move(possiblePath), this));
 
     //We now want to throw out any paths for which the hits fail to meet the
     //thresholds in settings.
@@ -169,7 +196,11 @@ void Query::findQueryPaths() {
             continue;
         if (g_settings->minQueryCoveredByHits.on && blastQueryPath.getHitsQueryCoverage() < g_settings->minQueryCoveredByHits)
             continue;
-        if (g_settings->maxEValueProduct.on && blastQueryPath.getEvalueProduct() > g_settings->maxEValueProduct)
+        // Paths without e-values (e.g. the minimizer ones) are never filtered
+        // by them, see Hit::hasEValue
+        SciNot eValueProduct = blastQueryPath.getEvalueProduct();
+        if (g_settings->maxEValueProduct.on && !std::isnan(eValueProduct.toDouble()) &&
+            eValueProduct > g_settings->maxEValueProduct)
             continue;
         double idy = blastQueryPath.getMeanHitPercIdentity();
         if (g_settings->minMeanHitIdentity.on && idy >= 0 && idy < 100.0 * g_settings->minMeanHitIdentity)
@@ -25,6 +25,7 @@
 
 #include "program/globals.h"
 
+#include <cmath>
 #include <limits>
 
 using namespace search;
@@ -71,11 +72,15 @@ QueryPath::QueryPath(Path path, Query *query)
 QueryPath::QueryPath(Path path, Query *query, std::vector<const Hit *> hits)
         : m_path(std::move(path)), m_query(query), m_hits(std::move(hits)) {}
 
+//Hits without the identity are skipped, -1 means none of the hits has it.
 double QueryPath::getMeanHitPercIdentity() const {
     int totalHitLength = 0;
     double sum = 0.0;
 
     for (const auto *hit : m_hits) {
+        if (!hit->hasPercentIdentity())
+            continue;
+
         int hitLength = hit->m_alignmentLength;
         totalHitLength += hitLength;
 
@@ -83,19 +88,25 @@ double QueryPath::getMeanHitPercIdentity() const {
         sum += hitIdentity * hitLength;
     }
 
-    return totalHitLength == 0 ? 0.0 : sum / totalHitLength;
+    return totalHitLength == 0 ? -1.0 : sum / totalHitLength;
 }
 
 //This function looks at all of the hits in the path for this query and
 //multiplies the e-values together. If the hits overlap each other, then
 //this function reduces the e-values accoringly (effectively to prevent
-//the overlapping region from being counted twice).
+//the overlapping region from being counted twice). Hits without the e-value
+//are skipped, the product is NaN if none of the hits has it.
 SciNot QueryPath::getEvalueProduct() const {
     double coefficientProduct = 1.0;
     int exponentSum = 0;
+    bool anyEValue = false;
 
     for (int i = 0; i < m_hits.size(); ++i) {
         const Hit * thisHit = m_hits[i];
+        if (!thisHit->hasEValue())
+            continue;
+
+        anyEValue = true;
         SciNot thisHitEValue = thisHit->m_eValue;
         double eValueLenToRemove = 0.0;
         if (i > 0) {
@@ -120,6 +131,9 @@ SciNot QueryPath::getEvalueProduct() const {
         exponentSum += thisHitEValue.getExponent();
     }
 
+    if (!anyEValue)
+        return SciNot(NAN);
+
     return SciNot(coefficientProduct, exponentSum);
 }
 
@@ -272,9 +286,13 @@ int QueryPath::getTotalHitGapOpens() const {
 bool QueryPath::operator<(QueryPath const &other) const {
     //First we compare using the E-value product.  This seems to value stronger
     //hits as well as paths with fewer, longer hits.
+    //Paths without any e-value come after the ones with it.
     SciNot aEValueProduct = getEvalueProduct();
     SciNot bEValueProduct = other.getEvalueProduct();
-    if (aEValueProduct != bEValueProduct)
+    bool aHasEValue = !std::isnan(aEValueProduct.toDouble()), bHasEValue = !std::isnan(bEValueProduct.toDouble());
+    if (aHasEValue != bHasEValue)
+        return aHasEValue;
+    if (aHasEValue && aEValueProduct != bEValueProduct)
         return aEValueProduct < bEValueProduct;
 
     //If the code got here, then the two paths have the same e-value product,
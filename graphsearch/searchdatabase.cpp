@@ -0,0 +1,481 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "searchdatabase.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "graph/path.h"
+#include "graph/sequenceutils.h"
+#include "program/globals.h"
+#include "program/settings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+
+using namespace search;
+
+// Bumped whenever the format of the volumes changes, so stale volumes are
+// not picked up
+static constexpr const char *CACHE_VERSION = "bandage-search-cache-1";
+
+// Appending more volumes than that makes every search run over too many
+// files, the database is written from scratch instead
+static constexpr size_t MAX_VOLUMES = 8;
+
+// Number of the most recently used databases tried as the base of the
+// database of an edited graph
+static constexpr size_t MAX_BASE_CANDIDATES = 4;
+
+static constexpr const char *MANIFEST_FILE = "manifest.tsv";
+
+// A node or a path sequence. The keys of the nodes and the paths are told
+// apart by the first character, as they might have the same names.
+struct SearchDatabase::Entry {
+    std::string key;
+    uint64_t hash = 0;
+    const DeBruijnNode *node = nullptr;
+    const Path *path = nullptr;
+};
+
+static bool isIndexed(const DeBruijnNode *node) {
+    return !node->sequenceIsMissing() && node->getLength() > 0;
+}
+
+static uint64_t contentHash(const QByteArray &sequence) {
+    QByteArray digest = QCryptographicHash::hash(sequence, QCryptographicHash::Sha1);
+    return qFromLittleEndian<quint64>(digest.constData());
+}
+
+static QString volumesDirectory(const QString &root) {
+    return QDir(root).filePath("volumes");
+}
+
+static QString indexFile(const QString &root, const QString &key) {
+    return QDir(root).filePath(key + ".db");
+}
+
+// Mark as recently used
+static void touch(const QString &fileName) {
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+}
+
+static bool isComplete(const QString &volume) {
+    // The manifest is written last
+    return QFile::exists(QDir(volume).filePath(MANIFEST_FILE)) &&
+           QFile::exists(SearchDatabase::fastaFile(volume));
+}
+
+static qint64 directorySize(const QString &path) {
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+// Removes the least recently used volumes until the cache fits the limit,
+// the volumes of the current database are kept
+static void evict(const QString &root, const std::vector<QString> &current, qint64 limit) {
+    struct Volume {
+        QString path;
+        QDateTime used;
+        qint64 size;
+    };
+    std::vector<Volume> volumes;
+    QDir dir(volumesDirectory(root));
+    for (const QFileInfo &info : dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        // Volumes being written right now
+        if (info.fileName().contains('.'))
+            continue;
+
+        QFileInfo manifest(QDir(info.filePath()).filePath(MANIFEST_FILE));
+        volumes.push_back({ info.filePath(),
+                            manifest.exists() ? manifest.lastModified() : info.lastModified(),
+                            directorySize(info.filePath()) });
+    }
+    std::sort(volumes.begin(), volumes.end(),
+              [](const Volume &a, const Volume &b) { return a.used > b.used; });
+
+    qint64 total = 0;
+    for (const Volume &volume : volumes) {
+        bool inUse = std::find(current.begin(), current.end(), volume.path) != current.end();
+        if (!inUse && total + volume.size > limit) {
+            QDir(volume.path).removeRecursively();
+            continue;
+        }
+        total += volume.size;
+    }
+}
+
+// Writes the entries into a new volume, returns its directory
+static QString writeVolume(const QString &root, std::vector<const SearchDatabase::Entry *> entries,
+                           const std::atomic<bool> &cancel, QString &error) {
+    std::sort(entries.begin(), entries.end(),
+              [](const auto *a, const auto *b) { return a->key < b->key; });
+
+    QByteArray manifest;
+    for (const auto *entry : entries) {
+        manifest += QByteArray::fromStdString(entry->key) + '\t';
+        manifest += QByteArray::number(entry->hash, 16) + '\n';
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayView(CACHE_VERSION));
+    hash.addData(manifest);
+    QString key = QString::fromLatin1(hash.result().toHex());
+    QString volume = QDir(volumesDirectory(root)).filePath(key);
+    if (isComplete(volume))
+        return volume;
+
+    // Written aside and renamed, so the volume is never seen partially
+    // written, by this or any concurrent Bandage
+    QTemporaryDir tempDir(volume + ".XXXXXX");
+    if (!tempDir.isValid()) {
+        error = "Failed to create: " + tempDir.path();
+        return {};
+    }
+
+    {
+        QFile file(SearchDatabase::fastaFile(tempDir.path()));
+        if (!file.open(QIODevice::WriteOnly)) {
+            error = "Failed to open: " + file.fileName();
+            return {};
+        }
+
+        for (const auto *entry : entries) {
+            if (cancel) {
+                error = "Build cancelled.";
+                return {};
+            }
+
+            QByteArray fasta = entry->node ?
+                               entry->node->getFasta(true, false, false) :
+                               entry->path->getFasta(QString::fromStdString(entry->key.substr(1)));
+            if (file.write(fasta) != fasta.size()) {
+                error = "Failed to write: " + file.fileName();
+                return {};
+            }
+        }
+    }
+
+    {
+        QFile file(QDir(tempDir.path()).filePath(MANIFEST_FILE));
+        if (!file.open(QIODevice::WriteOnly) || file.write(manifest) != manifest.size()) {
+            error = "Failed to write: " + file.fileName();
+            return {};
+        }
+    }
+
+    tempDir.setAutoRemove(false);
+    if (!QDir().rename(tempDir.path(), volume)) {
+        QDir(tempDir.path()).removeRecursively();
+        // Someone else was writing the same volume
+        if (!isComplete(volume)) {
+            error = "Failed to create: " + volume;
+            return {};
+        }
+    }
+
+    return volume;
+}
+
+SearchDatabase::SearchDatabase(QString fallbackDirectory)
+        : m_fallbackDirectory(std::move(fallbackDirectory)) {}
+
+QString SearchDatabase::cacheDirectory() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("search");
+}
+
+QString SearchDatabase::fastaFile(const QString &volume) {
+    return QDir(volume).filePath("sequences.fasta");
+}
+
+QString SearchDatabase::directory() const {
+    return g_settings->searchCacheSize != 0 ? cacheDirectory() : m_fallbackDirectory;
+}
+
+void SearchDatabase::clear() {
+    m_root.clear();
+    m_key.clear();
+    m_volumes.clear();
+    m_contents.clear();
+    m_contentsLoaded = false;
+    m_sequencesWritten = 0;
+}
+
+QString SearchDatabase::build(const AssemblyGraph &graph, bool includePaths,
+                              const std::atomic<bool> &cancel) {
+    m_sequencesWritten = 0;
+
+    QString root = directory();
+    if (!QDir().mkpath(volumesDirectory(root)))
+        return "Failed to create: " + volumesDirectory(root);
+
+    std::vector<Entry> entries;
+    for (const auto *node : graph.m_deBruijnGraphNodes) {
+        if (isIndexed(node))
+            entries.push_back({ 'N' + std::string(node->getNameView()), 0, node, nullptr });
+    }
+    if (includePaths) {
+        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
+            entries.push_back({ 'P' + it.key(), 0, nullptr, &it.value() });
+    }
+
+    if (entries.empty())
+        return "Cannot build the database as this graph contains no sequences";
+
+    // Hashing the sequences is the most of the work when the database is
+    // already there
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(g_settings->threads));
+        QtConcurrent::blockingMap(&pool, entries, [&](Entry &entry) {
+            if (cancel)
+                return;
+            entry.hash = contentHash(entry.node ?
+                                     utils::sequenceToQByteArray(entry.node->getSequence()) :
+                                     entry.path->getPathSequence());
+        });
+    }
+    if (cancel)
+        return "Build cancelled.";
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayView(CACHE_VERSION));
+    hash.addData(QByteArrayView(includePaths ? "\tpaths\n" : "\tnodes\n"));
+    for (const auto &entry : entries) {
+        hash.addData(QByteArrayView(entry.key.data(), qsizetype(entry.key.size())));
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(&entry.hash), sizeof(entry.hash)));
+    }
+    QString key = QString::fromLatin1(hash.result().toHex());
+
+    // Same graph was searched before
+    if (loadIndex(root, key)) {
+        m_includePaths = includePaths;
+        return "";
+    }
+
+    // Only the sequences not in the current database are written
+    std::vector<const Entry *> added;
+    std::vector<bool> staleVolumes;
+    bool incremental;
+    if (!m_volumes.empty() && m_root == root) {
+        incremental = m_includePaths == includePaths &&
+                      m_volumes.size() < MAX_VOLUMES &&
+                      loadContents() &&
+                      findAdded(entries, added, staleVolumes);
+    } else {
+        // The GUI makes a new search after every edit of the graph, so the
+        // database of the graph before the edit has to be found in the cache
+        incremental = loadBase(root, entries, added, staleVolumes);
+    }
+    if (incremental) {
+        dropVolumes(staleVolumes);
+    } else {
+        clear();
+        added.clear();
+        for (const auto &entry : entries)
+            added.push_back(&entry);
+    }
+
+    if (!added.empty()) {
+        QString error;
+        QString volume = writeVolume(root, added, cancel, error);
+        if (volume.isEmpty()) {
+            clear();
+            return error;
+        }
+
+        m_volumes.push_back(volume);
+        for (const auto *entry : added)
+            m_contents[entry->key] = { entry->hash, uint32_t(m_volumes.size() - 1) };
+    }
+
+    m_root = root;
+    m_key = key;
+    m_includePaths = includePaths;
+    m_contentsLoaded = true;
+    m_sequencesWritten = added.size();
+
+    // The index is written aside and renamed as well
+    QStringList volumeKeys;
+    for (const auto &volume : m_volumes)
+        volumeKeys << QFileInfo(volume).fileName();
+    QString fileName = indexFile(root, key), tempFileName = fileName + ".tmp";
+    QFile file(tempFileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(volumeKeys.join('\n').toLatin1() + '\n');
+        file.close();
+        QFile::remove(fileName);
+        if (!QFile::rename(tempFileName, fileName))
+            QFile::remove(tempFileName);
+    }
+
+    if (g_settings->searchCacheSize != 0)
+        evict(root, m_volumes, qint64(g_settings->searchCacheSize) * 1024 * 1024);
+
+    return "";
+}
+
+bool SearchDatabase::loadIndex(const QString &root, const QString &key) {
+    QFile file(indexFile(root, key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    std::vector<QString> volumes;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (line.isEmpty())
+            continue;
+
+        QString volume = QDir(volumesDirectory(root)).filePath(QString::fromLatin1(line));
+        // Some of the volumes were evicted
+        if (!isComplete(volume)) {
+            file.remove();
+            return false;
+        }
+        volumes.push_back(volume);
+    }
+    if (volumes.empty())
+        return false;
+
+    for (const auto &volume : volumes)
+        touch(QDir(volume).filePath(MANIFEST_FILE));
+    file.close();
+    touch(file.fileName());
+
+    bool sameVolumes = m_root == root && m_volumes == volumes;
+    m_root = root;
+    m_key = key;
+    m_volumes = std::move(volumes);
+    if (!sameVolumes) {
+        m_contents.clear();
+        m_contentsLoaded = false;
+    }
+
+    return true;
+}
+
+bool SearchDatabase::loadBase(const QString &root, const std::vector<Entry> &entries,
+                              std::vector<const Entry *> &added, std::vector<bool> &staleVolumes) {
+    // The index files are touched when used, so the latest ones come first
+    QFileInfoList indices = QDir(root).entryInfoList({ "*.db" }, QDir::Files, QDir::Time);
+    for (qsizetype i = 0; i < indices.size() && size_t(i) < MAX_BASE_CANDIDATES; ++i) {
+        clear();
+        added.clear();
+        if (loadIndex(root, indices[i].completeBaseName()) &&
+            m_volumes.size() < MAX_VOLUMES &&
+            loadContents() &&
+            findAdded(entries, added, staleVolumes))
+            return true;
+    }
+
+    clear();
+    added.clear();
+    return false;
+}
+
+bool SearchDatabase::loadContents() {
+    if (m_contentsLoaded)
+        return true;
+
+    m_contents.clear();
+    for (size_t i = 0; i < m_volumes.size(); ++i) {
+        QFile file(QDir(m_volumes[i]).filePath(MANIFEST_FILE));
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        for (const QByteArray &line : file.readAll().split('\n')) {
+            qsizetype tab = line.lastIndexOf('\t');
+            if (tab < 0)
+                continue;
+
+            bool ok = false;
+            uint64_t hash = line.mid(tab + 1).toULongLong(&ok, 16);
+            if (!ok)
+                return false;
+            m_contents[line.left(tab).toStdString()] = { hash, uint32_t(i) };
+        }
+    }
+
+    m_contentsLoaded = true;
+    return true;
+}
+
+bool SearchDatabase::findAdded(const std::vector<Entry> &entries, std::vector<const Entry *> &added,
+                               std::vector<bool> &staleVolumes) const {
+    // A sequence no longer in the graph (a removed node, a node name reused
+    // for some other sequence, a path not searched) would still be searched
+    // and would change the database size the BLAST statistics depend on. So
+    // the volumes with any of them are written again with only the live
+    // sequences, the rest are kept as they are.
+    staleVolumes.assign(m_volumes.size(), false);
+    for (const auto &content : m_contents) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), content.first,
+                                   [](const Entry &entry, const std::string &key) { return entry.key < key; });
+        if (it == entries.end() || it->key != content.first || it->hash != content.second.hash)
+            staleVolumes[content.second.volume] = true;
+    }
+
+    size_t kept = 0;
+    for (const auto &entry : entries) {
+        auto it = m_contents.find(entry.key);
+        if (it == m_contents.end() || it->second.hash != entry.hash || staleVolumes[it->second.volume]) {
+            added.push_back(&entry);
+            continue;
+        }
+        ++kept;
+    }
+
+    // Nothing left to build upon
+    return kept != 0;
+}
+
+void SearchDatabase::dropVolumes(const std::vector<bool> &staleVolumes) {
+    std::vector<QString> volumes;
+    std::vector<uint32_t> newIndex(m_volumes.size());
+    for (size_t i = 0; i < m_volumes.size(); ++i) {
+        if (staleVolumes[i])
+            continue;
+        newIndex[i] = uint32_t(volumes.size());
+        volumes.push_back(m_volumes[i]);
+    }
+    if (volumes.size() == m_volumes.size())
+        return;
+
+    m_volumes = std::move(volumes);
+    phmap::erase_if(m_contents, [&](const auto &content) { return staleVolumes[content.second.volume]; });
+    for (auto &content : m_contents)
+        content.second.volume = newIndex[content.second.volume];
+}
@@ -0,0 +1,110 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AssemblyGraph;
+
+namespace search {
+
+// The graph sequences written out for the external search tools. They are
+// kept in the user cache directory, so the same graph searched again (in
+// this session or any later one) does not write them again.
+//
+// A database is a list of volumes, every volume is a FASTA file with the
+// sequences of some nodes (and paths) and a manifest of their names and
+// content hashes. The database of a graph is found by the hash of all its
+// sequences. After the graph was edited only the nodes not in the database
+// yet are written into a new volume. A volume with any sequence no longer in
+// the graph is dropped and its live sequences go into the new volume too, so
+// the search never sees stale sequences and gives the same hits (and the
+// same e-values) as the database written from scratch. Once too many
+// volumes pile up or no volume is left to keep, the database is written from
+// scratch. A new database object starts from the most recently used
+// database it can be added to, so the edits are picked up across searches
+// and sessions.
+//
+// The least recently used volumes are evicted once the cache exceeds
+// g_settings->searchCacheSize. With the cache disabled the volumes are
+// written into the given fallback directory instead.
+class SearchDatabase {
+public:
+    explicit SearchDatabase(QString fallbackDirectory);
+
+    // Directory the cached databases are stored in
+    static QString cacheDirectory();
+    // FASTA file with the sequences of the volume
+    static QString fastaFile(const QString &volume);
+
+    // Makes the database of the graph. Returns an error, empty on success.
+    QString build(const AssemblyGraph &graph, bool includePaths,
+                  const std::atomic<bool> &cancel);
+    void clear();
+
+    [[nodiscard]] bool empty() const { return m_volumes.empty(); }
+    // Directories of the volumes
+    [[nodiscard]] const std::vector<QString> &volumes() const { return m_volumes; }
+    [[nodiscard]] const QString &key() const { return m_key; }
+    // Number of the sequences the last build had to write out
+    [[nodiscard]] size_t sequencesWritten() const { return m_sequencesWritten; }
+
+    // A sequence written into the database
+    struct Entry;
+
+private:
+    QString directory() const;
+    bool loadIndex(const QString &root, const QString &key);
+    // Loads the most recently used database the graph can be added to
+    bool loadBase(const QString &root, const std::vector<Entry> &entries,
+                  std::vector<const Entry *> &added, std::vector<bool> &staleVolumes);
+    bool loadContents();
+    // Finds the entries to write and the volumes to drop, those with
+    // sequences no longer in the graph. Returns false if the database is
+    // not worth building upon.
+    bool findAdded(const std::vector<Entry> &entries, std::vector<const Entry *> &added,
+                   std::vector<bool> &staleVolumes) const;
+    void dropVolumes(const std::vector<bool> &staleVolumes);
+
+    QString m_fallbackDirectory;
+
+    // Current database
+    QString m_root, m_key;
+    bool m_includePaths = false;
+    std::vector<QString> m_volumes;
+
+    // Content hashes of all the sequences in the volumes and the indices of
+    // the volumes they are in, loaded from the manifests when needed
+    struct Content {
+        uint64_t hash;
+        uint32_t volume;
+    };
+    phmap::flat_hash_map<std::string, Content> m_contents;
+    bool m_contentsLoaded = false;
+
+    size_t m_sequencesWritten = 0;
+};
+
+}
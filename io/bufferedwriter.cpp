@@ -0,0 +1,250 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bufferedwriter.h"
+
+#include <QtConcurrent>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace io;
+
+struct BufferedWriter::GzipStream {
+    z_stream stream{};
+    std::vector<unsigned char> out = std::vector<unsigned char>(1 << 20);
+
+    ~GzipStream() { deflateEnd(&stream); }
+};
+
+namespace {
+    // Uncompressed data per BGZF block, leaves space for the header and the
+    // footer even if the data turns out to be incompressible
+    constexpr size_t BGZF_BLOCK_SIZE = 0xff00;
+    constexpr size_t BGZF_MAX_BLOCK_SIZE = 0x10000;
+    constexpr size_t BGZF_HEADER_SIZE = 18;
+    constexpr size_t BGZF_FOOTER_SIZE = 8;
+
+    // Empty block marking the end of the file
+    constexpr char BGZF_EOF[28] = {
+        '\x1f', '\x8b', '\x08', '\x04', '\0', '\0', '\0', '\0', '\0', '\xff', '\x06', '\0', 'B', 'C',
+        '\x02', '\0', '\x1b', '\0', '\x03', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0'
+    };
+
+    void storeLE(unsigned char *dst, uint32_t value, unsigned bytes) {
+        for (unsigned i = 0; i < bytes; ++i)
+            dst[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    // Compresses the data as a single gzip member with the BGZF extra field
+    QByteArray compressBgzfBlock(const char *data, size_t size) {
+        QByteArray block(BGZF_MAX_BLOCK_SIZE, Qt::Uninitialized);
+        auto *out = reinterpret_cast<unsigned char *>(block.data());
+
+        for (int level : { Z_DEFAULT_COMPRESSION, Z_NO_COMPRESSION }) {
+            z_stream stream{};
+            if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return {};
+
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            stream.avail_in = uInt(size);
+            stream.next_out = out + BGZF_HEADER_SIZE;
+            stream.avail_out = uInt(BGZF_MAX_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE);
+            int ret = deflate(&stream, Z_FINISH);
+            size_t compressedSize = stream.total_out;
+            deflateEnd(&stream);
+
+            // Did not fit, store it uncompressed
+            if (ret != Z_STREAM_END)
+                continue;
+
+            size_t blockSize = BGZF_HEADER_SIZE + compressedSize + BGZF_FOOTER_SIZE;
+            std::memcpy(out, BGZF_EOF, BGZF_HEADER_SIZE - 2);
+            storeLE(out + 16, uint32_t(blockSize - 1), 2);
+            storeLE(out + BGZF_HEADER_SIZE + compressedSize,
+                    uint32_t(crc32(0, reinterpret_cast<const Bytef *>(data), uInt(size))), 4);
+            storeLE(out + BGZF_HEADER_SIZE + compressedSize + 4, uint32_t(size), 4);
+
+            block.resize(qsizetype(blockSize));
+            return block;
+        }
+
+        return {};
+    }
+}
+
+BufferedWriter::BufferedWriter()
+        : buffer_(new char[BUFFER_SIZE]), pending_(new char[BUFFER_SIZE]) {}
+
+BufferedWriter::~BufferedWriter() {
+    if (file_.isOpen())
+        close();
+}
+
+bool BufferedWriter::open(const QString &filename, Compression compression) {
+    if (compression == Compression::Auto)
+        compression = filename.endsWith(".gz") ? Compression::Gzip : Compression::None;
+
+    compression_ = compression;
+    used_ = 0;
+    ok_ = true;
+
+    file_.setFileName(filename);
+    if (!file_.open(QIODevice::WriteOnly))
+        return false;
+
+    if (compression_ == Compression::Gzip) {
+        gzip_ = std::make_unique<GzipStream>();
+        // 16 selects the gzip wrapper
+        if (deflateInit2(&gzip_->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            file_.close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BufferedWriter::close() {
+    if (!file_.isOpen())
+        return false;
+
+    flush();
+    waitForPendingWrite();
+
+    if (compression_ == Compression::Gzip)
+        ok_ &= writeGzip(nullptr, 0, true);
+    else if (compression_ == Compression::Bgzf)
+        ok_ &= file_.write(BGZF_EOF, sizeof(BGZF_EOF)) == qint64(sizeof(BGZF_EOF));
+    gzip_.reset();
+
+    ok_ &= file_.flush();
+    file_.close();
+
+    return ok_;
+}
+
+void BufferedWriter::write(const char *data, size_t size) {
+    while (size) {
+        if (used_ == BUFFER_SIZE)
+            flush();
+
+        size_t chunk = std::min(size, BUFFER_SIZE - used_);
+        std::memcpy(buffer_.get() + used_, data, chunk);
+        used_ += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+BufferedWriter &BufferedWriter::operator<<(double value) {
+    char *dst = reserve(32);
+#if defined(__cpp_lib_to_chars)
+    used_ = size_t(std::to_chars(dst, dst + 32, value, std::chars_format::general, 6).ptr - buffer_.get());
+#else
+    // Floating point std::to_chars is not available everywhere, QByteArray
+    // formatting is locale-independent as well
+    QByteArray str = QByteArray::number(value, 'g', 6);
+    std::memcpy(dst, str.constData(), size_t(str.size()));
+    used_ += size_t(str.size());
+#endif
+    return *this;
+}
+
+void BufferedWriter::waitForPendingWrite() {
+    if (!pendingWrite_.isValid())
+        return;
+
+    ok_ &= pendingWrite_.result();
+    pendingWrite_ = {};
+}
+
+void BufferedWriter::flush() {
+    if (!file_.isOpen()) {
+        ok_ = false;
+        used_ = 0;
+        return;
+    }
+
+    // Double buffering: the previous buffer must be written before it could
+    // be reused
+    waitForPendingWrite();
+    if (!used_)
+        return;
+
+    std::swap(buffer_, pending_);
+    const char *data = pending_.get();
+    size_t size = used_;
+    used_ = 0;
+    pendingWrite_ = QtConcurrent::run([this, data, size] { return writeData(data, size); });
+}
+
+bool BufferedWriter::writeData(const char *data, size_t size) {
+    switch (compression_) {
+        case Compression::Gzip:
+            return writeGzip(data, size, false);
+        case Compression::Bgzf:
+            return writeBgzf(data, size);
+        default:
+            return file_.write(data, qint64(size)) == qint64(size);
+    }
+}
+
+bool BufferedWriter::writeGzip(const char *data, size_t size, bool finish) {
+    z_stream &stream = gzip_->stream;
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = uInt(size);
+
+    while (true) {
+        stream.next_out = gzip_->out.data();
+        stream.avail_out = uInt(gzip_->out.size());
+        int ret = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR)
+            return false;
+
+        auto compressed = qint64(gzip_->out.size() - stream.avail_out);
+        if (compressed && file_.write(reinterpret_cast<const char *>(gzip_->out.data()), compressed) != compressed)
+            return false;
+
+        // Without flushing everything is consumed once there is output space left
+        if (finish ? ret == Z_STREAM_END : stream.avail_out != 0)
+            return true;
+    }
+}
+
+bool BufferedWriter::writeBgzf(const char *data, size_t size) {
+    std::vector<size_t> offsets;
+    for (size_t offset = 0; offset < size; offset += BGZF_BLOCK_SIZE)
+        offsets.push_back(offset);
+
+    // Blocks are independent, compress them in parallel
+    QList<QByteArray> blocks = QtConcurrent::blockingMapped<QList<QByteArray>>(
+            offsets, [&](size_t offset) {
+                return compressBgzfBlock(data + offset, std::min(BGZF_BLOCK_SIZE, size - offset));
+            });
+
+    for (const auto &block : blocks) {
+        if (block.isEmpty() || file_.write(block) != block.size())
+            return false;
+    }
+
+    return true;
+}
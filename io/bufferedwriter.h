@@ -0,0 +1,124 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QFuture>
+#include <QString>
+
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+namespace io {
+    enum class Compression {
+        None,
+        // Single gzip stream
+        Gzip,
+        // Blocked gzip as used by samtools / htslib: a series of independent
+        // gzip members, compressed in parallel. Readable by any gzip reader.
+        Bgzf,
+        // Gzip if the filename ends with .gz, otherwise none
+        Auto
+    };
+
+    // Buffered output file. Text is formatted straight into a large buffer,
+    // full buffers are compressed (if requested) and written on a background
+    // thread while the next one is being filled.
+    class BufferedWriter {
+    public:
+        static constexpr size_t BUFFER_SIZE = 4 << 20;
+
+        BufferedWriter();
+        ~BufferedWriter();
+        BufferedWriter(const BufferedWriter &) = delete;
+        BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+        bool open(const QString &filename, Compression compression = Compression::Auto);
+        // Writes out everything and closes the file. Returns false if
+        // anything failed since open().
+        bool close();
+
+        void write(const char *data, size_t size);
+
+        BufferedWriter &operator<<(std::string_view str) {
+            write(str.data(), str.size());
+            return *this;
+        }
+        BufferedWriter &operator<<(const char *str) {
+            return *this << std::string_view(str);
+        }
+        BufferedWriter &operator<<(const QByteArray &str) {
+            write(str.constData(), size_t(str.size()));
+            return *this;
+        }
+        BufferedWriter &operator<<(char c) {
+            *reserve(1) = c;
+            used_ += 1;
+            return *this;
+        }
+
+        template<class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> &&
+                                           !std::is_same_v<T, bool>, int> = 0>
+        BufferedWriter &operator<<(T value) {
+            char *dst = reserve(24);
+            used_ = size_t(std::to_chars(dst, dst + 24, value).ptr - buffer_.get());
+            return *this;
+        }
+
+        // Same as printf's %g, i.e. the shortest of fixed and scientific
+        // notation with 6 significant digits
+        BufferedWriter &operator<<(double value);
+        BufferedWriter &operator<<(float value) {
+            return *this << double(value);
+        }
+
+        // Direct access to the buffer: returns the space for (at most
+        // BUFFER_SIZE) bytes that become a part of the output by commit()
+        char *reserve(size_t size) {
+            if (BUFFER_SIZE - used_ < size)
+                flush();
+            return buffer_.get() + used_;
+        }
+        void commit(size_t size) {
+            used_ += size;
+        }
+
+    private:
+        void flush();
+        void waitForPendingWrite();
+        bool writeData(const char *data, size_t size);
+        bool writeGzip(const char *data, size_t size, bool finish);
+        bool writeBgzf(const char *data, size_t size);
+
+        QFile file_;
+        Compression compression_ = Compression::None;
+        struct GzipStream;
+        std::unique_ptr<GzipStream> gzip_;
+
+        std::unique_ptr<char[]> buffer_;
+        size_t used_ = 0;
+        // Buffer being written by the background task
+        std::unique_ptr<char[]> pending_;
+        QFuture<bool> pendingWrite_;
+        bool ok_ = true;
+    };
+}
@@ -0,0 +1,171 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "fmelayouter.h"
+
+#include "ogdf/basic/GraphAttributes.h"
+#include "ogdf/energybased/FastMultipoleEmbedder.h"
+#include "ogdf/energybased/fast_multipole_embedder/GalaxyMultilevel.h"
+
+#include <cmath>
+#include <vector>
+
+using ogdf::fast_multipole_embedder::GalaxyMultilevel;
+using ogdf::fast_multipole_embedder::GalaxyMultilevelBuilder;
+
+namespace {
+    // The graph is coarsened until the coarsest level is that small
+    constexpr int COARSEST_LEVEL_NODES = 10;
+
+    // Coarse positions are spread out a bit before refining, as the finer
+    // level needs more space
+    constexpr float LEVEL_SCALE = 1.4f;
+
+    // Hierarchy of galaxy merging levels, finest first. The finest level
+    // refers to the original graph, the rest are owned.
+    class Levels {
+    public:
+        explicit Levels(ogdf::Graph &G) {
+            m_levels.push_back(new GalaxyMultilevel(&G));
+        }
+
+        ~Levels() {
+            for (size_t i = 0; i < m_levels.size(); ++i) {
+                delete m_levels[i]->m_pNodeInfo;
+                delete m_levels[i]->m_pEdgeInfo;
+                if (i > 0)
+                    delete m_levels[i]->m_pGraph;
+                delete m_levels[i];
+            }
+        }
+
+        Levels(const Levels &) = delete;
+        Levels &operator=(const Levels &) = delete;
+
+        GalaxyMultilevel &operator[](size_t level) { return *m_levels[level]; }
+        size_t size() const { return m_levels.size(); }
+
+        void coarsen() {
+            int nodes = m_levels.back()->m_pGraph->numberOfNodes();
+            while (nodes > COARSEST_LEVEL_NODES) {
+                GalaxyMultilevelBuilder builder;
+                m_levels.push_back(builder.build(m_levels.back()));
+
+                // Stop if there is nothing left to merge
+                int coarserNodes = m_levels.back()->m_pGraph->numberOfNodes();
+                if (coarserNodes == nodes)
+                    break;
+                nodes = coarserNodes;
+            }
+        }
+
+    private:
+        std::vector<GalaxyMultilevel *> m_levels;
+    };
+
+    // Iterations of the embedder at the given level (0 is the finest) for
+    // the layout quality. Coarse levels are cheap and decide the overall
+    // shape, so they get more.
+    uint32_t iterations(size_t level, int graphLayoutQuality) {
+        static constexpr uint32_t PER_QUALITY[] = { 25, 50, 100, 200, 400 };
+        return PER_QUALITY[graphLayoutQuality] * uint32_t((level + 1) * (level + 1));
+    }
+}
+
+FMEGraphLayout::FMEGraphLayout(unsigned threads, int graphLayoutQuality, bool useLinearLayout,
+                               double graphLayoutComponentSeparation, double aspectRatio)
+        : GraphLayouter(graphLayoutQuality, useLinearLayout, graphLayoutComponentSeparation, aspectRatio),
+          m_threads(threads) {}
+
+void FMEGraphLayout::init() {
+    m_cancelled = false;
+}
+
+// The embedder could not be interrupted, so the cancellation takes effect
+// between the levels
+void FMEGraphLayout::cancel() {
+    m_cancelled = true;
+}
+
+void FMEGraphLayout::run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) {
+    const ogdf::Graph &G = GA.constGraph();
+    if (G.empty())
+        return;
+
+    // The builder does not modify the graph, it just creates the coarser ones
+    Levels levels(const_cast<ogdf::Graph &>(G));
+    auto &nodeInfo = *levels[0].m_pNodeInfo;
+    auto &edgeInfo = *levels[0].m_pEdgeInfo;
+    for (ogdf::node v : G.nodes) {
+        nodeInfo[v].mass = 1.0f;
+        nodeInfo[v].radius = float(std::hypot(GA.width(v), GA.height(v)) / 2);
+    }
+    for (ogdf::edge e : G.edges)
+        edgeInfo[e].length = float(edges[e]);
+    levels.coarsen();
+
+    ogdf::NodeArray<float> x, y, prevX, prevY, nodeSizes;
+    ogdf::EdgeArray<float> edgeLengths;
+    for (size_t level = levels.size(); level-- > 0; ) {
+        const GalaxyMultilevel &current = levels[level];
+        const ogdf::Graph &levelGraph = *current.m_pGraph;
+
+        x.init(levelGraph);
+        y.init(levelGraph);
+        nodeSizes.init(levelGraph);
+        for (ogdf::node v : levelGraph.nodes) {
+            const auto &info = (*current.m_pNodeInfo)[v];
+            nodeSizes[v] = info.radius;
+            if (level + 1 == levels.size())
+                continue;
+
+            // Start from the position of the sun of the coarser level
+            x[v] = (prevX[info.parent] + float(ogdf::randomDouble(-1.0, 1.0))) * LEVEL_SCALE;
+            y[v] = (prevY[info.parent] + float(ogdf::randomDouble(-1.0, 1.0))) * LEVEL_SCALE;
+        }
+
+        edgeLengths.init(levelGraph);
+        for (ogdf::edge e : levelGraph.edges)
+            edgeLengths[e] = (*current.m_pEdgeInfo)[e].length;
+
+        if (!m_cancelled) {
+            ogdf::FastMultipoleEmbedder embedder;
+            embedder.setNumberOfThreads(m_threads);
+            embedder.setRandomize(level + 1 == levels.size());
+            embedder.setNumIterations(iterations(level, m_graphLayoutQuality));
+            embedder.call(levelGraph, x, y, edgeLengths, nodeSizes);
+        }
+
+        std::swap(x, prevX);
+        std::swap(y, prevY);
+    }
+
+    // The embedder does not keep the absolute scale of the edge lengths.
+    // Scale the result, so it matches the components laid out by FMMM.
+    double desiredLength = 0, actualLength = 0;
+    for (ogdf::edge e : G.edges) {
+        desiredLength += edges[e];
+        actualLength += std::hypot(prevX[e->source()] - prevX[e->target()],
+                                   prevY[e->source()] - prevY[e->target()]);
+    }
+    double scale = actualLength > 0 ? desiredLength / actualLength : 1.0;
+
+    for (ogdf::node v : G.nodes) {
+        GA.x(v) = prevX[v] * scale;
+        GA.y(v) = prevY[v] * scale;
+    }
+}
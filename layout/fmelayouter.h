@@ -0,0 +1,45 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlayoutworker.h"
+
+#include <atomic>
+
+// Multilevel layout by OGDF's fast multipole embedder. The graph is
+// coarsened by galaxy merging (same as FastMultipoleMultilevelEmbedder
+// does) and every level is laid out with the force computation split
+// between several threads. Unlike FastMultipoleMultilevelEmbedder (which
+// derives them from the node sizes) this uses the given edge lengths.
+class FMEGraphLayout : public GraphLayouter {
+public:
+    // Zero threads means as many as there are cores
+    FMEGraphLayout(unsigned threads,
+                   int graphLayoutQuality,
+                   bool useLinearLayout,
+                   double graphLayoutComponentSeparation,
+                   double aspectRatio = 1.333333);
+
+    void init() override;
+    void cancel() override;
+    void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) override;
+
+private:
+    unsigned m_threads;
+    std::atomic<bool> m_cancelled = false;
+};
@@ -17,23 +17,30 @@
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "graphlayoutworker.h"
+#include "multilevellayouter.h"
+#include "fmelayouter.h"
 #include "graph/assemblygraph.h"
 #include "graph/debruijnnode.h"
 #include "graph/debruijnedge.h"
 
 #include "program/settings.h"
 
-#include "ogdf/basic/GraphCopy.h"
 #include "ogdf/basic/simple_graph_alg.h"
 #include "ogdf/energybased/FMMMLayout.h"
 #include "ogdf/energybased/fmmm/MAARPacking.h"
-#include "ogdf/energybased/FastMultipoleEmbedder.h"
 #include "ogdf/energybased/fmmm/FMMMOptions.h"
 
 #include <QFutureSynchronizer>
+#include <QThreadPool>
 #include <QtConcurrent>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <ctime>
+#include <limits>
+#include <numeric>
+#include <vector>
 
 GraphLayouter::GraphLayouter(int graphLayoutQuality, bool useLinearLayout,
                              double graphLayoutComponentSeparation, double aspectRatio)
@@ -43,12 +50,53 @@ GraphLayouter::GraphLayouter(int graphLayoutQuality, bool useLinearLayout,
             m_aspectRatio(aspectRatio)
 {}
 
+void GraphLayouter::initFMMM(ogdf::FMMMLayout &layout) const {
+    layout.randSeed(clock());
+    layout.useHighLevelOptions(false);
+    layout.unitEdgeLength(1.0);
+    layout.allowedPositions(ogdf::FMMMOptions::AllowedPositions::All);
+    layout.pageRatio(m_aspectRatio);
+    layout.minDistCC(m_graphLayoutComponentSeparation);
+    layout.stepsForRotatingComponents(50); // Helps to make linear graph components more horizontal.
+    layout.initialPlacementForces(m_useLinearLayout ?
+                                  ogdf::FMMMOptions::InitialPlacementForces::KeepPositions :
+                                  ogdf::FMMMOptions::InitialPlacementForces::RandomTime);
+
+    switch (m_graphLayoutQuality) {
+        case 0:
+            layout.fixedIterations(3);
+            layout.fineTuningIterations(1);
+            layout.nmPrecision(2);
+            break;
+        case 1:
+            layout.fixedIterations(15);
+            layout.fineTuningIterations(10);
+            layout.nmPrecision(2);
+            break;
+        case 2:
+            layout.fixedIterations(30);
+            layout.fineTuningIterations(20);
+            layout.nmPrecision(4);
+            break;
+        case 3:
+            layout.fixedIterations(60);
+            layout.fineTuningIterations(40);
+            layout.nmPrecision(6);
+            break;
+        case 4:
+            layout.fixedIterations(120);
+            layout.fineTuningIterations(60);
+            layout.nmPrecision(8);
+            break;
+    }
+}
+
 class FMMGraphLayout : public GraphLayouter {
 public:
     using GraphLayouter::GraphLayouter;
 
     void init() override {
-        init(m_layout);
+        initFMMM(m_layout);
     }
 
     void cancel() override {
@@ -62,47 +110,53 @@ public:
     }
 
 private:
-    void init(ogdf::FMMMLayout &layout) const {
-        layout.randSeed(clock());
-        layout.useHighLevelOptions(false);
-        layout.unitEdgeLength(1.0);
-        layout.allowedPositions(ogdf::FMMMOptions::AllowedPositions::All);
-        layout.pageRatio(m_aspectRatio);
-        layout.minDistCC(m_graphLayoutComponentSeparation);
-        layout.stepsForRotatingComponents(50); // Helps to make linear graph components more horizontal.
-        layout.initialPlacementForces(m_useLinearLayout ?
-                                      ogdf::FMMMOptions::InitialPlacementForces::KeepPositions :
-                                      ogdf::FMMMOptions::InitialPlacementForces::RandomTime);
-
-        switch (m_graphLayoutQuality) {
-            case 0:
-                layout.fixedIterations(3);
-                layout.fineTuningIterations(1);
-                layout.nmPrecision(2);
-                break;
-            case 1:
-                layout.fixedIterations(15);
-                layout.fineTuningIterations(10);
-                layout.nmPrecision(2);
-                break;
-            case 2:
-                layout.fixedIterations(30);
-                layout.fineTuningIterations(20);
-                layout.nmPrecision(4);
-                break;
-            case 3:
-                layout.fixedIterations(60);
-                layout.fineTuningIterations(40);
-                layout.nmPrecision(6);
-                break;
-            case 4:
-                layout.fixedIterations(120);
-                layout.fineTuningIterations(60);
-                layout.nmPrecision(8);
-                break;
+    ogdf::FMMMLayout m_layout;
+};
+
+// Short single-level FMMM pass starting from the current positions. The
+// component is neither rotated nor moved, so it stays where it was drawn.
+class RefineGraphLayout : public GraphLayouter {
+public:
+    using GraphLayouter::GraphLayouter;
+
+    void init() override {
+        initFMMM(m_layout);
+        m_layout.setSingleLevel(true);
+        m_layout.initialPlacementForces(ogdf::FMMMOptions::InitialPlacementForces::KeepPositions);
+        m_layout.maxIterChange(ogdf::FMMMOptions::MaxIterChange::Constant);
+        m_layout.fixedIterations(std::min(m_layout.fixedIterations(), 15));
+        m_layout.fineTuningIterations(std::min(m_layout.fineTuningIterations(), 10));
+        m_layout.stepsForRotatingComponents(0);
+        m_layout.tipOverCCs(ogdf::FMMMOptions::TipOver::None);
+        m_layout.resizeDrawing(false);
+    }
+
+    void cancel() override {
+        m_layout.fixedIterations(0);
+        m_layout.fineTuningIterations(0);
+        m_layout.threshold(std::numeric_limits<double>::max());
+    }
+
+    void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) override {
+        ogdf::DPoint before = centre(GA);
+        m_layout.call(GA, edges);
+
+        // FMMM packs the result at the origin, move it back
+        ogdf::DPoint shift = before - centre(GA);
+        for (ogdf::node v : GA.constGraph().nodes) {
+            GA.x(v) += shift.m_x;
+            GA.y(v) += shift.m_y;
         }
     }
 
+private:
+    static ogdf::DPoint centre(const ogdf::GraphAttributes &GA) {
+        ogdf::DPoint sum;
+        for (ogdf::node v : GA.constGraph().nodes)
+            sum += GA.point(v);
+        return sum / GA.constGraph().numberOfNodes();
+    }
+
     ogdf::FMMMLayout m_layout;
 };
 
@@ -221,13 +275,14 @@ void determineLinearNodePositions(ogdf::Graph &ogdfGraph,
     QList<DeBruijnNode *> sortedDrawnNodes;
 
     // We first try to sort the nodes numerically.
-    QList<QPair<int, DeBruijnNode *>> numericallySortedDrawnNodes;
+    QList<QPair<long long, DeBruijnNode *>> numericallySortedDrawnNodes;
     bool successfulIntConversion = true;
     for (auto *node : graph.m_deBruijnGraphNodes) {
         if (!node->isDrawn())
             continue;
 
-        int nodeInt = node->getNameWithoutSign().toInt(&successfulIntConversion);
+        long long nodeInt;
+        successfulIntConversion = node->getNameNumber(nodeInt);
         if (!successfulIntConversion)
             break;
         numericallySortedDrawnNodes.emplace_back(nodeInt, node);
@@ -403,11 +458,13 @@ rotateComponentsAndCalculateBoundingRectangles(
 
     ogdf::List<fmmm::Rectangle> R;
 
+    // Only the entries of the current component are used, so the arrays are
+    // shared to avoid allocating them for every component
+    ogdf::NodeArray<ogdf::DPoint> best_coords(G), old_coords(G);
     for (int i = 0; i < numCCs; i++) {
         fmmm::Rectangle r_act, r_best;
         ogdf::DPoint new_pos, new_dlc;
 
-        ogdf::NodeArray<ogdf::DPoint> best_coords(G), old_coords(G);
         //init r_best, best_area and best_(old)coords
         r_best = calculateBoundingRectangle(GA, nodesInCC[i],
                                             graphLayoutComponentSeparation, i);
@@ -532,6 +589,203 @@ static void reassembleDrawings(ogdf::GraphAttributes &GA,
     }
 }
 
+// Components smaller than this are batched together into a single task
+static constexpr size_t SMALL_COMPONENT_NODES = 64;
+static constexpr size_t BATCH_NODES = 4096;
+// FMMM is single-threaded, larger components are laid out by the
+// multithreaded fast multipole embedder instead
+static constexpr size_t LARGE_COMPONENT_NODES = 10000;
+
+// Lays out a single component as a separate graph. Unlike GraphCopy this
+// does not need any per-task arrays sized by the whole graph. Only the entries
+// of copies for the component nodes are touched.
+static void layoutComponent(GraphLayouter &layouter,
+                            ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edgeLengths,
+                            ogdf::NodeArray<ogdf::node> &copies,
+                            const ogdf::List<ogdf::node> &nodesInCC) {
+    ogdf::Graph C;
+    ogdf::EdgeArray<double> cedgeLengths(C);
+    ogdf::GraphAttributes cGA(C, GA.attributes());
+
+    for (ogdf::node v : nodesInCC) {
+        ogdf::node w = copies[v] = C.newNode();
+        cGA.x(w) = GA.x(v);
+        cGA.y(w) = GA.y(v);
+        cGA.width(w) = GA.width(v);
+        cGA.height(w) = GA.height(v);
+    }
+
+    for (ogdf::node v : nodesInCC) {
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            if (!adj->isSource())
+                continue;
+            ogdf::edge e = adj->theEdge();
+            cedgeLengths[C.newEdge(copies[v], copies[e->target()])] = edgeLengths[e];
+        }
+    }
+
+    layouter.run(cGA, cedgeLengths);
+
+    for (ogdf::node v : nodesInCC) {
+        GA.x(v) = cGA.x(copies[v]);
+        GA.y(v) = cGA.y(copies[v]);
+    }
+}
+
+// Single nodes and simple chains do not need a force-directed layout: they
+// are laid out as a straight horizontal line. Returns false for any other
+// component.
+static bool placeTrivialComponent(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edgeLengths,
+                                  const ogdf::List<ogdf::node> &nodesInCC) {
+    ogdf::node end = nullptr;
+    size_t degrees = 0;
+    for (ogdf::node v : nodesInCC) {
+        int degree = v->degree();
+        if (degree > 2)
+            return false;
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            if (adj->theEdge()->isSelfLoop())
+                return false;
+        }
+        if (degree <= 1)
+            end = v;
+        degrees += degree;
+    }
+    // A cycle (or parallel edges)
+    if (!end || degrees / 2 + 1 != size_t(nodesInCC.size()))
+        return false;
+
+    double x = 0;
+    ogdf::edge prev = nullptr;
+    for (ogdf::node v = end; v; ) {
+        GA.x(v) = x;
+        GA.y(v) = 0;
+
+        ogdf::edge next = nullptr;
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            if (adj->theEdge() != prev)
+                next = adj->theEdge();
+        }
+        if (!next)
+            break;
+        x += edgeLengths[next];
+        v = next->opposite(v);
+        prev = next;
+    }
+
+    return true;
+}
+
+// Point at the given fraction of the polyline
+static QPointF pointAlong(const adt::SmallPODVector<QPointF> &points, double t) {
+    if (points.size() == 1)
+        return points.front();
+
+    double pos = t * double(points.size() - 1);
+    size_t i = std::min(size_t(pos), points.size() - 2);
+    double frac = pos - double(i);
+    return points[i] * (1.0 - frac) + points[i + 1] * frac;
+}
+
+// Takes the positions from the previous layout. The segments of the nodes
+// present there are spread along their previous drawing (the number of
+// segments might have changed since), the rest are placed next to an
+// already placed neighbour. Returns the nodes present in the previous layout.
+static ogdf::NodeArray<bool> seedPositions(ogdf::GraphAttributes &GA,
+                                           const ogdf::EdgeArray<double> &edgeLengths,
+                                           const OGDFGraphLayout &layout,
+                                           const GraphLayout &initialLayout) {
+    ogdf::NodeArray<bool> seeded(GA.constGraph(), false);
+    std::vector<ogdf::node> queue;
+    for (const auto &entry : layout) {
+        // In single mode the previous layout might have the other strand
+        const DeBruijnNode *node = entry.first;
+        bool reversed = !initialLayout.contains(node);
+        if (reversed)
+            node = node->getReverseComplement();
+        if (!initialLayout.contains(node) || initialLayout.segments(node).empty())
+            continue;
+
+        const auto &points = initialLayout.segments(node);
+        const auto &segments = entry.second;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            double t = segments.size() > 1 ? double(i) / double(segments.size() - 1) : 0.5;
+            QPointF point = pointAlong(points, reversed ? 1.0 - t : t);
+            GA.x(segments[i]) = point.x();
+            GA.y(segments[i]) = point.y();
+            seeded[segments[i]] = true;
+            queue.push_back(segments[i]);
+        }
+    }
+
+    // New nodes continue outwards, away from the other placed neighbours of
+    // the node they are attached to. Chains go straight, branches fan out.
+    ogdf::NodeArray<bool> placed(seeded);
+    for (size_t i = 0; i < queue.size(); ++i) {
+        ogdf::node v = queue[i];
+        ogdf::DPoint direction;
+        int branches = 0;
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            if (placed[adj->twinNode()])
+                direction += GA.point(v) - GA.point(adj->twinNode());
+            else
+                branches += 1;
+        }
+        if (!branches)
+            continue;
+
+        double angle = direction.norm() > 0 ?
+                       std::atan2(direction.m_y, direction.m_x) :
+                       ogdf::randomDouble(0, 2 * ogdf::Math::pi);
+        double spread = branches > 1 ? ogdf::Math::pi / 2 / (branches - 1) : 0;
+        angle -= spread * (branches - 1) / 2;
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            ogdf::node w = adj->twinNode();
+            if (placed[w])
+                continue;
+
+            double length = edgeLengths[adj->theEdge()];
+            GA.x(w) = GA.x(v) + length * std::cos(angle);
+            GA.y(w) = GA.y(v) + length * std::sin(angle);
+            angle += spread;
+            placed[w] = true;
+            queue.push_back(w);
+        }
+    }
+
+    return seeded;
+}
+
+// Moves the drawing of the given components to the right of the others
+static void placeNextTo(ogdf::GraphAttributes &GA,
+                        const ogdf::Array<ogdf::List<ogdf::node> > &nodesInCC,
+                        const std::vector<bool> &moved,
+                        double graphLayoutComponentSeparation) {
+    double keptMaxX = std::numeric_limits<double>::lowest(), keptMinY = std::numeric_limits<double>::max();
+    double movedMinX = std::numeric_limits<double>::max(), movedMinY = std::numeric_limits<double>::max();
+    for (int i = 0; i < nodesInCC.size(); ++i) {
+        for (ogdf::node v : nodesInCC[i]) {
+            if (moved[i]) {
+                movedMinX = std::min(movedMinX, GA.x(v));
+                movedMinY = std::min(movedMinY, GA.y(v));
+            } else {
+                keptMaxX = std::max(keptMaxX, GA.x(v));
+                keptMinY = std::min(keptMinY, GA.y(v));
+            }
+        }
+    }
+
+    double dx = keptMaxX + graphLayoutComponentSeparation - movedMinX, dy = keptMinY - movedMinY;
+    for (int i = 0; i < nodesInCC.size(); ++i) {
+        if (!moved[i])
+            continue;
+        for (ogdf::node v : nodesInCC[i]) {
+            GA.x(v) += dx;
+            GA.y(v) += dy;
+        }
+    }
+}
+
 GraphLayout GraphLayoutWorker::layoutGraph(const AssemblyGraph &graph) {
     ogdf::Graph G;
     ogdf::EdgeArray<double> edgeLengths(G);
@@ -550,55 +804,123 @@ GraphLayout GraphLayoutWorker::layoutGraph(const AssemblyGraph &graph) {
     for (auto v : G.nodes)
         nodesInCC[componentNumber[v]].pushBack(v);
 
-    for (size_t i= 0; i < numberOfComponents; ++i) {
-        m_state.emplace_back(new FMMGraphLayout(m_graphLayoutQuality,
-                                               m_useLinearLayout,
-                                               m_graphLayoutComponentSeparation,
-                                               m_aspectRatio));
-        m_state.back()->init();
+    // In the incremental mode components drawn before (at least partially)
+    // are kept in place
+    std::vector<size_t> seededNodes(numberOfComponents, 0);
+    if (m_initialLayout) {
+        ogdf::NodeArray<bool> seeded = seedPositions(GA, edgeLengths, layout, *m_initialLayout);
+        for (auto v : G.nodes)
+            seededNodes[componentNumber[v]] += seeded[v];
     }
 
-    for (int i = 0; i < numberOfComponents; i++) {
-        m_taskSynchronizer.addFuture(
-                QtConcurrent::run([&](GraphLayouter *layout,
-                        const ogdf::List<ogdf::node> &nodesInCC) {
-
-                    ogdf::GraphCopy GC;
-                    ogdf::EdgeArray<double> cedgeLengths(GC);
-                    ogdf::EdgeArray<ogdf::edge> auxCopy(G);
-
-                    GC.createEmpty(G);
-
-                    GC.initByNodes(nodesInCC, auxCopy);
-                    ogdf::GraphAttributes cGA(GC, GA.attributes());
-                    for (ogdf::node v : GC.nodes) {
-                        cGA.x(v) = GA.x(GC.original(v));
-                        cGA.y(v) = GA.y(GC.original(v));
-                        cGA.width(v) = GA.width(GC.original(v));
-                        cGA.height(v) = GA.height(GC.original(v));
-                    }
+    // Trivial components are placed right away, the rest is split into
+    // tasks: one per large component, small ones are batched together.
+    // Components with new nodes next to the kept ones are just refined.
+    std::vector<int> components(numberOfComponents);
+    std::iota(components.begin(), components.end(), 0);
+    std::stable_sort(components.begin(), components.end(),
+                     [&](int a, int b) { return nodesInCC[a].size() > nodesInCC[b].size(); });
+
+    std::vector<std::vector<int>> tasks;
+    std::vector<size_t> taskNodes;
+    std::vector<bool> refineTasks;
+    bool batching = false;
+    for (int i : components) {
+        size_t size = nodesInCC[i].size();
+        if (seededNodes[i] == size)
+            continue;
+        if (seededNodes[i]) {
+            tasks.push_back({ i });
+            taskNodes.push_back(size);
+            refineTasks.push_back(true);
+            batching = false;
+            continue;
+        }
 
-                    for (ogdf::edge e : GC.edges)
-                        cedgeLengths(e) = edgeLengths(GC.original(e));
+        if (placeTrivialComponent(GA, edgeLengths, nodesInCC[i]))
+            continue;
 
-                    layout->run(cGA, cedgeLengths);
+        if (size >= SMALL_COMPONENT_NODES || !batching || taskNodes.back() + size > BATCH_NODES) {
+            tasks.emplace_back();
+            taskNodes.push_back(0);
+            refineTasks.push_back(false);
+        }
+        tasks.back().push_back(i);
+        taskNodes.back() += size;
+        batching = size < SMALL_COMPONENT_NODES;
+    }
 
-                    for (ogdf::node v : GC.nodes) {
-                        ogdf::node w = GC.original(v);
-                        if (w == nullptr)
-                            continue;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (refineTasks[i])
+            m_state.emplace_back(new RefineGraphLayout(m_graphLayoutQuality,
+                                                       m_useLinearLayout,
+                                                       m_graphLayoutComponentSeparation,
+                                                       m_aspectRatio));
+        else if (g_settings->graphLayoutAlgorithm == MULTILEVEL_LAYOUT)
+            m_state.emplace_back(new MultilevelGraphLayout(m_graphLayoutQuality,
+                                                           m_useLinearLayout,
+                                                           m_graphLayoutComponentSeparation,
+                                                           m_aspectRatio));
+        else if (taskNodes[i] >= LARGE_COMPONENT_NODES && !m_useLinearLayout)
+            m_state.emplace_back(new FMEGraphLayout(g_settings->layoutThreads,
+                                                    m_graphLayoutQuality,
+                                                    m_useLinearLayout,
+                                                    m_graphLayoutComponentSeparation,
+                                                    m_aspectRatio));
+        else
+            m_state.emplace_back(new FMMGraphLayout(m_graphLayoutQuality,
+                                                   m_useLinearLayout,
+                                                   m_graphLayoutComponentSeparation,
+                                                   m_aspectRatio));
+        m_state.back()->init();
+    }
 
-                        GA.x(w) = cGA.x(v);
-                        GA.y(w) = cGA.y(v);
+    // Tasks are sorted from the largest to the smallest and every worker
+    // takes the next one as soon as it is done with the previous, so the
+    // giant component starts first and small ones fill the gaps
+    std::vector<size_t> order(tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return taskNodes[a] > taskNodes[b]; });
+
+    ogdf::NodeArray<ogdf::node> copies(G, nullptr);
+    std::atomic<size_t> nextTask = 0;
+    int workers = std::min<int>(QThreadPool::globalInstance()->maxThreadCount(), int(tasks.size()));
+    for (int worker = 0; worker < workers; ++worker) {
+        m_taskSynchronizer.addFuture(
+                QtConcurrent::run([&]() {
+                    for (size_t next = nextTask++; next < order.size(); next = nextTask++) {
+                        size_t task = order[next];
+                        for (int i : tasks[task])
+                            layoutComponent(*m_state[task], GA, edgeLengths, copies, nodesInCC[i]);
                     }
-
-                }, m_state[i].get(), nodesInCC[i]));
+                }));
     }
     m_taskSynchronizer.waitForFinished();
 
-    reassembleDrawings(GA,
-                       m_graphLayoutComponentSeparation, m_aspectRatio,
-                       nodesInCC);
+    std::vector<int> newComponents;
+    for (int i = 0; i < numberOfComponents; ++i) {
+        if (!seededNodes[i])
+            newComponents.push_back(i);
+    }
+
+    if (newComponents.size() == size_t(numberOfComponents)) {
+        reassembleDrawings(GA,
+                           m_graphLayoutComponentSeparation, m_aspectRatio,
+                           nodesInCC);
+    } else if (!newComponents.empty()) {
+        // Only the new components are packed, then put aside the kept ones
+        ogdf::Array<ogdf::List<ogdf::node> > newNodesInCC(int(newComponents.size()));
+        std::vector<bool> moved(numberOfComponents, false);
+        for (size_t i = 0; i < newComponents.size(); ++i) {
+            newNodesInCC[int(i)] = nodesInCC[newComponents[i]];
+            moved[newComponents[i]] = true;
+        }
+        reassembleDrawings(GA,
+                           m_graphLayoutComponentSeparation, m_aspectRatio,
+                           newNodesInCC);
+        placeNextTo(GA, nodesInCC, moved, m_graphLayoutComponentSeparation);
+    }
 
     GraphLayout res(graph);
     for (const auto & entry : layout) {
@@ -22,9 +22,12 @@
 #include <QObject>
 #include <QFutureSynchronizer>
 
+#include <optional>
+
 namespace ogdf {
     class Graph;
     class GraphAttributes;
+    class FMMMLayout;
     template<class T> class EdgeArray;
 }
 
@@ -42,6 +45,9 @@ public:
     virtual void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) = 0;
 
 protected:
+    // Configures FMMM according to the layout settings
+    void initFMMM(ogdf::FMMMLayout &layout) const;
+
     int m_graphLayoutQuality;
     bool m_useLinearLayout;
     double m_graphLayoutComponentSeparation;
@@ -58,11 +64,18 @@ public:
                       double aspectRatio = 1.333333);
     ~GraphLayoutWorker() override = default;
 
+    // Makes the layout incremental: the nodes present in the given layout
+    // start from their positions there, new ones are placed next to their
+    // neighbours. Components with new nodes only get a short refinement
+    // pass, components without them are kept as they are.
+    void setInitialLayout(const GraphLayout &layout) { m_initialLayout.emplace(layout); }
+
     GraphLayout layoutGraph(const AssemblyGraph &graph);
 
 private:
     QFutureSynchronizer<void> m_taskSynchronizer;
     std::vector<std::unique_ptr<GraphLayouter>> m_state;
+    std::optional<GraphLayout> m_initialLayout;
     int m_graphLayoutQuality;
     bool m_useLinearLayout;
     double m_graphLayoutComponentSeparation;
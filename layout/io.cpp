@@ -25,8 +25,163 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QtEndian>
+
+#include <cstdint>
+#include <string_view>
 
 namespace layout::io {
+    // Binary layout: header, point count of every node (uint32), node names
+    // (uint32 length followed by the bytes) and float32 x, y pairs of all
+    // the nodes one after another. Everything is little-endian.
+    namespace {
+        constexpr char BINARY_MAGIC[8] = { 'B', 'N', 'G', 'L', 'A', 'Y', 'O', 'T' };
+        constexpr uint32_t BINARY_VERSION = 1;
+
+        struct BinaryHeader {
+            uint32_t version;
+            uint64_t graphChecksum;
+            uint64_t nodeCount;
+            uint64_t pointCount;
+            uint64_t namesSize;
+        };
+        constexpr size_t BINARY_HEADER_SIZE = sizeof(BINARY_MAGIC) + 2 * 4 + 4 * 8;
+
+        uint64_t hashName(std::string_view name) {
+            // FNV-1a
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (char c : name) {
+                hash ^= uint8_t(c);
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        uint64_t mix(uint64_t x) {
+            // splitmix64 finalizer
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        // Names and lengths of all the nodes of the graph. The node index
+        // has no stable iteration order, so the node hashes are summed.
+        uint64_t graphChecksum(const AssemblyGraph &graph) {
+            uint64_t sum = 0, count = 0;
+            for (const DeBruijnNode *node : graph.m_deBruijnGraphNodes) {
+                sum += mix(hashName(node->getNameView()) ^ (uint64_t(node->getLength()) * 0x9e3779b97f4a7c15ULL));
+                count += 1;
+            }
+            return mix(sum ^ mix(count));
+        }
+
+        template<class T>
+        void append(QByteArray &out, T value) {
+            char buf[sizeof(T)];
+            qToLittleEndian(value, buf);
+            out.append(buf, sizeof(T));
+        }
+
+        template<class T>
+        T read(const uchar *data) {
+            return qFromLittleEndian<T>(data);
+        }
+
+        void loadBinary(QFile &file, GraphLayout &layout) {
+            const AssemblyGraph &graph = layout.graph();
+            uint64_t fileSize = file.size();
+            if (fileSize < BINARY_HEADER_SIZE)
+                throw std::runtime_error("truncated layout file");
+
+            const uchar *data = file.map(0, file.size());
+            if (!data)
+                throw std::runtime_error("cannot map file: " + file.errorString().toStdString());
+
+            const uchar *pos = data + sizeof(BINARY_MAGIC);
+            BinaryHeader header;
+            header.version = read<uint32_t>(pos); pos += 4 + 4;
+            header.graphChecksum = read<uint64_t>(pos); pos += 8;
+            header.nodeCount = read<uint64_t>(pos); pos += 8;
+            header.pointCount = read<uint64_t>(pos); pos += 8;
+            header.namesSize = read<uint64_t>(pos); pos += 8;
+
+            if (header.version != BINARY_VERSION)
+                throw std::runtime_error("unsupported layout version: " + std::to_string(header.version));
+            if (header.graphChecksum != graphChecksum(graph))
+                throw std::runtime_error("layout was saved for a different graph");
+
+            // Every section is bounded by the file size, so the sum could
+            // not overflow
+            uint64_t available = fileSize - BINARY_HEADER_SIZE;
+            if (header.nodeCount > available / 4 || header.pointCount > available / 8 ||
+                header.namesSize > available ||
+                4 * header.nodeCount + header.namesSize + 8 * header.pointCount != available)
+                throw std::runtime_error("invalid layout format: section sizes do not match the file size");
+
+            const uchar *counts = pos;
+            const uchar *names = counts + 4 * header.nodeCount, *namesEnd = names + header.namesSize;
+            const uchar *points = namesEnd;
+            uint64_t pointIdx = 0;
+            for (uint64_t i = 0; i < header.nodeCount; ++i) {
+                if (namesEnd - names < 4)
+                    throw std::runtime_error("invalid layout format");
+                uint32_t nameSize = read<uint32_t>(names);
+                names += 4;
+                if (uint64_t(namesEnd - names) < nameSize)
+                    throw std::runtime_error("invalid layout format");
+
+                std::string_view name(reinterpret_cast<const char *>(names), nameSize);
+                names += nameSize;
+                auto node = graph.m_deBruijnGraphNodes.find_ks(name.data(), name.size());
+                if (node == graph.m_deBruijnGraphNodes.end())
+                    throw std::runtime_error("graph does not contain node: " + std::string(name));
+
+                uint32_t count = read<uint32_t>(counts + 4 * i);
+                if (header.pointCount - pointIdx < count)
+                    throw std::runtime_error("invalid layout format");
+
+                auto &segments = layout.segments(*node);
+                segments.reserve(segments.size() + count);
+                for (const uchar *point = points + 8 * pointIdx, *end = point + 8 * count; point != end; point += 8)
+                    segments.emplace_back(read<float>(point), read<float>(point + 4));
+                pointIdx += count;
+            }
+
+            if (pointIdx != header.pointCount)
+                throw std::runtime_error("invalid layout format");
+        }
+
+        void loadJSON(QFile &loadFile, GraphLayout &layout) {
+            QJsonParseError error;
+            auto jsonLayoutDoc = QJsonDocument::fromJson(loadFile.readAll(), &error);
+            if (error.error != QJsonParseError::NoError)
+                throw std::runtime_error(error.errorString().toStdString());
+
+            if (!jsonLayoutDoc.isObject())
+                throw std::runtime_error("invalid layout format");
+
+            QJsonObject jsonLayout = jsonLayoutDoc.object();
+            const AssemblyGraph &graph = layout.graph();
+            for (auto it = jsonLayout.begin(); it != jsonLayout.end(); ++it) {
+                QString name = it.key();
+                auto node = graph.m_deBruijnGraphNodes.find(name.toStdString());
+                if (node == graph.m_deBruijnGraphNodes.end())
+                    throw std::runtime_error("graph does not contain node: " + name.toStdString());
+                if (!it.value().isArray())
+                    throw std::runtime_error("invalid layout format");
+                for (const auto &point : it.value().toArray()) {
+                    QJsonArray pointArray = point.toArray();
+                    if (pointArray.size() != 2)
+                        throw std::runtime_error("invalid layout format: point size is " + std::to_string(pointArray.size()));
+                    layout.add(*node, { pointArray[0].toDouble(), pointArray[1].toDouble() });
+                }
+            }
+        }
+    }
+
     bool save(const QString &filename,
               const GraphLayout &layout) {
         QJsonObject jsonLayout;
@@ -63,38 +218,56 @@ namespace layout::io {
         return true;
     }
 
+    bool saveBinary(const QString &filename,
+                    const GraphLayout &layout) {
+        QByteArray counts, names, points;
+        uint64_t pointCount = 0;
+        counts.reserve(qsizetype(4 * layout.size()));
+        for (const auto &entry : layout) {
+            std::string_view name = entry.first->getNameView();
+            append<uint32_t>(names, uint32_t(name.size()));
+            names.append(name.data(), qsizetype(name.size()));
+
+            append<uint32_t>(counts, uint32_t(entry.second.size()));
+            for (QPointF point : entry.second) {
+                append<float>(points, float(point.x()));
+                append<float>(points, float(point.y()));
+            }
+            pointCount += entry.second.size();
+        }
+
+        QByteArray header(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        append<uint32_t>(header, BINARY_VERSION);
+        append<uint32_t>(header, 0);
+        append<uint64_t>(header, graphChecksum(layout.graph()));
+        append<uint64_t>(header, layout.size());
+        append<uint64_t>(header, pointCount);
+        append<uint64_t>(header, names.size());
+
+        QFile saveFile(filename);
+        if (!saveFile.open(QIODevice::WriteOnly))
+            return false;
+
+        for (const QByteArray *section : { &header, &counts, &names, &points }) {
+            if (saveFile.write(*section) != section->size())
+                return false;
+        }
+
+        return true;
+    }
+
     bool load(const QString &filename,
               GraphLayout &layout) {
         QFile loadFile(filename);
         // FIXME: Switch to Error return object stuff!
-        if (!loadFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        if (!loadFile.open(QIODevice::ReadOnly))
             throw std::runtime_error("cannot open file: " + filename.toStdString());
 
-        QJsonParseError error;
-        auto jsonLayoutDoc = QJsonDocument::fromJson(loadFile.readAll(), &error);
-        if (error.error != QJsonParseError::NoError)
-            throw std::runtime_error(error.errorString().toStdString());
-
-        if (!jsonLayoutDoc.isObject())
-            throw std::runtime_error("invalid layout format");
-
-        QJsonObject jsonLayout = jsonLayoutDoc.object();
-        const AssemblyGraph &graph = layout.graph();
-        for (auto it = jsonLayout.begin(); it != jsonLayout.end(); ++it) {
-            QString name = it.key();
-            auto node = graph.m_deBruijnGraphNodes.find(name.toStdString());
-            if (node == graph.m_deBruijnGraphNodes.end())
-                throw std::runtime_error("graph does not contain node: " + name.toStdString());
-            if (!it.value().isArray())
-                throw std::runtime_error("invalid layout format");
-            for (const auto &point : it.value().toArray()) {
-                QJsonArray pointArray = point.toArray();
-                if (pointArray.size() != 2)
-                    throw std::runtime_error("invalid layout format: point size is " + std::to_string(pointArray.size()));
-                layout.add(*node, { pointArray[0].toDouble(), pointArray[1].toDouble() });
-            }
-        }
+        if (loadFile.peek(sizeof(BINARY_MAGIC)) == QByteArray(BINARY_MAGIC, sizeof(BINARY_MAGIC)))
+            loadBinary(loadFile, layout);
+        else
+            loadJSON(loadFile, layout);
 
         return true;
     }
-}
\ No newline at end of file
+}
@@ -24,4 +24,9 @@ namespace layout::io {
               const GraphLayout &layout);
     bool saveTSV(const QString &filename,
                  const GraphLayout &layout);
+    // Compact binary format (points are stored as float32), loaded by
+    // load() as well. The file is bound to the graph via a checksum of the
+    // graph nodes.
+    bool saveBinary(const QString &filename,
+                    const GraphLayout &layout);
 };
\ No newline at end of file
@@ -0,0 +1,178 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "layoutcache.h"
+#include "graphlayoutworker.h"
+#include "io.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnedge.h"
+#include "graph/debruijnnode.h"
+#include "program/settings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace layout::cache {
+    // Bumped whenever the layout algorithms change, so stale layouts are
+    // not picked up
+    static constexpr const char *CACHE_VERSION = "bandage-layout-cache-1";
+
+    static QString cacheFile(const QByteArray &key) {
+        return QDir(directory()).filePath(QString::fromLatin1(key) + ".blayout");
+    }
+
+    // Removes the least recently used layouts until the cache fits the limit
+    static void evict(qint64 limit) {
+        QDir dir(directory());
+        QFileInfoList files = dir.entryInfoList({ "*.blayout" }, QDir::Files, QDir::Time);
+        qint64 total = 0;
+        for (const QFileInfo &file : files) {
+            total += file.size();
+            if (total > limit)
+                QFile::remove(file.filePath());
+        }
+    }
+
+    QString directory() {
+        return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("layouts");
+    }
+
+    QByteArray key(const AssemblyGraph &graph,
+                   int graphLayoutQuality,
+                   bool useLinearLayout,
+                   double graphLayoutComponentSeparation,
+                   double aspectRatio) {
+        // The node and edge indices have no stable order, so both are sorted
+        std::vector<std::string> nodes, edges;
+        for (const DeBruijnNode *node : graph.m_deBruijnGraphNodes) {
+            if (node->isDrawn())
+                nodes.emplace_back(std::string(node->getNameView()) + '\t' + std::to_string(node->getLength()));
+        }
+        for (const auto &entry : graph.m_deBruijnGraphEdges) {
+            const DeBruijnEdge *edge = entry.second;
+            if (edge->isDrawn())
+                edges.emplace_back(std::string(edge->getStartingNode()->getNameView()) + '\t' +
+                                   std::string(edge->getEndingNode()->getNameView()));
+        }
+        std::sort(nodes.begin(), nodes.end());
+        std::sort(edges.begin(), edges.end());
+
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        auto add = [&](const std::string &s) {
+            hash.addData(QByteArrayView(s.data(), qsizetype(s.size())));
+            hash.addData(QByteArrayView("\n"));
+        };
+
+        add(CACHE_VERSION);
+        add(QStringList{
+                QString::number(graphLayoutQuality),
+                QString::number(useLinearLayout),
+                QString::number(graphLayoutComponentSeparation),
+                QString::number(aspectRatio, 'f', 2),
+                QString::number(g_settings->graphLayoutAlgorithm),
+                QString::number(g_settings->nodeSegmentLength.val),
+                QString::number(g_settings->edgeLength.val),
+                QString::number(g_settings->minimumNodeLength.val),
+                QString::number(g_settings->nodeLengthMode),
+                QString::number(g_settings->autoNodeLengthPerMegabase),
+                QString::number(g_settings->manualNodeLengthPerMegabase.val) }.join('\t').toStdString());
+        add(std::to_string(nodes.size()));
+        for (const auto &node : nodes)
+            add(node);
+        add(std::to_string(edges.size()));
+        for (const auto &edge : edges)
+            add(edge);
+
+        return hash.result().toHex();
+    }
+
+    std::optional<GraphLayout> load(const AssemblyGraph &graph, const QByteArray &key) {
+        if (g_settings->layoutCacheSize == 0)
+            return {};
+
+        QString fileName = cacheFile(key);
+        if (!QFile::exists(fileName))
+            return {};
+
+        std::optional<GraphLayout> layout(std::in_place, graph);
+        try {
+            io::load(fileName, *layout);
+        } catch (std::runtime_error &) {
+            // Corrupted or left from some other graph with the same key
+            QFile::remove(fileName);
+            return {};
+        }
+
+        // Mark as recently used
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadWrite))
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+        return layout;
+    }
+
+    void store(const QByteArray &key, const GraphLayout &layout) {
+        if (g_settings->layoutCacheSize == 0)
+            return;
+
+        if (!QDir().mkpath(directory()))
+            return;
+
+        // Written aside and renamed, so a concurrent load never sees a
+        // partially written layout
+        QString fileName = cacheFile(key), tempFileName = fileName + ".tmp";
+        if (!io::saveBinary(tempFileName, layout)) {
+            QFile::remove(tempFileName);
+            return;
+        }
+        QFile::remove(fileName);
+        if (!QFile::rename(tempFileName, fileName)) {
+            QFile::remove(tempFileName);
+            return;
+        }
+
+        evict(qint64(g_settings->layoutCacheSize) * 1024 * 1024);
+    }
+
+    GraphLayout layoutGraph(const AssemblyGraph &graph,
+                            int graphLayoutQuality,
+                            bool useLinearLayout,
+                            double graphLayoutComponentSeparation,
+                            double aspectRatio) {
+        QByteArray cacheKey;
+        if (g_settings->layoutCacheSize != 0) {
+            cacheKey = key(graph, graphLayoutQuality, useLinearLayout, graphLayoutComponentSeparation, aspectRatio);
+            if (auto cached = load(graph, cacheKey))
+                return std::move(*cached);
+        }
+
+        GraphLayout layout = GraphLayoutWorker(graphLayoutQuality, useLinearLayout,
+                                               graphLayoutComponentSeparation, aspectRatio).layoutGraph(graph);
+        if (!cacheKey.isEmpty())
+            store(cacheKey, layout);
+
+        return layout;
+    }
+}
@@ -0,0 +1,51 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlayout.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <optional>
+
+// On-disk cache of the computed layouts in the user cache directory. The
+// layouts are stored in the binary layout format, the least recently used
+// ones are evicted once the cache exceeds g_settings->layoutCacheSize.
+namespace layout::cache {
+    // Directory the cached layouts are stored in
+    QString directory();
+
+    // Key of the layout of the currently drawn part of the graph: the drawn
+    // nodes and edges, the given worker parameters and the layout settings
+    QByteArray key(const AssemblyGraph &graph,
+                   int graphLayoutQuality,
+                   bool useLinearLayout,
+                   double graphLayoutComponentSeparation,
+                   double aspectRatio = 1.333333);
+
+    std::optional<GraphLayout> load(const AssemblyGraph &graph, const QByteArray &key);
+    void store(const QByteArray &key, const GraphLayout &layout);
+
+    // Lays out the drawn part of the graph, unless the layout is cached
+    GraphLayout layoutGraph(const AssemblyGraph &graph,
+                            int graphLayoutQuality,
+                            bool useLinearLayout,
+                            double graphLayoutComponentSeparation,
+                            double aspectRatio = 1.333333);
+}
@@ -0,0 +1,291 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "multilevellayouter.h"
+
+#include "ogdf/basic/GraphAttributes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+    // Chain nodes represented by a single super-node of the coarse graph.
+    // Long chains get several, so the coarse layout still decides how they
+    // bend.
+    constexpr size_t CHAIN_NODES_PER_SUPER_NODE = 32;
+
+    // A maximal path through nodes of degree two between two anchors (nodes
+    // of any other degree). The anchors might coincide for cycles.
+    struct Chain {
+        // Both anchors included, in the walk order
+        std::vector<ogdf::node> nodes;
+        // Distance from the first anchor along the chain
+        std::vector<double> offsets;
+        // Same for the nodes of the coarse graph representing the chain
+        std::vector<ogdf::node> coarseNodes;
+        std::vector<double> coarseOffsets;
+    };
+
+    unsigned degreeWithoutSelfLoops(ogdf::node v) {
+        unsigned degree = 0;
+        for (ogdf::adjEntry adj : v->adjEntries)
+            degree += !adj->theEdge()->isSelfLoop();
+        return degree;
+    }
+
+    // Centripetal Catmull-Rom spline piece between p1 and p2, p0 and p3 are
+    // the neighbouring control points. Goes through the control points
+    // without cusps or self-intersections within a piece.
+    class SplinePiece {
+    public:
+        SplinePiece(ogdf::DPoint p0, ogdf::DPoint p1, ogdf::DPoint p2, ogdf::DPoint p3)
+                : m_p{ p0, p1, p2, p3 } {
+            m_t[0] = 0;
+            for (int i = 1; i < 4; ++i)
+                m_t[i] = m_t[i - 1] + std::sqrt(m_p[i].distance(m_p[i - 1]));
+        }
+
+        // Point at the given fraction of the piece
+        ogdf::DPoint point(double u) const {
+            // Coinciding control points, nothing to interpolate smoothly
+            if (m_t[1] == m_t[0] || m_t[2] == m_t[1] || m_t[3] == m_t[2])
+                return m_p[1] + (m_p[2] - m_p[1]) * u;
+
+            double t = m_t[1] + u * (m_t[2] - m_t[1]);
+            ogdf::DPoint a1 = lerp(m_p[0], m_p[1], m_t[0], m_t[1], t),
+                         a2 = lerp(m_p[1], m_p[2], m_t[1], m_t[2], t),
+                         a3 = lerp(m_p[2], m_p[3], m_t[2], m_t[3], t);
+            ogdf::DPoint b1 = lerp(a1, a2, m_t[0], m_t[2], t),
+                         b2 = lerp(a2, a3, m_t[1], m_t[3], t);
+            return lerp(b1, b2, m_t[1], m_t[2], t);
+        }
+
+    private:
+        static ogdf::DPoint lerp(ogdf::DPoint a, ogdf::DPoint b, double ta, double tb, double t) {
+            return a * ((tb - t) / (tb - ta)) + b * ((t - ta) / (tb - ta));
+        }
+
+        ogdf::DPoint m_p[4];
+        double m_t[4];
+    };
+
+    class Coarsening {
+    public:
+        Coarsening(const ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edgeLengths)
+                : m_fineGA(GA), m_fineEdgeLengths(edgeLengths),
+                  m_GA(m_graph, GA.attributes()), m_edgeLengths(m_graph),
+                  m_anchors(GA.constGraph(), nullptr), m_visitedNodes(GA.constGraph(), false),
+                  m_visitedEdges(GA.constGraph(), false) {
+            const ogdf::Graph &G = GA.constGraph();
+            for (ogdf::node v : G.nodes) {
+                if (degreeWithoutSelfLoops(v) != 2)
+                    addAnchor(v);
+            }
+            for (ogdf::node v : G.nodes) {
+                if (m_anchors[v])
+                    addChains(v);
+            }
+
+            // Whatever is left are cycles without branching, break them anywhere
+            for (ogdf::node v : G.nodes) {
+                if (m_visitedNodes[v])
+                    continue;
+                addAnchor(v);
+                addChains(v);
+            }
+        }
+
+        ogdf::GraphAttributes &attributes() { return m_GA; }
+        const ogdf::EdgeArray<double> &edgeLengths() const { return m_edgeLengths; }
+        int nodeCount() const { return m_graph.numberOfNodes(); }
+
+        // Places the nodes of the original graph according to the layout of
+        // the coarse one. Anchors keep the positions of their coarse nodes,
+        // chains are spread along their super-nodes.
+        void expand(ogdf::GraphAttributes &GA) const {
+            for (ogdf::node v : GA.constGraph().nodes) {
+                if (ogdf::node coarse = m_anchors[v]) {
+                    GA.x(v) = m_GA.x(coarse);
+                    GA.y(v) = m_GA.y(coarse);
+                }
+            }
+
+            for (const auto &chain : m_chains)
+                expand(chain, GA);
+        }
+
+    private:
+        // Local refinement of the chain: nodes are placed on a smooth curve
+        // through the coarse nodes instead of straight lines between them
+        void expand(const Chain &chain, ogdf::GraphAttributes &GA) const {
+            std::vector<ogdf::DPoint> points;
+            for (ogdf::node v : chain.coarseNodes)
+                points.push_back(m_GA.point(v));
+
+            // Missing control points at the ends: wrap around for cycles,
+            // mirror the end points otherwise
+            bool cycle = chain.nodes.front() == chain.nodes.back();
+            ogdf::DPoint first = cycle ? points[points.size() - 2] : points[0] * 2.0 - points[1];
+            ogdf::DPoint last = cycle ? points[1] : points.back() * 2.0 - points[points.size() - 2];
+
+            size_t i = 1;
+            for (size_t piece = 0; piece + 1 < points.size(); ++piece) {
+                ogdf::DPoint before = piece > 0 ? points[piece - 1] : first;
+                ogdf::DPoint after = piece + 2 < points.size() ? points[piece + 2] : last;
+                SplinePiece spline(before, points[piece], points[piece + 1], after);
+
+                double startOffset = chain.coarseOffsets[piece], endOffset = chain.coarseOffsets[piece + 1];
+                for (; i + 1 < chain.nodes.size() && chain.offsets[i] <= endOffset; ++i) {
+                    ogdf::DPoint point = spline.point((chain.offsets[i] - startOffset) / (endOffset - startOffset));
+                    GA.x(chain.nodes[i]) = point.m_x;
+                    GA.y(chain.nodes[i]) = point.m_y;
+                }
+            }
+        }
+
+        ogdf::node addCoarseNode(ogdf::node v) {
+            ogdf::node coarse = m_graph.newNode();
+            m_GA.x(coarse) = m_fineGA.x(v);
+            m_GA.y(coarse) = m_fineGA.y(v);
+            m_GA.width(coarse) = m_fineGA.width(v);
+            m_GA.height(coarse) = m_fineGA.height(v);
+            return coarse;
+        }
+
+        void addAnchor(ogdf::node v) {
+            m_anchors[v] = addCoarseNode(v);
+            m_visitedNodes[v] = true;
+        }
+
+        void addCoarseEdge(ogdf::node from, ogdf::node to, double length) {
+            ogdf::edge e = m_graph.newEdge(from, to);
+            m_edgeLengths[e] = length;
+        }
+
+        // Walks all chains starting at the given anchor
+        void addChains(ogdf::node anchor) {
+            for (ogdf::adjEntry adj : anchor->adjEntries) {
+                ogdf::edge e = adj->theEdge();
+                if (e->isSelfLoop() || m_visitedEdges[e])
+                    continue;
+
+                Chain chain;
+                chain.nodes.push_back(anchor);
+                chain.offsets.push_back(0);
+
+                double offset = 0;
+                ogdf::node v = anchor;
+                while (true) {
+                    m_visitedEdges[e] = true;
+                    offset += m_fineEdgeLengths[e];
+                    v = e->opposite(v);
+                    chain.nodes.push_back(v);
+                    chain.offsets.push_back(offset);
+                    if (m_anchors[v])
+                        break;
+
+                    m_visitedNodes[v] = true;
+                    for (ogdf::adjEntry next : v->adjEntries) {
+                        ogdf::edge nextEdge = next->theEdge();
+                        if (nextEdge != e && !nextEdge->isSelfLoop()) {
+                            e = nextEdge;
+                            break;
+                        }
+                    }
+                }
+
+                addChain(std::move(chain));
+            }
+        }
+
+        void addChain(Chain chain) {
+            ogdf::node first = chain.nodes.front(), last = chain.nodes.back();
+            size_t interior = chain.nodes.size() - 2;
+            double length = chain.offsets.back();
+            if (!interior) {
+                addCoarseEdge(m_anchors[first], m_anchors[last], length);
+                return;
+            }
+
+            // Even a short chain needs a super-node to bend, cycles need two
+            // so they are not collapsed into a double edge
+            size_t superNodes = std::min(std::max<size_t>(first == last ? 2 : 1,
+                                                          interior / CHAIN_NODES_PER_SUPER_NODE),
+                                         interior);
+            chain.coarseNodes.push_back(m_anchors[first]);
+            chain.coarseOffsets.push_back(0);
+            size_t i = 1;
+            for (size_t j = 1; j <= superNodes; ++j) {
+                double target = length * double(j) / double(superNodes + 1);
+                while (i < interior - (superNodes - j) && chain.offsets[i] < target)
+                    ++i;
+
+                ogdf::node superNode = addCoarseNode(chain.nodes[i]);
+                addCoarseEdge(chain.coarseNodes.back(), superNode, chain.offsets[i] - chain.coarseOffsets.back());
+                chain.coarseNodes.push_back(superNode);
+                chain.coarseOffsets.push_back(chain.offsets[i]);
+                ++i;
+            }
+            addCoarseEdge(chain.coarseNodes.back(), m_anchors[last], length - chain.coarseOffsets.back());
+            chain.coarseNodes.push_back(m_anchors[last]);
+            chain.coarseOffsets.push_back(length);
+
+            m_chains.emplace_back(std::move(chain));
+        }
+
+        const ogdf::GraphAttributes &m_fineGA;
+        const ogdf::EdgeArray<double> &m_fineEdgeLengths;
+
+        ogdf::Graph m_graph;
+        ogdf::GraphAttributes m_GA;
+        ogdf::EdgeArray<double> m_edgeLengths;
+
+        // Coarse node for every anchor, nullptr for chain nodes
+        ogdf::NodeArray<ogdf::node> m_anchors;
+        ogdf::NodeArray<bool> m_visitedNodes;
+        ogdf::EdgeArray<bool> m_visitedEdges;
+        std::vector<Chain> m_chains;
+    };
+}
+
+void MultilevelGraphLayout::init() {
+    m_cancelled = false;
+    initFMMM(m_layout);
+}
+
+void MultilevelGraphLayout::cancel() {
+    m_cancelled = true;
+    m_layout.fixedIterations(0);
+    m_layout.fineTuningIterations(0);
+    m_layout.threshold(std::numeric_limits<double>::max());
+}
+
+void MultilevelGraphLayout::run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) {
+    Coarsening coarsening(GA, edges);
+
+    // Nothing much to collapse, the coarse layout would be almost the same
+    if (coarsening.nodeCount() > GA.constGraph().numberOfNodes() / 4 * 3) {
+        m_layout.call(GA, edges);
+        return;
+    }
+
+    m_layout.call(coarsening.attributes(), coarsening.edgeLengths());
+    if (!m_cancelled)
+        coarsening.expand(GA);
+}
@@ -0,0 +1,42 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlayoutworker.h"
+
+#include "ogdf/energybased/FMMMLayout.h"
+
+#include <atomic>
+
+// Coarsen-then-refine layout. Every run of OGDF nodes of degree two (node
+// segment chains as well as unbranching paths through several graph nodes)
+// is collapsed into a super-node (or a few for long runs). The much smaller
+// coarse graph is laid out by FMMM, then the runs are re-expanded along
+// smooth curves through their super-nodes.
+class MultilevelGraphLayout : public GraphLayouter {
+public:
+    using GraphLayouter::GraphLayouter;
+
+    void init() override;
+    void cancel() override;
+    void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) override;
+
+private:
+    ogdf::FMMMLayout m_layout;
+    std::atomic<bool> m_cancelled = false;
+};
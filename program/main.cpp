@@ -121,23 +121,21 @@ static SubCmd parseCmdLine(CLI::App &app, int argc, char *argv[]) {
     return subcmd;
 }
 
-static void chooseQtPlatform(const CLI::App &app, const SubCmd &cmd) {
+static void chooseQtPlatform(const CLI::App &, const SubCmd &cmd) {
     // Chose default Qt platform. Some ways of running Bandage require the
     // normal platform while other command line only ways use the minimal
-    // platform. Frustratingly, Bandage image cannot render text properly with
-    // the minimal platform, so we need to use the full platform if Bandage
-    // image is run with text labels.
-    bool imageWithText = false; //std::holds_alternative<ImageCmd>(cmd) &&
-    //(app.count("--names") || app.count("--lengths") ||
-    //                      app.count("--depth") || app.count("--blasthits"));
+    // platform. Bandage image draws the graph without any graphics scene, but
+    // the minimal platform has no fonts to render text with, so it uses the
+    // offscreen platform that does not need a display either.
     bool guiNeeded = std::holds_alternative<std::monostate>(cmd) ||
-                     std::holds_alternative<LoadCmd>(cmd) || imageWithText;
+                     std::holds_alternative<LoadCmd>(cmd);
 
-    // Only use minimal platform on Linux. Both Windows and MacOS X always have
-    // full platform available (as there is no real headless mode)
+    // Only use headless platforms on Linux. Both Windows and MacOS X always
+    // have full platform available (as there is no real headless mode)
 #ifdef Q_OS_LINUX
     if (!guiNeeded && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
-        qputenv("QT_QPA_PLATFORM", QByteArrayLiteral("minimal"));
+        qputenv("QT_QPA_PLATFORM", std::holds_alternative<ImageCmd>(cmd) ?
+                                   QByteArrayLiteral("offscreen") : QByteArrayLiteral("minimal"));
 #endif
 }
 
@@ -30,7 +30,9 @@ Settings::Settings()
     meanNodeLength = 40.0;
     minTotalGraphLength = 500.0;
     graphLayoutQuality = IntSetting(2, 0, 4);
+    graphLayoutAlgorithm = FMMM_LAYOUT;
     linearLayout = false;
+    incrementalLayout = false;
     minimumNodeLength = FloatSetting(5.0, 1.0, 100.0);
     edgeLength = FloatSetting(5.0, 0.1, 100.0);
     doubleModeNodeSeparation = FloatSetting(2.0, 0.0, 100.0);
@@ -74,6 +76,7 @@ Settings::Settings()
     labelFont = QFont();
     textOutline = false;
     antialiasing = true;
+    levelOfDetail = true;
     positionTextNodeCentre = false;
 
     nodeDragging = NEARBY_PIECES;
@@ -142,6 +145,12 @@ Settings::Settings()
     minDepthRange = FloatSetting(10.0, 0.0, 1000000.0);
     maxDepthRange = FloatSetting(100.0, 0.0, 1000000.0);
 
+    threads = IntSetting(1, 1, 256);
+    layoutThreads = IntSetting(0, 0, 256);
+    layoutCacheSize = IntSetting(1024, 0, 1000000);
+    searchCacheSize = IntSetting(16384, 0, 1000000);
+    queryPathSearchLimit = IntSetting(1000000, 0, 1000000000);
+
     annotationsSettings = {};
 }
 
@@ -85,6 +85,7 @@ using AnnotationSettings = std::unordered_map<AnnotationGroupId, AnnotationSetti
 
 enum NodeLengthMode {AUTO_NODE_LENGTH, MANUAL_NODE_LENGTH};
 enum NodeDragging {ONE_PIECE, NEARBY_PIECES, ALL_PIECES, NO_DRAGGING};
+enum GraphLayoutAlgorithm {FMMM_LAYOUT, MULTILEVEL_LAYOUT};
 
 class Settings
 {
@@ -99,7 +100,10 @@ public:
     double meanNodeLength;
     double minTotalGraphLength;
     IntSetting graphLayoutQuality;
+    GraphLayoutAlgorithm graphLayoutAlgorithm;
     bool linearLayout;
+    // Keep the positions of already drawn nodes when redrawing the graph
+    bool incrementalLayout;
     FloatSetting minimumNodeLength;
     FloatSetting edgeLength;
     FloatSetting doubleModeNodeSeparation;
@@ -146,6 +150,8 @@ public:
     QFont labelFont;
     bool textOutline;
     bool antialiasing;
+    //Nodes and edges only a few pixels large on screen are drawn simplified
+    bool levelOfDetail;
     bool positionTextNodeCentre;
 
     NodeDragging nodeDragging;
@@ -224,6 +230,27 @@ public:
     FloatSetting minDepthRange;
     FloatSetting maxDepthRange;
 
+    //The number of worker threads used for graph loading, analysis and
+    //graph searches.
+    IntSetting threads;
+
+    //The number of threads computing the forces in the layout of large
+    //components, zero to use all cores.
+    IntSetting layoutThreads;
+
+    //The size limit (in megabytes) of the on-disk cache of computed
+    //layouts, zero disables the cache.
+    IntSetting layoutCacheSize;
+
+    //The size limit (in megabytes) of the on-disk cache of the graph
+    //sequence databases for the BLAST and minimap2 searches, zero
+    //disables the cache.
+    IntSetting searchCacheSize;
+
+    //The number of partial paths examined when looking for the paths of a
+    //single query, zero for no limit.
+    IntSetting queryPathSearchLimit;
+
     //This controls annotations drawing.
     AnnotationSettings annotationsSettings;
 
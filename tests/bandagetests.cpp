@@ -23,10 +23,15 @@
 #include "graph/graphicsitemnode.h"
 #include "graph/annotationsmanager.h"
 #include "graph/gfawriter.h"
+#include "graph/graphstatistics.h"
 #include "graph/io.h"
+#include "graph/pathfinder.h"
+#include "graph/sequenceutils.h"
 
 #include "layout/graphlayoutworker.h"
+#include "layout/fmelayouter.h"
 #include "layout/io.h"
+#include "layout/layoutcache.h"
 
 #include "program/settings.h"
 #include "program/memory.h"
@@ -34,15 +39,32 @@
 #include "command_line/commoncommandlinefunctions.h"
 #include "command_line/settings.h"
 
+#include "ui/graphrenderer.h"
+
 #include "graphsearch/blast/blastsearch.h"
+#include "graphsearch/hitparser.h"
+#include "graphsearch/searchdatabase.h"
+#include "graphsearch/minimizer/minimizersearch.h"
+
+#include "seq/kernels.hpp"
+
+#include "ogdf/basic/GraphAttributes.h"
 
 #include <CLI/CLI.hpp>
 
 #include <QtTest/QtTest>
 #include <QDebug>
+#include <QPainter>
 #include <QTemporaryDir>
+#include <QStandardPaths>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <tuple>
 
 class BandageTests : public QObject
 {
@@ -90,6 +112,11 @@ public:
 
 private slots:
     void init() {
+        // Keep the search databases and layouts away from the user cache
+        QStandardPaths::setTestModeEnabled(true);
+        QDir(search::SearchDatabase::cacheDirectory()).removeRecursively();
+        QDir(layout::cache::directory()).removeRecursively();
+
         g_settings.reset(new Settings());
         g_memory.reset(new Memory());
         g_blastSearch.reset(new search::BlastSearch(QDir(".")));
@@ -98,12 +125,17 @@ private slots:
     }
 
     void cleanup() {
+        QDir(search::SearchDatabase::cacheDirectory()).removeRecursively();
+        QDir(layout::cache::directory()).removeRecursively();
     }
 
     void loadFastg();
     void loadGFAWithPlaceholders();
     void loadGFA12();
     void loadGFA();
+    void loadGFAParallel();
+    void loadGFANoTrailingNewline();
+    void loadGFALinksBeforeSegments();
     void loadGAF();
     void loadSPAdesPaths();
     void loadTrinity();
@@ -118,17 +150,40 @@ private slots:
     void blastSearchFilters();
     void graphScope();
     void graphLayout();
+    void multilevelLayout();
+    void fmeLayout();
+    void incrementalLayout();
+    void binaryLayout();
+    void layoutCache();
+    void nodeShapeCache();
+    void tiledRendering();
+    void hitsInExportedImage();
+    void minimizerSearch();
+    void hitParsing();
+    void searchDatabaseCache();
+    void searchDatabaseAfterEdit();
+    void searchDatabaseEvalues();
+    void shardedBlastSearch();
+    void pathFinder();
+    void layoutManyComponents();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
     void fastgToGfa();
+    void saveCompressedGfa();
     void mergeNodesOnGfa();
     void changeNodeNames();
+    void graphStorage();
+    void graphAdjacency();
+    void sequenceSharing();
     void changeNodeDepths();
     void blastQueryPaths();
     void bandageInfo();
+    void graphStatistics();
     void sequenceInit();
     void sequenceInitN();
+    void sequenceAbsent();
+    void sequenceKernels();
     void sequenceAccess();
     void sequenceSubstring();
     void sequenceDoubleReverseComplement();
@@ -137,6 +192,7 @@ private slots:
 private:
     DeBruijnEdge * getEdgeFromNodeNames(QString startingNodeName,
                                         QString endingNodeName) const;
+    QStringList describeGraph(const AssemblyGraph &graph) const;
     bool doCircularSequencesMatch(QByteArray s1, QByteArray s2) const;
 };
 
@@ -211,6 +267,69 @@ void BandageTests::loadGFA()
     QCOMPARE(node14->getLength(), 120);
 }
 
+void BandageTests::loadGFAParallel()
+{
+    for (const char *fileName : { "test.gfa", "test_not_defined.gfa", "test_gfa12.gfa.gz", "test_plasmids.gfa" }) {
+        g_settings->threads = 1;
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile(fileName)));
+        QStringList serial = describeGraph(*g_assemblyGraph);
+
+        // The parallel load must produce exactly the same graph
+        g_settings->threads = 4;
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile(fileName)));
+        QCOMPARE(describeGraph(*g_assemblyGraph), serial);
+    }
+}
+
+void BandageTests::loadGFANoTrailingNewline()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    QStringList expected = describeGraph(*g_assemblyGraph);
+
+    // Uncompressed files are parsed straight from the mapping, make sure the
+    // last line is not lost if it is not newline-terminated
+    QFile input(testFile("test.gfa"));
+    QVERIFY(input.open(QIODevice::ReadOnly));
+    QByteArray contents = input.readAll();
+    while (contents.endsWith('\n'))
+        contents.chop(1);
+
+    QFile output(tempFile("test_no_newline.gfa"));
+    QVERIFY(output.open(QIODevice::WriteOnly));
+    output.write(contents);
+    output.close();
+
+    for (int threads : { 1, 4 }) {
+        g_settings->threads = threads;
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_no_newline.gfa")));
+        QCOMPARE(describeGraph(*g_assemblyGraph), expected);
+    }
+}
+
+void BandageTests::loadGFALinksBeforeSegments()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    QStringList expected = describeGraph(*g_assemblyGraph);
+
+    // Put all the links in front of the segments they refer to
+    QFile input(testFile("test.gfa"));
+    QVERIFY(input.open(QIODevice::ReadOnly));
+    QByteArrayList links, others;
+    for (const QByteArray &line : input.readAll().split('\n'))
+        (line.startsWith('L') ? links : others).push_back(line);
+
+    QFile output(tempFile("test_links_first.gfa"));
+    QVERIFY(output.open(QIODevice::WriteOnly));
+    output.write((links + others).join('\n'));
+    output.close();
+
+    for (int threads : { 1, 4 }) {
+        g_settings->threads = threads;
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_links_first.gfa")));
+        QCOMPARE(describeGraph(*g_assemblyGraph), expected);
+    }
+}
+
 void BandageTests::loadGAF()
 {
     // Check that the graph loaded properly.
@@ -917,6 +1036,127 @@ static void parseSettings(const QStringList &commandLineSettings) {
 #endif
 }
 
+void BandageTests::layoutManyComponents() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.Trinity.fasta")));
+
+    QString errorTitle;
+    QString errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph, scope);
+    g_assemblyGraph->resetNodes();
+    g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+    QCOMPARE(layout.size(), g_assemblyGraph->getDrawnNodeCount());
+
+    for (const auto &entry : layout) {
+        for (QPointF point : entry.second)
+            QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+
+        // Isolated nodes are placed as straight lines without running FMMM
+        if (!entry.first->edges().empty())
+            continue;
+        QPointF first = entry.second.front(), last = entry.second.back();
+        QVERIFY(first != last);
+        for (QPointF point : entry.second) {
+            double cross = (last.x() - first.x()) * (point.y() - first.y()) -
+                           (last.y() - first.y()) * (point.x() - first.x());
+            QVERIFY(std::abs(cross) < 1e-6 * QLineF(first, last).length() * QLineF(first, last).length());
+        }
+    }
+}
+
+void BandageTests::multilevelLayout() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->graphLayoutAlgorithm = MULTILEVEL_LAYOUT;
+
+    QString errorTitle;
+    QString errorMessage;
+    for (bool doubleMode : { false, true }) {
+        g_settings->doubleMode = doubleMode;
+        auto scope = graph::Scope::wholeGraph();
+        auto startingNodes =
+                graph::getStartingNodes(&errorTitle, &errorMessage,
+                                        *g_assemblyGraph, scope);
+        g_assemblyGraph->resetNodes();
+        g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+
+        auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        g_settings->linearLayout,
+                                        g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+        QCOMPARE(layout.size(), doubleMode ? 88 : 44);
+        for (const auto &entry : layout) {
+            // Every segment of a node expanded back from the coarse graph
+            // gets its own position
+            QVERIFY(entry.second.size() >= 2);
+            for (QPointF point : entry.second)
+                QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+            QVERIFY(entry.second.front() != entry.second.back());
+        }
+    }
+
+    // Selectable from the command line
+    g_settings.reset(new Settings());
+    parseSettings({ "--layout", "multilevel" });
+    QCOMPARE(g_settings->graphLayoutAlgorithm, MULTILEVEL_LAYOUT);
+}
+
+void BandageTests::fmeLayout() {
+    // A long cycle with a few shortcuts, large enough for the fast multipole
+    // embedder to be used by the layout worker
+    ogdf::Graph G;
+    ogdf::EdgeArray<double> edgeLengths(G);
+    ogdf::GraphAttributes GA(G,
+                             ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+    const int n = 12000;
+    std::vector<ogdf::node> nodes;
+    for (int i = 0; i < n; ++i) {
+        ogdf::node v = G.newNode();
+        GA.width(v) = GA.height(v) = g_settings->edgeLength;
+        nodes.push_back(v);
+    }
+    for (int i = 0; i < n; ++i)
+        edgeLengths[G.newEdge(nodes[i], nodes[(i + 1) % n])] = g_settings->nodeSegmentLength;
+    for (int i = 0; i < n; i += 500)
+        edgeLengths[G.newEdge(nodes[i], nodes[(i + n / 3) % n])] = g_settings->edgeLength;
+
+    for (unsigned threads : { 1u, 4u }) {
+        FMEGraphLayout layouter(threads, g_settings->graphLayoutQuality,
+                                false, g_settings->componentSeparation);
+        layouter.init();
+        layouter.run(GA, edgeLengths);
+
+        for (ogdf::node v : G.nodes)
+            QVERIFY(std::isfinite(GA.x(v)) && std::isfinite(GA.y(v)));
+
+        // Scaled to the desired edge lengths, adjacent nodes are much closer
+        // than arbitrary ones
+        double desired = 0, adjacent = 0, arbitrary = 0;
+        for (ogdf::edge e : G.edges) {
+            desired += edgeLengths[e];
+            adjacent += QLineF(GA.x(e->source()), GA.y(e->source()),
+                               GA.x(e->target()), GA.y(e->target())).length();
+        }
+        for (int i = 0; i < n; ++i) {
+            ogdf::node a = nodes[i], b = nodes[(i * 7919 + 13) % n];
+            arbitrary += QLineF(GA.x(a), GA.y(a), GA.x(b), GA.y(b)).length();
+        }
+        QVERIFY(std::abs(adjacent / desired - 1) < 1e-3);
+        QVERIFY(arbitrary / n > 20 * adjacent / G.numberOfEdges());
+    }
+
+    g_settings.reset(new Settings());
+    QCOMPARE(g_settings->layoutThreads.val, 0);
+    parseSettings({ "--layoutthreads", "8" });
+    QCOMPARE(g_settings->layoutThreads.val, 8);
+}
+
+
 
 void BandageTests::commandLineSettings() {
     QStringList commandLineSettings;
@@ -1034,6 +1274,11 @@ void BandageTests::commandLineSettings() {
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->antialiasing, false);
 
+    QCOMPARE(g_settings->levelOfDetail, true);
+    commandLineSettings = QString("--nolod").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->levelOfDetail, false);
+
     commandLineSettings = QString("--textcol #550000ff").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->textColour.name(), QString("#0000ff"));
@@ -1371,6 +1616,32 @@ void BandageTests::fastgToGfa()
 }
 
 
+void BandageTests::saveCompressedGfa()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+    QVERIFY(gfa::saveEntireGraph(tempFile("test_temp.gfa"), *g_assemblyGraph));
+    QVERIFY(gfa::saveEntireGraph(tempFile("test_temp.gfa.gz"), *g_assemblyGraph));
+    QVERIFY(gfa::saveEntireGraph(tempFile("test_temp_bgzf.gfa.gz"), *g_assemblyGraph, io::Compression::Bgzf));
+
+    // Both compressed flavours are gzip, BGZF additionally has its extra field
+    for (const char *fileName : { "test_temp.gfa.gz", "test_temp_bgzf.gfa.gz" }) {
+        QFile file(tempFile(fileName));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QByteArray header = file.read(18);
+        QVERIFY(header.startsWith("\x1f\x8b"));
+        QCOMPARE(header.mid(12, 2) == "BC", fileName == std::string_view("test_temp_bgzf.gfa.gz"));
+    }
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_temp.gfa")));
+    QStringList expected = describeGraph(*g_assemblyGraph);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 18);
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_temp.gfa.gz")));
+    QCOMPARE(describeGraph(*g_assemblyGraph), expected);
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(tempFile("test_temp_bgzf.gfa.gz")));
+    QCOMPARE(describeGraph(*g_assemblyGraph), expected);
+}
+
 void BandageTests::mergeNodesOnGfa()
 {
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
@@ -1448,6 +1719,95 @@ void BandageTests::changeNodeNames()
     QCOMPARE(node6Plus, node12345Plus);
     QCOMPARE(node6Minus, node12345Minus);
     QCOMPARE(nodeCountBefore, nodeCountAfter);
+    QCOMPARE(node12345Plus->getName(), QString("12345+"));
+    QCOMPARE(node12345Minus->getNameWithoutSign(), QString("12345"));
+}
+
+void BandageTests::graphStorage()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+
+    auto memory = g_assemblyGraph->getMemoryUsage();
+    QCOMPARE(memory.nodeCount, g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QCOMPARE(memory.edgeCount, g_assemblyGraph->m_deBruijnGraphEdges.size());
+    QVERIFY(memory.nodeBytes >= memory.nodeCount * sizeof(DeBruijnNode));
+    QVERIFY(memory.edgeBytes >= memory.edgeCount * sizeof(DeBruijnEdge));
+    QVERIFY(memory.nameBytes > 0);
+
+    // Deleted nodes free their slots for reuse
+    DeBruijnNode * node6Plus = g_assemblyGraph->m_deBruijnGraphNodes["6+"];
+    g_assemblyGraph->deleteNodes({ node6Plus });
+    QCOMPARE(g_assemblyGraph->getMemoryUsage().nodeCount, memory.nodeCount - 2);
+    QCOMPARE(g_assemblyGraph->getMemoryUsage().nodeBytes, memory.nodeBytes);
+
+    g_assemblyGraph->cleanUp();
+    memory = g_assemblyGraph->getMemoryUsage();
+    QCOMPARE(memory.nodeCount, size_t(0));
+    QCOMPARE(memory.edgeCount, size_t(0));
+    QCOMPARE(memory.nodeBytes, size_t(0));
+    QCOMPARE(memory.nameBytes, size_t(0));
+}
+
+void BandageTests::graphAdjacency()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+
+    const auto *adj = &g_assemblyGraph->adjacency();
+    QCOMPARE(adj->nodeCount(), g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QCOMPARE(adj->edgeCount(), g_assemblyGraph->m_deBruijnGraphEdges.size());
+
+    for (graph::Adjacency::NodeId id = 0; id < adj->nodeCount(); ++id) {
+        DeBruijnNode *node = adj->node(id);
+        QCOMPARE(adj->id(node), id);
+        QCOMPARE(node->getReverseComplement(), adj->node(adj->rc(id)));
+        QCOMPARE(graph::Adjacency::isPositive(id), node->isPositiveNode());
+        QCOMPARE(adj->outDegree(id), node->getLeavingEdges().size());
+        QCOMPARE(adj->inDegree(id), node->getEnteringEdges().size());
+        for (auto *edge : adj->outgoingEdges(id))
+            QCOMPARE(edge->getStartingNode(), node);
+    }
+
+    // Snapshot is rebuilt after graph edits
+    g_assemblyGraph->deleteNodes({ g_assemblyGraph->m_deBruijnGraphNodes["6+"] });
+    adj = &g_assemblyGraph->adjacency();
+    QCOMPARE(adj->nodeCount(), g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QCOMPARE(adj->edgeCount(), g_assemblyGraph->m_deBruijnGraphEdges.size());
+}
+
+void BandageTests::sequenceSharing()
+{
+    // Reverse complement nodes must be views of the positive node buffer, so
+    // sequence storage is half of what storing every node separately takes.
+    // Duplicated nodes share the buffer of the original ones as well.
+    auto checkSharing = [](const QString &context, bool checkTotal = true) {
+        size_t unsharedBytes = 0;
+        for (const auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+            const auto *rcNode = node->getReverseComplement();
+            QVERIFY2(rcNode, qPrintable(context));
+            QVERIFY2(node->getSequence().buffer() == rcNode->getSequence().buffer(),
+                     qPrintable(context + ": " + node->getName()));
+            unsharedBytes += node->getSequence().capacity();
+        }
+
+        if (!checkTotal)
+            return;
+
+        auto memory = g_assemblyGraph->getMemoryUsage();
+        QVERIFY2(memory.sequenceBytes > 0, qPrintable(context));
+        QCOMPARE(memory.sequenceBytes * 2, unsharedBytes);
+    };
+
+    for (const char *file : { "test.fastg", "test.gfa", "test_plasmids.gfa", "test.Trinity.fasta",
+                              "test_plasmids_separate_sequences.gfa" }) {
+        QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile(file)));
+        checkSharing(file);
+    }
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_assemblyGraph->duplicateNodePair(g_assemblyGraph->m_deBruijnGraphNodes["26+"], nullptr);
+    checkSharing("duplicateNodePair", false);
+    g_assemblyGraph->mergeAllPossible();
+    checkSharing("mergeAllPossible", false);
 }
 
 void BandageTests::changeNodeDepths()
@@ -1632,47 +1992,106 @@ void BandageTests::blastQueryPaths() {
 
 void BandageTests::bandageInfo()
 {
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    int componentCount = 0;
-    int largestComponentLength = 0;
-
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(44, g_assemblyGraph->m_nodeCount);
-    QCOMPARE(59, g_assemblyGraph->m_edgeCount);
-    QCOMPARE(214441, g_assemblyGraph->m_totalLength);
-    QCOMPARE(0, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(35628, n50);
-    QCOMPARE(78, shortestNode);
-    QCOMPARE(52213, longestNode);
-    QCOMPARE(1, componentCount);
-    QCOMPARE(214441, largestComponentLength);
+    graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph);
+    QCOMPARE(44, stats.nodeCount);
+    QCOMPARE(59, stats.edgeCount);
+    QCOMPARE(214441, stats.totalLength);
+    QCOMPARE(0u, stats.deadEnds);
+    QCOMPARE(35628, stats.n50);
+    QCOMPARE(78, stats.shortestNode);
+    QCOMPARE(52213, stats.longestNode);
+    QCOMPARE(1, stats.componentCount);
+    QCOMPARE(214441, stats.largestComponentLength);
 
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.Trinity.fasta")));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(149, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(66, componentCount);
-    QCOMPARE(9398, largestComponentLength);
+    stats = graph::computeStatistics(*g_assemblyGraph);
+    QCOMPARE(149u, stats.deadEnds);
+    QCOMPARE(66, stats.componentCount);
+    QCOMPARE(9398, stats.largestComponentLength);
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    stats = graph::computeStatistics(*g_assemblyGraph);
+    QCOMPARE(17, stats.nodeCount);
+    QCOMPARE(16, stats.edgeCount);
+    QCOMPARE(30959, stats.totalLength);
+    QCOMPARE(10u, stats.deadEnds);
+    QCOMPARE(2060, stats.n50);
+    QCOMPARE(119, stats.shortestNode);
+    QCOMPARE(2060, stats.longestNode);
+    QCOMPARE(1, stats.componentCount);
+    QCOMPARE(30959, stats.largestComponentLength);
+}
 
+void BandageTests::graphStatistics()
+{
     QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    QCOMPARE(17, g_assemblyGraph->m_nodeCount);
-    QCOMPARE(16, g_assemblyGraph->m_edgeCount);
-    QCOMPARE(30959, g_assemblyGraph->m_totalLength);
-    QCOMPARE(10, g_assemblyGraph->getDeadEndCount());
-    QCOMPARE(2060, n50);
-    QCOMPARE(119, shortestNode);
-    QCOMPARE(2060, longestNode);
-    QCOMPARE(1, componentCount);
-    QCOMPARE(30959, largestComponentLength);
+    for (unsigned threads : { 1u, 4u }) {
+        graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph, threads);
+        QCOMPARE(stats.nodeCount, 17);
+        QCOMPARE(stats.edgeCount, 16);
+        QCOMPARE(stats.totalLength, 30959);
+        QCOMPARE(stats.totalLengthNoOverlaps, 30959 - 17 * 60);
+        QCOMPARE(stats.smallestOverlap, 60);
+        QCOMPARE(stats.largestOverlap, 60);
+        QCOMPARE(stats.deadEnds, 10u);
+        QCOMPARE(stats.componentCount, 1);
+        QCOMPARE(stats.largestComponentLength, 30959);
+        QCOMPARE(stats.totalLengthOrphanedNodes, 0);
+        QCOMPARE(stats.n50, 2060);
+        QCOMPARE(stats.shortestNode, 119);
+        QCOMPARE(stats.firstQuartile, 2001);
+        QCOMPARE(stats.median, 2060);
+        QCOMPARE(stats.thirdQuartile, 2060);
+        QCOMPARE(stats.longestNode, 2060);
+        QCOMPARE(stats.medianDepthByBase, 532.0419921875);
+        QCOMPARE(stats.estimatedSequenceLength, 25939);
+    }
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test_plasmids.gfa")));
+    for (unsigned threads : { 1u, 4u }) {
+        graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph, threads);
+        QCOMPARE(stats.nodeCount, 9);
+        QCOMPARE(stats.edgeCount, 12);
+        QCOMPARE(stats.totalLength, 14789);
+        QCOMPARE(stats.totalLengthNoOverlaps, 14789 - 9 * 81);
+        QCOMPARE(stats.smallestOverlap, 81);
+        QCOMPARE(stats.largestOverlap, 81);
+        QCOMPARE(stats.deadEnds, 0u);
+        QCOMPARE(stats.componentCount, 1);
+        QCOMPARE(stats.largestComponentLength, 14789);
+        QCOMPARE(stats.totalLengthOrphanedNodes, 0);
+        QCOMPARE(stats.n50, 4149);
+        QCOMPARE(stats.shortestNode, 89);
+        QCOMPARE(stats.firstQuartile, 528);
+        QCOMPARE(stats.median, 895);
+        QCOMPARE(stats.thirdQuartile, 1854);
+        QCOMPARE(stats.longestNode, 4399);
+        QCOMPARE(stats.medianDepthByBase, 56.6192626953125);
+        QCOMPARE(stats.estimatedSequenceLength, 14597);
+    }
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    for (unsigned threads : { 1u, 4u }) {
+        graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph, threads);
+        QCOMPARE(stats.nodeCount, 44);
+        QCOMPARE(stats.totalLength, 214441);
+        QCOMPARE(stats.n50, 35628);
+        QCOMPARE(stats.shortestNode, 78);
+        QCOMPARE(stats.firstQuartile, 128);
+        QCOMPARE(stats.median, 356);
+        QCOMPARE(stats.thirdQuartile, 2139);
+        QCOMPARE(stats.longestNode, 52213);
+        QCOMPARE(stats.medianDepthByBase, 42.141700744628906);
+    }
+
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.Trinity.fasta")));
+    for (unsigned threads : { 1u, 4u }) {
+        graph::Statistics stats = graph::computeStatistics(*g_assemblyGraph, threads);
+        QCOMPARE(stats.deadEnds, 149u);
+        QCOMPARE(stats.componentCount, 66);
+        QCOMPARE(stats.largestComponentLength, 9398);
+    }
 }
 
 void BandageTests::sequenceInit() {
@@ -1699,6 +2118,80 @@ void BandageTests::sequenceInitN() {
     QCOMPARE(sequenceFromStringLower, sequenceFromQByteArray);
 }
 
+void BandageTests::sequenceAbsent() {
+    Sequence absent(10, /* allNs */ true);
+
+    QVERIFY(absent.absent());
+    QVERIFY(absent.missing());
+    QCOMPARE(absent.size(), 10);
+    QCOMPARE(absent.capacity(), 0);
+    QCOMPARE(absent[0], 'N');
+    QCOMPARE(absent[9], 'N');
+    QCOMPARE(absent.str(), std::string(10, 'N'));
+
+    Sequence absentRC = absent.GetReverseComplement();
+    QVERIFY(absentRC.absent());
+    QCOMPARE(absentRC.size(), 10);
+    QCOMPARE(absentRC, absent);
+
+    Sequence substr = absent.Subseq(2, 7);
+    QVERIFY(substr.absent());
+    QCOMPARE(substr.str(), std::string(5, 'N'));
+
+    // Compares equal to the explicit sequence of Ns
+    QCOMPARE(absent, Sequence{"NNNNNNNNNN"});
+    QVERIFY(absent != Sequence{"NNNNNNNNNA"});
+    QVERIFY(!Sequence{"NNNNNNNNNN"}.absent());
+}
+
+void BandageTests::sequenceKernels() {
+    // Every vectorized kernel must agree with the scalar one, including the
+    // block fallback for unusual characters and unaligned unpacking
+    std::mt19937 rng(42);
+    const auto &scalar = seq::kernels::get(seq::kernels::Isa::Scalar);
+    for (const char *alphabet : { "ACGT", "ACGTacgtNn", "ACGTNRY-" }) {
+        size_t alphabetSize = strlen(alphabet);
+        for (size_t n : { 0, 1, 31, 32, 33, 64, 100, 1000 }) {
+            std::string nucls(n, 'A');
+            for (auto &c : nucls)
+                c = alphabet[rng() % alphabetSize];
+
+            for (bool rc : { false, true }) {
+                std::vector<uint64_t> expected((n + 31) / 32), packed(expected.size());
+                std::vector<uint32_t> expectedNs, ns;
+                scalar.pack(nucls.data(), n, expected.data(), rc, expectedNs);
+
+                for (auto isa : { seq::kernels::Isa::SSE42, seq::kernels::Isa::AVX2 }) {
+                    if (!seq::kernels::supported(isa))
+                        continue;
+
+                    const auto &kernels = seq::kernels::get(isa);
+                    ns.clear();
+                    kernels.pack(nucls.data(), n, packed.data(), rc, ns);
+                    QVERIFY(packed == expected);
+                    QVERIFY(ns == expectedNs);
+
+                    for (size_t from : { size_t(0), size_t(5), n / 3 }) {
+                        if (from > n)
+                            continue;
+                        std::string expectedOut(n - from, '\0'), out(n - from, '\0');
+                        scalar.unpack(expected.data(), from, n - from, expectedOut.data(), rc);
+                        kernels.unpack(expected.data(), from, n - from, out.data(), rc);
+                        QCOMPARE(out, expectedOut);
+                    }
+                }
+            }
+
+            // Round trip through Sequence with the best kernels
+            std::string expected;
+            for (char c : nucls)
+                expected += is_N(c) ? 'N' : nucl(dignucl(c));
+            QCOMPARE(Sequence(nucls).str(), expected);
+            QCOMPARE(utils::sequenceToQByteArray(Sequence(nucls)), QByteArray::fromStdString(expected));
+        }
+    }
+}
+
 void BandageTests::sequenceAccess() {
     Sequence sequence{"ATGCN"};
 
@@ -1750,18 +2243,746 @@ void BandageTests::sequenceDoubleReverseComplement() {
     QCOMPARE(sequence, sequence.GetReverseComplement().GetReverseComplement());
 }
 
+void BandageTests::incrementalLayout() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    QString errorTitle;
+    QString errorMessage;
+    auto layoutAround = [&](unsigned distance, const GraphLayout *initialLayout) {
+        auto scope = graph::Scope::aroundNodes("1", distance);
+        auto startingNodes =
+                graph::getStartingNodes(&errorTitle, &errorMessage,
+                                        *g_assemblyGraph, scope);
+        g_assemblyGraph->resetNodes();
+        g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                                 g_settings->linearLayout,
+                                 g_settings->componentSeparation);
+        if (initialLayout)
+            worker.setInitialLayout(*initialLayout);
+        return worker.layoutGraph(*g_assemblyGraph);
+    };
+
+    auto small = layoutAround(1, nullptr);
+    QVERIFY(small.size() > 0);
+
+    // Nothing new to draw, everything stays exactly where it was
+    auto same = layoutAround(1, &small);
+    QCOMPARE(same.size(), small.size());
+    for (const auto &entry : small) {
+        QVERIFY(same.contains(entry.first));
+        QCOMPARE(same.segments(entry.first).size(), entry.second.size());
+        for (size_t i = 0; i < entry.second.size(); ++i)
+            QCOMPARE(same.segments(entry.first)[i], entry.second[i]);
+    }
+
+    // Grown scope: the new nodes are placed around the old ones
+    auto large = layoutAround(3, &small);
+    QVERIFY(large.size() > small.size());
+    for (const auto &entry : large) {
+        QVERIFY(!entry.second.empty());
+        for (QPointF point : entry.second)
+            QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+    }
+
+    // The nodes drawn before are only refined, they stay close to where they
+    // were: within a small fraction of the size of the old drawing
+    double minX = std::numeric_limits<double>::max(), maxX = std::numeric_limits<double>::lowest();
+    double minY = minX, maxY = maxX;
+    for (const auto &entry : small) {
+        for (QPointF point : entry.second) {
+            minX = std::min(minX, point.x());
+            maxX = std::max(maxX, point.x());
+            minY = std::min(minY, point.y());
+            maxY = std::max(maxY, point.y());
+        }
+    }
+    double size = std::hypot(maxX - minX, maxY - minY);
+    QVERIFY(size > 0.0);
+
+    double totalShift = 0.0;
+    for (const auto &entry : small) {
+        QVERIFY(large.contains(entry.first));
+        const auto &oldPoints = entry.second;
+        const auto &newPoints = large.segments(entry.first);
+        for (auto [oldPoint, newPoint] : { std::make_pair(oldPoints.front(), newPoints.front()),
+                                           std::make_pair(oldPoints.back(), newPoints.back()) }) {
+            double shift = QLineF(oldPoint, newPoint).length();
+            QVERIFY(shift < 0.25 * size);
+            totalShift += shift;
+        }
+    }
+    QVERIFY(totalShift / (2 * small.size()) < 0.1 * size);
+}
+
+void BandageTests::binaryLayout() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
 
+    g_settings->doubleMode = true;
+    QString errorTitle;
+    QString errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph, scope);
+    g_assemblyGraph->resetNodes();
+    g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+    QVERIFY(layout::io::saveBinary(tempFile("test.blayout"), layout));
+
+    // Recognized by load() next to JSON
+    GraphLayout loaded(*g_assemblyGraph);
+    layout::io::load(tempFile("test.blayout"), loaded);
+    QCOMPARE(loaded.size(), layout.size());
+    for (const auto &entry : layout) {
+        QVERIFY(loaded.contains(entry.first));
+        const auto &points = loaded.segments(entry.first);
+        QCOMPARE(points.size(), entry.second.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            QCOMPARE(points[i].x(), double(float(entry.second[i].x())));
+            QCOMPARE(points[i].y(), double(float(entry.second[i].y())));
+        }
+    }
 
+    // The layout of a different graph is rejected
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.gfa")));
+    GraphLayout other(*g_assemblyGraph);
+    bool rejected = false;
+    try {
+        layout::io::load(tempFile("test.blayout"), other);
+    } catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    QVERIFY(rejected);
+    QCOMPARE(other.size(), 0);
+}
 
+void BandageTests::layoutCache() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
 
+    QString errorTitle;
+    QString errorMessage;
+    auto markAround = [&](unsigned distance) {
+        auto scope = graph::Scope::aroundNodes("1", distance);
+        auto startingNodes =
+                graph::getStartingNodes(&errorTitle, &errorMessage,
+                                        *g_assemblyGraph, scope);
+        g_assemblyGraph->resetNodes();
+        g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+    };
+    auto key = [&]() {
+        return layout::cache::key(*g_assemblyGraph,
+                                  g_settings->graphLayoutQuality,
+                                  g_settings->linearLayout,
+                                  g_settings->componentSeparation);
+    };
+
+    markAround(2);
+    QByteArray key2 = key();
+    QVERIFY(!layout::cache::load(*g_assemblyGraph, key2));
+
+    auto computed = layout::cache::layoutGraph(*g_assemblyGraph,
+                                               g_settings->graphLayoutQuality,
+                                               g_settings->linearLayout,
+                                               g_settings->componentSeparation);
+    auto cached = layout::cache::load(*g_assemblyGraph, key2);
+    QVERIFY(cached);
+    QCOMPARE(cached->size(), computed.size());
+    for (const auto &entry : computed) {
+        QVERIFY(cached->contains(entry.first));
+        QCOMPARE(cached->segments(entry.first).size(), entry.second.size());
+        QCOMPARE(cached->segments(entry.first).front().x(), double(float(entry.second.front().x())));
+    }
 
+    // Other drawn nodes or layout settings give another key
+    markAround(1);
+    QVERIFY(key() != key2);
+    QVERIFY(!layout::cache::load(*g_assemblyGraph, key()));
+    markAround(2);
+    QCOMPARE(key(), key2);
+    g_settings->nodeSegmentLength = g_settings->nodeSegmentLength * 2;
+    QVERIFY(key() != key2);
+
+    // Disabled cache is neither read nor written
+    g_settings.reset(new Settings());
+    g_settings->layoutCacheSize = 0;
+    QVERIFY(!layout::cache::load(*g_assemblyGraph, key2));
+}
 
+void BandageTests::nodeShapeCache() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+
+    std::vector<QPointF> linePoints{ { 0.0, 0.0 }, { 50.0, 0.0 }, { 100.0, 0.0 } };
+    GraphicsItemNode item(node, 1.0, linePoints);
+    item.setWidth(1.0, 10.0);
+    QRectF bounds = item.boundingRect();
+    QCOMPARE(item.shape().boundingRect().height(), 10.0);
+
+    // The cached shape follows the width...
+    item.setWidth(1.0, 20.0);
+    QCOMPARE(item.shape().boundingRect().height(), 20.0);
+    QVERIFY(item.boundingRect().height() > bounds.height());
+
+    // ... and the line points
+    for (auto &point : item.m_linePoints)
+        point += QPointF(0.0, 100.0);
+    item.remakePath();
+    QVERIFY(item.boundingRect().top() > bounds.bottom());
+    QVERIFY(item.shape().contains(QPointF(50.0, 100.0)));
+    QVERIFY(!item.shape().contains(QPointF(50.0, 0.0)));
+}
+
+void BandageTests::tiledRendering() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    QString errorTitle;
+    QString errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph, scope);
+    g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    GraphRenderer renderer(*g_assemblyGraph, layout);
+    QVERIFY(!renderer.sceneRect().isEmpty());
+
+    // The graph is drawn without any graphics items
+    QVERIFY(!node->hasGraphicsItem());
+
+    QSize imageSize(300, 200);
+    QImage whole = renderer.renderTile(imageSize, QRect(QPoint(0, 0), imageSize));
+    int drawnPixels = 0;
+    for (int y = 0; y < whole.height(); ++y)
+        for (int x = 0; x < whole.width(); ++x)
+            drawnPixels += whole.pixel(x, y) != qRgb(255, 255, 255);
+    QVERIFY(drawnPixels > 0);
+
+    // Drawing onto any painter gives the same image
+    QImage painted(imageSize, QImage::Format_RGB32);
+    painted.fill(Qt::white);
+    {
+        QPainter painter(&painted);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        renderer.render(painter, imageSize);
+    }
+    QCOMPARE(painted, whole);
+
+    // The streamed image matches the one rendered at once, except for
+    // some antialiasing at the tile borders
+    QVERIFY(renderer.savePNG(tempFile("tiled.png"), imageSize, 64, 4));
+    QImage tiled(tempFile("tiled.png"));
+    QCOMPARE(tiled.size(), imageSize);
+    int differentPixels = 0;
+    for (int y = 0; y < whole.height(); ++y)
+        for (int x = 0; x < whole.width(); ++x)
+            differentPixels += whole.pixel(x, y) != tiled.pixel(x, y);
+    QVERIFY(differentPixels < imageSize.width() * imageSize.height() / 100);
+
+    // 300 pixels need 9 halvings to get down to a single one
+    QVERIFY(renderer.saveDeepZoom(tempFile("tiled.dzi"), imageSize, 64, 4));
+    QVERIFY(QFile::exists(tempFile("tiled.dzi")));
+    QCOMPARE(QImage(tempFile("tiled_files/0/0_0.png")).size(), QSize(1, 1));
+    QCOMPARE(QImage(tempFile("tiled_files/9/4_3.png")).size(), QSize(300 - 4 * 64, 200 - 3 * 64));
+    QVERIFY(!QFile::exists(tempFile("tiled_files/10")));
+}
+
+void BandageTests::hitsInExportedImage() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->initializeColorer(GRAY_COLOR);
+    g_settings->levelOfDetail = true;
+
+    QString errorTitle;
+    QString errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph, scope);
+    g_assemblyGraph->markNodesToDraw(scope, startingNodes);
+    auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                    g_settings->linearLayout,
+                                    g_settings->componentSeparation).layoutGraph(*g_assemblyGraph);
+
+    // A hit over the whole node, only its solid view is shown
+    DeBruijnNode *node = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    auto &group = g_annotationsManager->createAnnotationGroup("Hits", AnnotationSetting{ false, { 0 } });
+    auto &annotation = group.annotationMap[node].emplace_back(
+            std::make_unique<Annotation>(0, node->getLength() - 1, "hit"));
+    annotation->addView(std::make_unique<SolidView>(1.0, QColor(Qt::blue)));
+
+    // Nodes about a pixel wide would be simplified in the view, the exported
+    // image still has the hit drawn on the node
+    GraphRenderer renderer(*g_assemblyGraph, layout);
+    double scale = 1.0 / g_settings->averageNodeWidth;
+    QRectF sceneRect = renderer.sceneRect();
+    QSize imageSize = (sceneRect.size() * scale).toSize();
+    QVERIFY(renderer.savePNG(tempFile("hits.png"), imageSize, 64, 4));
+    QImage image(tempFile("hits.png"));
+    QCOMPARE(image.size(), imageSize);
+
+    const DeBruijnNode *drawnNode = layout.contains(node) ? node : node->getReverseComplement();
+    QRectF nodeBounds;
+    for (QPointF point : layout.segments(drawnNode))
+        nodeBounds |= QRectF((point - sceneRect.topLeft()) * scale, QSizeF(1.0, 1.0));
+    QRect pixels = nodeBounds.toAlignedRect().adjusted(-2, -2, 2, 2) & image.rect();
+    int hitPixels = 0;
+    for (int y = pixels.top(); y <= pixels.bottom(); ++y) {
+        for (int x = pixels.left(); x <= pixels.right(); ++x) {
+            QRgb pixel = image.pixel(x, y);
+            hitPixels += qBlue(pixel) > qRed(pixel) + 60;
+        }
+    }
+    QVERIFY(hitPixels > 0);
+}
 
+void BandageTests::minimizerSearch() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
 
+    search::MinimizerSearch minimizerSearch(QDir("."));
+    auto errorString = minimizerSearch.doAutoGraphSearch(*g_assemblyGraph,
+                                                         testFile("test_queries1.fasta"));
+    QCOMPARE(errorString, "");
 
+    search::Query * exact = minimizerSearch.getQueryFromName("test_query_exact");
+    search::Query * one_mismatch = minimizerSearch.getQueryFromName("test_query_one_mismatch");
+    search::Query * one_insertion = minimizerSearch.getQueryFromName("test_query_one_insertion");
+    QVERIFY(exact != nullptr);
+    QVERIFY(one_mismatch != nullptr);
+    QVERIFY(one_insertion != nullptr);
 
+    // The exact query only occurs on one strand of one node. The chained
+    // seeds are extended over the matching bases, so it is found whole.
+    QCOMPARE(exact->hitCount(), 1);
+    const auto &exactHit = exact->getHits().at(0);
+    QCOMPARE(exactHit->m_node->getName(), "2+");
+    QCOMPARE(exactHit->m_queryStart, 1);
+    QCOMPARE(exactHit->m_queryEnd, 100);
+    QCOMPARE(exactHit->getNodeSequence(), exact->getSequence().toLatin1());
+    int exactNodeStart = exactHit->m_nodeStart;
+
+    // The hits are not aligned, they have no e-value or identity
+    QVERIFY(!exactHit->hasEValue());
+    QVERIFY(!exactHit->hasPercentIdentity());
+    QVERIFY(exact->getPathCount() > 0);
+    QVERIFY(std::isnan(exact->getPaths()[0].getEvalueProduct().toDouble()));
+    QVERIFY(exact->getPaths()[0].getMeanHitPercIdentity() < 0);
+
+    // Mismatches and small gaps do not break the chain
+    QVERIFY(one_mismatch->hasHits());
+    QCOMPARE(one_mismatch->getHits().at(0)->m_queryStart, 1);
+    QCOMPARE(one_mismatch->getHits().at(0)->m_queryEnd, 100);
+    QVERIFY(one_insertion->hasHits());
+    QCOMPARE(one_insertion->getHits().at(0)->m_queryEnd, 101);
+    QCOMPARE(one_insertion->getHits().at(0)->getNodeLength(), 100);
+
+    // The index is kept, searching again gives the same hits
+    minimizerSearch.clearHits();
+    QVERIFY(!exact->hasHits());
+    QCOMPARE(minimizerSearch.doSearch(""), "");
+    QCOMPARE(exact->hitCount(), 1);
+    QCOMPARE(exact->getHits().at(0)->m_nodeStart, exactNodeStart);
+
+    // Neither the e-value nor the identity filters drop them
+    g_settings->blastEValueFilter.on = true;
+    g_settings->blastEValueFilter = SciNot(1.0, -50);
+    g_settings->blastIdentityFilter.on = true;
+    g_settings->blastIdentityFilter = 99.0;
+    g_settings->maxEValueProduct.on = true;
+    g_settings->maxEValueProduct = SciNot(1.0, -50);
+    minimizerSearch.clearHits();
+    QCOMPARE(minimizerSearch.doSearch(""), "");
+    QCOMPARE(exact->hitCount(), 1);
+    QVERIFY(exact->getPathCount() > 0);
+}
 
+void BandageTests::hitParsing() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
 
+    search::BlastSearch blastSearch(QDir("."));
+    QCOMPARE(blastSearch.loadQueriesFromFile(testFile("test_queries1.fasta")), 4);
+    search::Query *exact = blastSearch.getQueryFromName("test_query_exact");
+    search::Query *one_mismatch = blastSearch.getQueryFromName("test_query_one_mismatch");
+    search::Query *one_insertion = blastSearch.getQueryFromName("test_query_one_insertion");
+    QVERIFY(exact != nullptr);
+    QVERIFY(one_mismatch != nullptr);
+    QVERIFY(one_insertion != nullptr);
+
+    std::string label = g_assemblyGraph->m_deBruijnGraphNodes["2+"]->getNodeNameForFasta(true).toStdString();
+
+    // The output comes in arbitrary chunks, lines are split between them
+    auto feed = [](search::HitParser &parser, const std::string &output) {
+        for (size_t i = 0; i < output.size(); i += 7)
+            parser.addData(std::string_view(output).substr(i, 7));
+        parser.finish();
+    };
+
+    g_settings->blastAlignmentLengthFilter.on = true;
+    g_settings->blastAlignmentLengthFilter = 50;
+    {
+        std::string blastOutput =
+                "test_query_exact\t" + label + "\t100.000\t100\t0\t0\t1\t100\t11\t110\t1.5e-50\t185\n"
+                "test_query_exact\t" + label + "\t100.000\t100\t0\t0\t1\t100\t110\t11\t1.5e-50\t185\n"
+                "test_query_one_mismatch\t" + label + "\t99.000\t100\t1\t0\t1\t100\t11\t110\t2e-48\t180\n"
+                "test_query_unknown\t" + label + "\t100.000\t100\t0\t0\t1\t100\t11\t110\t1e-50\t185\n"
+                "malformed\tline\n"
+                "test_query_one_insertion\t" + label + "\t100.000\t30\t0\t0\t1\t30\t11\t40\t1e-10\t55\n";
+
+        search::HitParser parser(search::HitParser::BLAST_TABULAR, blastSearch.queries());
+        feed(parser, blastOutput);
+
+        // Reverse strand, unknown query, malformed line and short alignment
+        // are all dropped
+        QCOMPARE(parser.hitCount(), 2);
+        QCOMPARE(parser.queriesSeen(), 4);
+        blastSearch.queries().addNodeHits(parser.takeNodeHits());
+
+        QCOMPARE(exact->hitCount(), 1);
+        const auto &hit = exact->getHits().at(0);
+        QCOMPARE(hit->m_node->getName(), "2+");
+        QCOMPARE(hit->m_queryStart, 1);
+        QCOMPARE(hit->m_queryEnd, 100);
+        QCOMPARE(hit->m_nodeStart, 11);
+        QCOMPARE(hit->m_nodeEnd, 110);
+        QCOMPARE(hit->m_eValue, SciNot(1.5, -50));
+        QCOMPARE(hit->m_bitScore, 185.0);
+        QCOMPARE(one_mismatch->hitCount(), 1);
+        QCOMPARE(one_mismatch->getHits().at(0)->m_percentIdentity, 99.0);
+        QVERIFY(!one_insertion->hasHits());
+    }
+
+    blastSearch.clearHits();
+    g_settings->blastIdentityFilter.on = true;
+    g_settings->blastIdentityFilter = 99.5;
+    {
+        // PAF coordinates are 0-based, the identity is matches over the
+        // block length. The last line has no newline.
+        std::string pafOutput =
+                "test_query_exact\t100\t0\t100\t+\t" + label + "\t200\t10\t110\t100\t100\t60\n"
+                "test_query_one_mismatch\t100\t0\t100\t+\t" + label + "\t200\t10\t110\t99\t100\t60\n"
+                "test_query_one_insertion\t101\t0\t101\t-\t" + label + "\t200\t10\t110\t100\t101\t60";
+
+        search::HitParser parser(search::HitParser::PAF, blastSearch.queries());
+        feed(parser, pafOutput);
+
+        QCOMPARE(parser.hitCount(), 1);
+        QCOMPARE(parser.queriesSeen(), 3);
+        blastSearch.queries().addNodeHits(parser.takeNodeHits());
+
+        QCOMPARE(exact->hitCount(), 1);
+        const auto &hit = exact->getHits().at(0);
+        QCOMPARE(hit->m_queryStart, 1);
+        QCOMPARE(hit->m_queryEnd, 100);
+        QCOMPARE(hit->m_nodeStart, 11);
+        QCOMPARE(hit->m_nodeEnd, 110);
+        QCOMPARE(hit->m_percentIdentity, 100.0);
+        QVERIFY(!one_mismatch->hasHits());
+        QVERIFY(!one_insertion->hasHits());
+    }
+}
+
+void BandageTests::searchDatabaseCache() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+    size_t nodesWithSequences = 0;
+    for (const auto *node : g_assemblyGraph->m_deBruijnGraphNodes)
+        nodesWithSequences += !node->sequenceIsMissing();
+
+    QTemporaryDir fallback;
+    std::atomic<bool> cancel = false;
+    search::SearchDatabase database(fallback.path());
+    QCOMPARE(database.build(*g_assemblyGraph, false, cancel), "");
+    QCOMPARE(database.volumes().size(), 1);
+    QCOMPARE(database.sequencesWritten(), nodesWithSequences);
+    QVERIFY(database.volumes().front().startsWith(search::SearchDatabase::cacheDirectory()));
+    QVERIFY(QFile::exists(search::SearchDatabase::fastaFile(database.volumes().front())));
+    QString originalKey = database.key();
+
+    // Same graph finds the database, as any later session would
+    search::SearchDatabase reloaded(fallback.path());
+    QCOMPARE(reloaded.build(*g_assemblyGraph, false, cancel), "");
+    QCOMPARE(reloaded.sequencesWritten(), 0);
+    QCOMPARE(reloaded.key(), originalKey);
+    QCOMPARE(reloaded.volumes(), database.volumes());
+
+    // Including paths is a different database
+    QCOMPARE(reloaded.build(*g_assemblyGraph, true, cancel), "");
+    QVERIFY(reloaded.key() != originalKey);
+
+    // Only the new nodes are written after an edit
+    g_assemblyGraph->duplicateNodePair(g_assemblyGraph->m_deBruijnGraphNodes["26+"], nullptr);
+    QCOMPARE(database.build(*g_assemblyGraph, false, cancel), "");
+    QCOMPARE(database.volumes().size(), 2);
+    QCOMPARE(database.sequencesWritten(), 2);
+    QVERIFY(database.key() != originalKey);
+    {
+        QFile fasta(search::SearchDatabase::fastaFile(database.volumes().back()));
+        QVERIFY(fasta.open(QIODevice::ReadOnly));
+        QByteArray contents = fasta.readAll();
+        QVERIFY(contents.contains(">NODE_26_copy+_length_"));
+        QVERIFY(contents.contains(">NODE_26_copy-_length_"));
+        QVERIFY(!contents.contains(">NODE_26+_length_"));
+    }
+
+    // The volume with the deleted nodes is written again without them, the
+    // volume with the copies is kept
+    QString copiesVolume = database.volumes().back();
+    g_assemblyGraph->deleteNodes({ g_assemblyGraph->m_deBruijnGraphNodes["6+"] });
+    QCOMPARE(database.build(*g_assemblyGraph, false, cancel), "");
+    QCOMPARE(database.volumes().size(), 2);
+    QCOMPARE(database.volumes().front(), copiesVolume);
+    QCOMPARE(database.sequencesWritten(), nodesWithSequences - 2);
+    {
+        QFile fasta(search::SearchDatabase::fastaFile(database.volumes().back()));
+        QVERIFY(fasta.open(QIODevice::ReadOnly));
+        QByteArray contents = fasta.readAll();
+        QVERIFY(contents.contains(">NODE_26+_length_"));
+        QVERIFY(!contents.contains(">NODE_6+_length_"));
+        QVERIFY(!contents.contains(">NODE_6-_length_"));
+    }
+
+    // The edited graph is found in the cache as well
+    search::SearchDatabase edited(fallback.path());
+    QCOMPARE(edited.build(*g_assemblyGraph, false, cancel), "");
+    QCOMPARE(edited.sequencesWritten(), 0);
+    QCOMPARE(edited.volumes(), database.volumes());
+
+    // Disabled cache keeps the database in the fallback directory
+    g_settings->searchCacheSize = 0;
+    search::SearchDatabase uncached(fallback.path());
+    QCOMPARE(uncached.build(*g_assemblyGraph, false, cancel), "");
+    QVERIFY(uncached.volumes().front().startsWith(fallback.path()));
+}
+
+void BandageTests::searchDatabaseAfterEdit() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    QDir volumesDir(QDir(search::SearchDatabase::cacheDirectory()).filePath("volumes"));
+    {
+        search::BlastSearch search(QDir("."));
+        QCOMPARE(search.buildDatabase(*g_assemblyGraph, false), "");
+    }
+    QStringList before = volumesDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(before.size(), 1);
+
+    // The GUI makes a new search after every edit, it still only writes the
+    // new nodes
+    g_assemblyGraph->duplicateNodePair(g_assemblyGraph->m_deBruijnGraphNodes["26+"], nullptr);
+    search::BlastSearch edited(QDir("."));
+    QCOMPARE(edited.buildDatabase(*g_assemblyGraph, false), "");
+    QVERIFY(edited.hasDatabase());
+
+    QStringList after = volumesDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QCOMPARE(after.size(), 2);
+    after.removeAll(before.front());
+    {
+        QFile fasta(search::SearchDatabase::fastaFile(volumesDir.filePath(after.front())));
+        QVERIFY(fasta.open(QIODevice::ReadOnly));
+        QByteArray contents = fasta.readAll();
+        QVERIFY(contents.contains(">NODE_26_copy+_length_"));
+        QVERIFY(!contents.contains(">NODE_26+_length_"));
+    }
+
+    // Both volumes are searched
+    QCOMPARE(edited.loadQueriesFromFile(testFile("test_queries1.fasta")), 4);
+    QCOMPARE(edited.doSearch(""), "");
+    QVERIFY(edited.getNumHits() > 0);
+
+    // Volumes without the BLAST databases, as left by a failed makeblastdb,
+    // are not a built database
+    QVERIFY(QDir(volumesDir.filePath(after.front() + "/blastdb")).removeRecursively());
+    QVERIFY(!edited.hasDatabase());
+    QCOMPARE(edited.doSearch(""), "The BLAST database has not been built.");
+}
+
+void BandageTests::searchDatabaseEvalues() {
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    using Found = std::vector<std::tuple<QString, QString, int, int, int, int, double>>;
+    auto collect = [this](Found &found) {
+        search::BlastSearch blastSearch(QDir("."));
+        QCOMPARE(blastSearch.buildDatabase(*g_assemblyGraph, false), "");
+        QCOMPARE(blastSearch.loadQueriesFromFile(testFile("test_queries1.fasta")), 4);
+        QCOMPARE(blastSearch.doSearch(""), "");
+        for (size_t i = 0; i < blastSearch.getQueryCount(); ++i) {
+            for (const auto &hit : blastSearch.query(i)->getHits())
+                found.emplace_back(hit->m_query->getName(), hit->m_node->getName(),
+                                   hit->m_queryStart, hit->m_queryEnd,
+                                   hit->m_nodeStart, hit->m_nodeEnd,
+                                   hit->m_eValue.toDouble());
+        }
+        std::sort(found.begin(), found.end());
+    };
+
+    // The database of the edited graph is built upon the one of the
+    // original graph
+    Found original;
+    collect(original);
+    QVERIFY(!original.empty());
+    g_assemblyGraph->duplicateNodePair(g_assemblyGraph->m_deBruijnGraphNodes["26+"], nullptr);
+    g_assemblyGraph->deleteNodes({ g_assemblyGraph->m_deBruijnGraphNodes["6+"] });
+    Found edited;
+    collect(edited);
+    QVERIFY(!edited.empty());
+
+    // The removed sequences are not searched and do not change the BLAST
+    // statistics, the hits are the same as from a fresh database
+    QVERIFY(QDir(search::SearchDatabase::cacheDirectory()).removeRecursively());
+    Found fresh;
+    collect(fresh);
+    QVERIFY(edited == fresh);
+}
+
+void BandageTests::shardedBlastSearch()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    using Found = std::vector<std::pair<size_t, size_t>>;
+    auto search = [this](int threads, Found &found) {
+        g_settings->threads = threads;
+        auto errorString = g_blastSearch->doAutoGraphSearch(*g_assemblyGraph,
+                                                            testFile("test_query_paths.fasta"));
+        QCOMPARE(errorString, "");
+
+        for (size_t i = 0; i < g_blastSearch->getQueryCount(); ++i) {
+            const auto *query = g_blastSearch->query(i);
+            found.emplace_back(query->getHits().size(), query->getPaths().size());
+        }
+    };
+
+    // Every query is searched by a single shard, so the hits and paths
+    // found do not depend on the number of shards
+    Found serial, sharded, oversharded;
+    search(1, serial);
+    search(4, sharded);
+    search(16, oversharded);
+    QCOMPARE(serial.size(), size_t(7));
+    QVERIFY(sharded == serial);
+    QVERIFY(oversharded == serial);
+}
+
+void BandageTests::pathFinder()
+{
+    QVERIFY(g_assemblyGraph->loadGraphFromFile(testFile("test.fastg")));
+
+    const int maxNodes = 5;
+    using Walk = std::vector<DeBruijnNode *>;
+
+    // All the walks from the start with their lengths, enumerated exhaustively
+    std::vector<std::pair<Walk, int>> walks;
+    Walk current;
+    std::function<void(int)> enumerate = [&](int length) {
+        walks.emplace_back(current, length);
+        if (current.size() == size_t(maxNodes))
+            return;
+
+        DeBruijnNode *last = current.back();
+        for (auto *edge : last->edges()) {
+            if (edge->getStartingNode() != last)
+                continue;
+
+            current.push_back(edge->getEndingNode());
+            enumerate(length + int(edge->getEndingNode()->getLength()) - edge->getOverlap());
+            current.pop_back();
+        }
+    };
+
+    // Compares the walks found with the ones enumerated from the first
+    // starts, adds the number of the walks found
+    auto check = [&](size_t &pathsFound) {
+        size_t startsChecked = 0;
+        for (auto *start : g_assemblyGraph->m_deBruijnGraphNodes) {
+            if (startsChecked++ == 20)
+                break;
+
+            walks.clear();
+            current = { start };
+            enumerate(int(start->getLength()));
+
+            std::vector<DeBruijnNode *> ends;
+            for (const auto &walk : walks)
+                ends.push_back(walk.first.back());
+            std::sort(ends.begin(), ends.end());
+            ends.erase(std::unique(ends.begin(), ends.end()), ends.end());
+
+            for (auto *end : ends) {
+                for (int maxLength : { 1000, std::numeric_limits<int>::max() }) {
+                    std::vector<Walk> expected;
+                    for (const auto &walk : walks) {
+                        if (walk.first.back() == end && walk.second >= 1 && walk.second <= maxLength)
+                            expected.push_back(walk.first);
+                    }
+
+                    graph::PathFinder finder(GraphLocation::endOfNode(end), maxNodes, maxLength);
+                    std::vector<Path> paths;
+                    size_t budget = std::numeric_limits<size_t>::max();
+                    QVERIFY(finder.findPaths(GraphLocation::startOfNode(start), 1, maxLength,
+                                             budget, paths));
+
+                    std::vector<Walk> found;
+                    for (const auto &path : paths) {
+                        QVERIFY(path.getLength() >= 1 && path.getLength() <= maxLength);
+                        found.push_back(path.nodes());
+                    }
+                    std::sort(expected.begin(), expected.end());
+                    std::sort(found.begin(), found.end());
+                    QVERIFY(found == expected);
+                    pathsFound += found.size();
+
+                    // The search stops once the budget is exhausted
+                    size_t steps = std::numeric_limits<size_t>::max() - budget;
+                    if (steps == 0)
+                        continue;
+
+                    paths.clear();
+                    budget = steps;
+                    QVERIFY(finder.findPaths(GraphLocation::startOfNode(start), 1, maxLength,
+                                             budget, paths));
+                    QCOMPARE(paths.size(), found.size());
+                    budget = steps - 1;
+                    QVERIFY(!finder.findPaths(GraphLocation::startOfNode(start), 1, maxLength,
+                                              budget, paths));
+                }
+            }
+        }
+    };
+
+    size_t pathsFound = 0;
+    check(pathsFound);
+    QVERIFY(pathsFound > 0);
+
+    // An overlap longer than the node it leads to makes the walks through
+    // the edge shorter than the walks stopping before it. Tried on several
+    // edges leading to short nodes, so it is met at various distances from
+    // the ends, including the farthest one.
+    std::vector<DeBruijnEdge *> shortEdges;
+    for (auto *node : g_assemblyGraph->m_deBruijnGraphNodes) {
+        for (auto *edge : node->edges()) {
+            if (edge->getStartingNode() == node && edge->getEndingNode()->getLength() <= 500)
+                shortEdges.push_back(edge);
+        }
+    }
+    QVERIFY(!shortEdges.empty());
+    shortEdges.resize(std::min<size_t>(shortEdges.size(), 10));
+
+    for (auto *edge : shortEdges) {
+        int nodeLength = int(edge->getEndingNode()->getLength());
+        int overlap = edge->getOverlap();
+        edge->setOverlap(nodeLength + 1000);
+        size_t shortenedFound = 0;
+        check(shortenedFound);
+        edge->setOverlap(overlap);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
 
 
 DeBruijnEdge * BandageTests::getEdgeFromNodeNames(QString startingNodeName,
@@ -1826,6 +3047,28 @@ static QByteArray getReverseComplement(const QByteArray& forwardSequence) {
     return reverseComplement;
 }
 
+//This function produces a sorted textual description of all nodes, edges and
+//paths of a graph, so two graphs could be compared.
+QStringList BandageTests::describeGraph(const AssemblyGraph &graph) const
+{
+    QStringList description;
+    for (const auto *node : graph.m_deBruijnGraphNodes)
+        description << "N " + node->getName() + " " + QString::number(node->getLength()) + " " +
+                       QString::number(node->getDepth()) + " " + node->getFasta(true, false);
+
+    for (const auto &entry : graph.m_deBruijnGraphEdges) {
+        const DeBruijnEdge *edge = entry.second;
+        description << "E " + edge->getStartingNode()->getName() + " " + edge->getEndingNode()->getName() + " " +
+                       QString::number(edge->getOverlap()) + " " + QString::number(edge->getOverlapType());
+    }
+
+    for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
+        description << "P " + QString::fromStdString(it.key()) + " " + QString::number(it.value().getLength());
+
+    description.sort();
+    return description;
+}
+
 //This function checks to see if two circular sequences match.  It needs to
 //check each possible rotation, as well as reverse complements.
 bool BandageTests::doCircularSequencesMatch(QByteArray s1, QByteArray s2) const
@@ -0,0 +1,99 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+// Microbenchmark of the Sequence packing kernels. Reports the throughput in
+// GB/s of nucleotide characters for every kernel supported by the CPU.
+//
+// Usage: SequenceBench [megabases] [repeats]
+
+#include "seq/kernels.hpp"
+#include "seq/sequence.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    template<class Fn>
+    double measure(size_t bytes, unsigned repeats, Fn fn) {
+        // Warm up caches and page in the buffers
+        fn();
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < repeats; ++i)
+            fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        return double(bytes) * repeats / elapsed.count() / 1e9;
+    }
+
+    void report(const char *kernel, const char *operation, double gbps) {
+        std::printf("%-8s %-20s %8.2f GB/s\n", kernel, operation, gbps);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t megabases = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    unsigned repeats = argc > 2 ? unsigned(std::strtoul(argv[2], nullptr, 10)) : 10;
+    size_t n = megabases << 20;
+
+    std::mt19937_64 rng(42);
+    std::string nucls(n, 'A');
+    for (auto &c : nucls)
+        c = "ACGT"[rng() & 3];
+
+    // Odd offset so unpacking has to realign the words
+    size_t from = 7, count = n - 2 * from;
+    std::vector<uint64_t> packed((n + 31) / 32);
+    std::vector<uint32_t> ns;
+    std::string out(n, '\0');
+
+    std::printf("%zu megabases, %u repeats\n", megabases, repeats);
+    for (auto isa : { seq::kernels::Isa::Scalar, seq::kernels::Isa::SSE42, seq::kernels::Isa::AVX2 }) {
+        if (!seq::kernels::supported(isa))
+            continue;
+
+        const auto &kernels = seq::kernels::get(isa);
+        for (bool rc : { false, true }) {
+            report(kernels.name, rc ? "pack (rc)" : "pack",
+                   measure(n, repeats, [&] {
+                       ns.clear();
+                       kernels.pack(nucls.data(), n, packed.data(), rc, ns);
+                   }));
+            report(kernels.name, rc ? "unpack (rc)" : "unpack",
+                   measure(count, repeats, [&] {
+                       kernels.unpack(packed.data(), from, count, out.data(), rc);
+                   }));
+        }
+    }
+
+    // End-to-end, including allocation and the N mask
+    for (size_t i = 0; i < n; i += 4096)
+        nucls[i] = 'N';
+    Sequence sequence;
+    report(seq::kernels::best().name, "Sequence(string)",
+           measure(n, repeats, [&] { sequence = Sequence(nucls); }));
+    report(seq::kernels::best().name, "Sequence::str()",
+           measure(n, repeats, [&] { out = sequence.str(); }));
+    report(seq::kernels::best().name, "Sequence::str() (rc)",
+           measure(n, repeats, [&] { out = sequence.GetReverseComplement().str(); }));
+
+    return out.size() == n ? EXIT_SUCCESS : EXIT_FAILURE;
+}
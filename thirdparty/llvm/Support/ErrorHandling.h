@@ -15,6 +15,8 @@
 #define LLVM_SUPPORT_ERRORHANDLING_H
 
 #include "llvm/Support/Compiler.h"
+#include <cstdio>
+#include <cstdlib>
 #include <string>
 
 namespace llvm {
@@ -118,9 +120,19 @@ void report_bad_alloc_error(const char *Reason, bool GenCrashDiag = true);
 /// This function calls abort(), and prints the optional message to stderr.
 /// Use the llvm_unreachable macro (that adds location info), instead of
 /// calling this function directly.
-LLVM_ATTRIBUTE_NORETURN void
+/// Defined inline here as only the header-only part of LLVM Support is
+/// bundled.
+LLVM_ATTRIBUTE_NORETURN inline void
 llvm_unreachable_internal(const char *msg = nullptr, const char *file = nullptr,
-                          unsigned line = 0);
+                          unsigned line = 0) {
+  if (msg)
+    std::fprintf(stderr, "%s\n", msg);
+  std::fprintf(stderr, "UNREACHABLE executed");
+  if (file)
+    std::fprintf(stderr, " at %s:%u", file, line);
+  std::fprintf(stderr, "!\n");
+  std::abort();
+}
 }
 
 /// Marks that the current location is not supposed to be reachable.
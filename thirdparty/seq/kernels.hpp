@@ -0,0 +1,351 @@
+// Copyright 2022 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "nucl.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SEQ_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// Kernels converting between nucleotide characters and the packed 2-bit
+// representation used by Sequence: 32 nucleotides per 64-bit word, the first
+// one in the least significant bits, A = 0, C = 1, G = 2, T = 3.
+//
+// Every kernel has a scalar version and SSE4.2 / AVX2 ones, the best one
+// supported by the CPU is selected at runtime.
+namespace seq::kernels {
+    enum class Isa { Scalar, SSE42, AVX2 };
+
+    struct Kernels {
+        Isa isa;
+        const char *name;
+
+        // Packs n characters of s (or of the reverse complement of s, if rc
+        // is set) into DataSize(n) words of out. Characters besides ACGTacgt
+        // are packed the same way dignucl() does, the positions (in packed
+        // order) of N and n are appended to ns.
+        void (*pack)(const char *s, size_t n, uint64_t *out, bool rc, std::vector<uint32_t> &ns);
+
+        // Unpacks n nucleotides starting at the given position of the packed
+        // buffer as ACGT characters. If rc is set, the reverse complement of
+        // the range is written.
+        void (*unpack)(const uint64_t *in, size_t from, size_t n, char *out, bool rc);
+    };
+
+    namespace detail {
+        constexpr size_t WORD_NUCLS = 32;
+
+        // Same as dignucl() for every possible character
+        struct CodeTable {
+            uint8_t codes[256] = {};
+
+            constexpr CodeTable() {
+                for (int i = 0; i < 256; ++i) {
+                    auto c = static_cast<char>(i);
+                    if (c >= 0 && c < 4) {
+                        codes[i] = static_cast<uint8_t>(c);
+                        continue;
+                    }
+                    if ('a' <= c && c <= 't')
+                        c = static_cast<char>(c - 'a' + 'A');
+                    codes[i] = c <= 'C' ? (c == 'A' ? 0 : 1) : (c == 'G' ? 2 : 3);
+                }
+            }
+
+            uint8_t operator[](char c) const { return codes[static_cast<uint8_t>(c)]; }
+        };
+
+        inline constexpr CodeTable CODES{};
+        inline constexpr char NUCLS[] = "ACGT";
+        inline constexpr char COMPLEMENTS[] = "TGCA";
+
+        // Packs the output words [begin, end) one character at a time, begin
+        // is a multiple of WORD_NUCLS
+        inline void packRange(const char *s, size_t n, size_t begin, size_t end,
+                              uint64_t *out, bool rc, std::vector<uint32_t> &ns) {
+            for (size_t w = begin; w < end; w += WORD_NUCLS) {
+                uint64_t word = 0;
+                for (size_t i = w, e = std::min(end, w + WORD_NUCLS); i < e; ++i) {
+                    char c = rc ? s[n - 1 - i] : s[i];
+                    uint64_t code = CODES[c] ^ (rc ? 3 : 0);
+                    if (LLVM_UNLIKELY(is_N(c)))
+                        ns.push_back(static_cast<uint32_t>(i));
+                    word |= code << ((i - w) * 2);
+                }
+                out[w / WORD_NUCLS] = word;
+            }
+        }
+
+        // Unpacks the output characters [begin, n) one at a time
+        inline void unpackRange(const uint64_t *in, size_t from, size_t n, size_t begin,
+                                char *out, bool rc) {
+            for (size_t i = begin; i < n; ++i) {
+                size_t pos = rc ? from + n - 1 - i : from + i;
+                auto code = static_cast<unsigned>(in[pos / WORD_NUCLS] >> (pos % WORD_NUCLS * 2)) & 3;
+                out[i] = rc ? COMPLEMENTS[code] : NUCLS[code];
+            }
+        }
+
+        inline void packScalar(const char *s, size_t n, uint64_t *out, bool rc, std::vector<uint32_t> &ns) {
+            packRange(s, n, 0, n, out, rc, ns);
+        }
+
+        inline void unpackScalar(const uint64_t *in, size_t from, size_t n, char *out, bool rc) {
+            unpackRange(in, from, n, 0, out, rc);
+        }
+
+#ifdef SEQ_KERNELS_X86
+        // Moves bit i of x to bit 2i
+        inline uint64_t spreadBits(uint32_t x) {
+            uint64_t v = x;
+            v = (v | v << 16) & 0x0000FFFF0000FFFFull;
+            v = (v | v << 8) & 0x00FF00FF00FF00FFull;
+            v = (v | v << 4) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | v << 2) & 0x3333333333333333ull;
+            v = (v | v << 1) & 0x5555555555555555ull;
+            return v;
+        }
+
+        // Moves bit 2i of v to bit i, the inverse of spreadBits()
+        inline uint32_t compactBits(uint64_t v) {
+            v &= 0x5555555555555555ull;
+            v = (v | v >> 1) & 0x3333333333333333ull;
+            v = (v | v >> 2) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | v >> 4) & 0x00FF00FF00FF00FFull;
+            v = (v | v >> 8) & 0x0000FFFF0000FFFFull;
+            v = (v | v >> 16) & 0x00000000FFFFFFFFull;
+            return static_cast<uint32_t>(v);
+        }
+
+        inline uint32_t reverseBits(uint32_t x) {
+            x = (x >> 1 & 0x55555555u) | (x & 0x55555555u) << 1;
+            x = (x >> 2 & 0x33333333u) | (x & 0x33333333u) << 2;
+            x = (x >> 4 & 0x0F0F0F0Fu) | (x & 0x0F0F0F0Fu) << 4;
+            return __builtin_bswap32(x);
+        }
+
+        // Reverses the order of the 32 nucleotides in the word
+        inline uint64_t reverseCodes(uint64_t w) {
+            w = (w >> 2 & 0x3333333333333333ull) | (w & 0x3333333333333333ull) << 2;
+            w = (w >> 4 & 0x0F0F0F0F0F0F0F0Full) | (w & 0x0F0F0F0F0F0F0F0Full) << 4;
+            return __builtin_bswap64(w);
+        }
+
+        // 32 nucleotides starting at an arbitrary position, pos + 31 must be
+        // within the buffer
+        inline uint64_t loadCodes(const uint64_t *in, size_t pos) {
+            size_t k = pos / WORD_NUCLS, shift = pos % WORD_NUCLS * 2;
+            return shift ? in[k] >> shift | in[k + 1] << (64 - shift) : in[k];
+        }
+
+        // Builds the packed word from the bit planes of the codes of 32
+        // characters in memory order
+        inline uint64_t finishWord(uint32_t lo, uint32_t hi, uint32_t nMask,
+                                   size_t w, bool rc, std::vector<uint32_t> &ns) {
+            if (rc) {
+                lo = ~reverseBits(lo);
+                hi = ~reverseBits(hi);
+                nMask = reverseBits(nMask);
+            }
+
+            for (; nMask; nMask &= nMask - 1)
+                ns.push_back(static_cast<uint32_t>(w + static_cast<size_t>(__builtin_ctz(nMask))));
+
+            return spreadBits(lo) | spreadBits(hi) << 1;
+        }
+
+        // Classifies 16 characters: ACGTacgt get their codes via
+        // ((c >> 1) ^ (c >> 2)) & 3, N and n are packed as 3. Returns false
+        // if there is anything else.
+        __attribute__((target("sse4.2")))
+        inline bool classifySSE(__m128i v, uint32_t &lo, uint32_t &hi, uint32_t &nMask) {
+            const __m128i three = _mm_set1_epi8(3);
+            __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i isN = _mm_cmpeq_epi8(lower, _mm_set1_epi8('n'));
+            __m128i ok = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('a')),
+                                                   _mm_cmpeq_epi8(lower, _mm_set1_epi8('c'))),
+                                      _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('g')),
+                                                   _mm_cmpeq_epi8(lower, _mm_set1_epi8('t'))));
+            if (_mm_movemask_epi8(_mm_or_si128(ok, isN)) != 0xFFFF)
+                return false;
+
+            __m128i code = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(v, 1), _mm_srli_epi16(v, 2)), three);
+            code = _mm_or_si128(code, _mm_and_si128(isN, three));
+            lo = static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code, 7)));
+            hi = static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code, 6)));
+            nMask = static_cast<uint32_t>(_mm_movemask_epi8(isN));
+            return true;
+        }
+
+        __attribute__((target("sse4.2")))
+        inline void packSSE42(const char *s, size_t n, uint64_t *out, bool rc, std::vector<uint32_t> &ns) {
+            size_t full = n / WORD_NUCLS * WORD_NUCLS;
+            for (size_t w = 0; w < full; w += WORD_NUCLS) {
+                const char *src = rc ? s + n - w - WORD_NUCLS : s + w;
+                uint32_t lo0, hi0, n0, lo1, hi1, n1;
+                if (LLVM_UNLIKELY(!classifySSE(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)),
+                                               lo0, hi0, n0) ||
+                                  !classifySSE(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16)),
+                                               lo1, hi1, n1))) {
+                    packRange(s, n, w, w + WORD_NUCLS, out, rc, ns);
+                    continue;
+                }
+
+                out[w / WORD_NUCLS] = finishWord(lo0 | lo1 << 16, hi0 | hi1 << 16, n0 | n1 << 16, w, rc, ns);
+            }
+            packRange(s, n, full, n, out, rc, ns);
+        }
+
+        // Turns 16 bits of the mask into 0x00 / 0xFF bytes
+        __attribute__((target("sse4.2")))
+        inline __m128i expandMaskSSE(uint32_t mask) {
+            const __m128i select = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+            const __m128i bits = _mm_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+            __m128i v = _mm_shuffle_epi8(_mm_set1_epi32(static_cast<int>(mask)), select);
+            return _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+        }
+
+        __attribute__((target("sse4.2")))
+        inline void unpackSSE42(const uint64_t *in, size_t from, size_t n, char *out, bool rc) {
+            const __m128i table = rc ? _mm_setr_epi8('T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+                                     : _mm_setr_epi8('A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i one = _mm_set1_epi8(1), two = _mm_set1_epi8(2);
+
+            size_t full = n / WORD_NUCLS * WORD_NUCLS;
+            for (size_t i = 0; i < full; i += WORD_NUCLS) {
+                uint64_t w = rc ? reverseCodes(loadCodes(in, from + n - i - WORD_NUCLS)) : loadCodes(in, from + i);
+                uint32_t lo = compactBits(w), hi = compactBits(w >> 1);
+                for (unsigned half = 0; half < 2; ++half) {
+                    __m128i code = _mm_or_si128(_mm_and_si128(expandMaskSSE(lo >> (16 * half)), one),
+                                                _mm_and_si128(expandMaskSSE(hi >> (16 * half)), two));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 16 * half),
+                                     _mm_shuffle_epi8(table, code));
+                }
+            }
+            unpackRange(in, from, n, full, out, rc);
+        }
+
+        __attribute__((target("avx2")))
+        inline void packAVX2(const char *s, size_t n, uint64_t *out, bool rc, std::vector<uint32_t> &ns) {
+            const __m256i three = _mm256_set1_epi8(3), caseBit = _mm256_set1_epi8(0x20);
+            const __m256i a = _mm256_set1_epi8('a'), c = _mm256_set1_epi8('c'),
+                          g = _mm256_set1_epi8('g'), t = _mm256_set1_epi8('t'), nn = _mm256_set1_epi8('n');
+
+            size_t full = n / WORD_NUCLS * WORD_NUCLS;
+            for (size_t w = 0; w < full; w += WORD_NUCLS) {
+                const char *src = rc ? s + n - w - WORD_NUCLS : s + w;
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+                __m256i lower = _mm256_or_si256(v, caseBit);
+                __m256i isN = _mm256_cmpeq_epi8(lower, nn);
+                __m256i ok = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, a), _mm256_cmpeq_epi8(lower, c)),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(lower, g), _mm256_cmpeq_epi8(lower, t)));
+                if (LLVM_UNLIKELY(_mm256_movemask_epi8(_mm256_or_si256(ok, isN)) != -1)) {
+                    packRange(s, n, w, w + WORD_NUCLS, out, rc, ns);
+                    continue;
+                }
+
+                // See classifySSE()
+                __m256i code = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(v, 1), _mm256_srli_epi16(v, 2)),
+                                                three);
+                code = _mm256_or_si256(code, _mm256_and_si256(isN, three));
+                auto lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(code, 7)));
+                auto hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(code, 6)));
+                auto nMask = static_cast<uint32_t>(_mm256_movemask_epi8(isN));
+                out[w / WORD_NUCLS] = finishWord(lo, hi, nMask, w, rc, ns);
+            }
+            packRange(s, n, full, n, out, rc, ns);
+        }
+
+        // Turns 32 bits of the mask into 0x00 / 0xFF bytes
+        __attribute__((target("avx2")))
+        inline __m256i expandMaskAVX2(uint32_t mask) {
+            const __m256i select = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                    2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+            const __m256i bits = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+            __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(mask)), select);
+            return _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+        }
+
+        __attribute__((target("avx2")))
+        inline void unpackAVX2(const uint64_t *in, size_t from, size_t n, char *out, bool rc) {
+            const __m256i table = rc ? _mm256_setr_epi8('T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                        'T', 'G', 'C', 'A', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+                                     : _mm256_setr_epi8('A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                        'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i one = _mm256_set1_epi8(1), two = _mm256_set1_epi8(2);
+
+            size_t full = n / WORD_NUCLS * WORD_NUCLS;
+            for (size_t i = 0; i < full; i += WORD_NUCLS) {
+                uint64_t w = rc ? reverseCodes(loadCodes(in, from + n - i - WORD_NUCLS)) : loadCodes(in, from + i);
+                __m256i code = _mm256_or_si256(_mm256_and_si256(expandMaskAVX2(compactBits(w)), one),
+                                               _mm256_and_si256(expandMaskAVX2(compactBits(w >> 1)), two));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_shuffle_epi8(table, code));
+            }
+            unpackRange(in, from, n, full, out, rc);
+        }
+#endif
+    }
+
+    inline bool supported(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return true;
+#ifdef SEQ_KERNELS_X86
+            case Isa::SSE42:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("sse4.2");
+            case Isa::AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    // The isa must be supported
+    inline const Kernels &get(Isa isa) {
+        static constexpr Kernels scalar{Isa::Scalar, "scalar", detail::packScalar, detail::unpackScalar};
+#ifdef SEQ_KERNELS_X86
+        static constexpr Kernels sse42{Isa::SSE42, "sse4.2", detail::packSSE42, detail::unpackSSE42};
+        static constexpr Kernels avx2{Isa::AVX2, "avx2", detail::packAVX2, detail::unpackAVX2};
+        switch (isa) {
+            case Isa::SSE42:
+                return sse42;
+            case Isa::AVX2:
+                return avx2;
+            default:
+                break;
+        }
+#endif
+        return scalar;
+    }
+
+    inline const Kernels &best() {
+        static const Kernels &kernels = get(supported(Isa::AVX2) ? Isa::AVX2 :
+                                            supported(Isa::SSE42) ? Isa::SSE42 : Isa::Scalar);
+        return kernels;
+    }
+}
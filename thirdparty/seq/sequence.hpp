@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "kernels.hpp"
 #include "log.hpp"
 #include "nucl.hpp"
 #include "utils/sfinae_checks.hpp"
@@ -92,8 +93,37 @@ class Sequence {
         }
     }
 
+    // Contiguous character data if S provides one, otherwise null
+    template<typename S>
+    static const char *ContiguousNucls(const S &s) {
+        if constexpr (std::is_pointer_v<S>)
+            return s;
+        else if constexpr (has_char_data_method<S>::value)
+            return s.data();
+        else
+            return nullptr;
+    }
+
+    // Packs the nucleotides and collects the Ns in a single pass using the
+    // vectorized kernels
+    void InitFromContiguousNucls(const char *s, bool rc) {
+        std::vector<uint32_t> ns;
+        seq::kernels::best().pack(s, size_, data_->data(), rc, ns);
+        if (LLVM_UNLIKELY(!ns.empty())) {
+            data_->empty_nucls_ = std::make_unique<llvm::SparseBitVector<>>();
+            for (uint32_t idx : ns)
+                data_->empty_nucls_->set(idx);
+        }
+    }
+
     template<typename S>
     void InitFromNucls(const S &s, bool rc = false) {
+        // Digit strings (0123) are rare, they go through the generic path
+        if (const char *nucls = ContiguousNucls(s); nucls && size_ && !is_dignucl(nucls[0])) {
+            InitFromContiguousNucls(nucls, rc);
+            return;
+        }
+
         InitEmptyNucls(s, rc);
 
         size_t bytes_size = DataSize(size_);
@@ -160,6 +190,9 @@ class Sequence {
     }
 
     bool emptyNuclsEqual(const Sequence &that) const {
+        if (!data_ || !that.data_)
+            return data_ == that.data_;
+
         return data_->empty_nucls_ == that.data_->empty_nucls_
             || (data_->empty_nucls_ != nullptr
                 && that.data_->empty_nucls_ != nullptr
@@ -171,14 +204,12 @@ class Sequence {
             : size_(size), from_(from), rtl_(rtl), data_(seq.data_) {}
 
 public:
+    /**
+     * Sequence of given size. An all-N sequence is "absent": it only records
+     * its length and has no buffer at all, every position reads as N.
+     */
     explicit Sequence(size_t size, bool allNs = false)
-            : size_(size), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(size_)) {
-        if (allNs) {
-            data_->empty_nucls_ = std::make_unique<llvm::SparseBitVector<>>();
-            for (size_t i = from_; i < size_; ++i)
-                data_->empty_nucls_->set(i);
-        }
-    }
+            : size_(size), from_(0), rtl_(false), data_(allNs ? nullptr : ManagedNuclBuffer::create(size_)) {}
 
     /**
      * Sequence initialization (arbitrary size string)
@@ -229,6 +260,9 @@ public:
 
     char operator[](const size_t index) const {
         VERIFY_DEV(index < size_);
+        if (LLVM_UNLIKELY(!data_)) {
+            return 'N';
+        }
         if (rtl_) {
             size_t i = from_ + size_ - 1 - index;
             if (LLVM_UNLIKELY(isEmptySymbol(i))) {
@@ -306,6 +340,9 @@ public:
 
     inline std::string str() const;
 
+    // Writes size() ACGTN characters to out
+    inline void CopyNucls(char *out) const;
+
     inline std::string err() const;
 
     size_t size() const {
@@ -313,14 +350,28 @@ public:
     }
 
     size_t capacity() const {
-        return DataSize(size_) * sizeof(ST);
+        return data_ ? DataSize(size_) * sizeof(ST) : 0;
     }
 
     bool empty() const {
         return size() == 0;
     }
 
+    // Only the length is known, there is no storage for the bases
+    bool absent() const {
+        return !data_;
+    }
+
+    // Identifies the underlying buffer. Reverse complements and subsequences
+    // are views of the same buffer.
+    const void *buffer() const {
+        return data_.get();
+    }
+
     bool missing() const {
+        if (absent())
+            return true;
+
         // No N's - nothing is missed
         if (!data_->empty_nucls_)
             return false;
@@ -411,19 +462,38 @@ Sequence Sequence::operator+(const Sequence &s) const {
 
 std::string Sequence::str() const {
     std::string res(size_, '-');
-    for (size_t i = 0; i < size_; ++i) {
-        res[i] = nucl(this->operator[](i));
-    }
+    CopyNucls(res.data());
     return res;
 }
 
+void Sequence::CopyNucls(char *out) const {
+    if (!data_) {
+        memset(out, 'N', size_);
+        return;
+    }
+
+    seq::kernels::best().unpack(data_->data(), from_, size_, out, rtl_);
+    if (LLVM_LIKELY(data_->empty_nucls_ == nullptr))
+        return;
+
+    // Ns are ordered by their position in the buffer
+    for (unsigned idx : *data_->empty_nucls_) {
+        if (idx < from_)
+            continue;
+        if (idx >= from_ + size_)
+            break;
+        size_t i = idx - from_;
+        out[rtl_ ? size_ - 1 - i : i] = 'N';
+    }
+}
+
 std::string Sequence::err() const {
     std::ostringstream oss;
-    oss << "{ *data=" << data_->data() <<
+    oss << "{ *data=" << (data_ ? data_->data() : nullptr) <<
             ", from_=" << from_ <<
             ", size_=" << size_ <<
             ", rtl_=" << int(rtl_) <<
-            ", empty_nucls_=" << data_->empty_nucls_.get() << " }";
+            ", empty_nucls_=" << (data_ ? data_->empty_nucls_.get() : nullptr) << " }";
     return oss.str();
 }
 
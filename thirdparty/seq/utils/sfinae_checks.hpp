@@ -20,4 +20,21 @@ struct has_size_method
     static constexpr bool value = std::is_same<decltype(test<T>(0)),yes>::value;
 };
 
+// True if the type has data() returning a pointer to contiguous chars
+template<typename T>
+struct has_char_data_method
+{
+  private:
+    typedef std::true_type yes;
+    typedef std::false_type no;
+
+    template<typename U> static auto test(int) -> decltype(static_cast<const char *>(std::declval<const U &>().data()), yes());
+
+    template<typename> static no test(...);
+
+  public:
+
+    static constexpr bool value = std::is_same<decltype(test<T>(0)),yes>::value;
+};
+
 #endif //BANDAGE_THIRDPARTY_SEQ_UTILS_SFINAE_CHECKS_HPP_
@@ -33,23 +33,15 @@ BandageGraphicsScene::BandageGraphicsScene(QObject *parent) :
 
 
 static bool compareNodePointers(const DeBruijnNode * a, const DeBruijnNode * b) {
-    QString aName = a->getName();
-    QString bName = b->getName();
-
-    QString aName2 = aName;
-    aName2.chop(1);
-    QString bName2 = bName;
-    bName2.chop(1);
-
-    bool ok1, ok2;
-    long long aNum = aName2.toLongLong(&ok1);
-    long long bNum = bName2.toLongLong(&ok2);
+    long long aNum, bNum;
+    bool ok1 = a->getNameNumber(aNum);
+    bool ok2 = b->getNameNumber(bNum);
 
     //If the node names are essentially numbers, then sort them as numbers
     if (ok1 && ok2 && aNum != bNum)
         return aNum < bNum;
 
-    return aName < bName;
+    return a->getNameView() < b->getNameView();
 }
 
 // This function returns all of the selected nodes, sorted by their node number.
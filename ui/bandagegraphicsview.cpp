@@ -22,13 +22,15 @@
 #include "program/settings.h"
 #include "graphicsviewzoom.h"
 #include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
 #include <QFont>
 #include <QMessageBox>
 #include <qmath.h>
 #include <cmath>
 
 BandageGraphicsView::BandageGraphicsView(QObject * /*parent*/) :
-    QGraphicsView(), m_rotation(0.0)
+    QGraphicsView(), m_rotation(0.0), m_showFrameRate(false), m_lastFrameDuration(0)
 {
     setDragMode(QGraphicsView::RubberBandDrag);
     setAntialiasing(g_settings->antialiasing);
@@ -168,6 +170,44 @@ void BandageGraphicsView::keyPressEvent(QKeyEvent * event)
     QGraphicsView::keyPressEvent(event);
 }
 
+void BandageGraphicsView::setShowFrameRate(bool showFrameRate)
+{
+    m_showFrameRate = showFrameRate;
+    m_frameTimes.clear();
+    if (showFrameRate)
+        m_frameClock.start();
+    viewport()->update();
+}
+
+void BandageGraphicsView::paintEvent(QPaintEvent * event)
+{
+    if (!m_showFrameRate)
+    {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    qint64 frameStart = m_frameClock.nsecsElapsed();
+    QGraphicsView::paintEvent(event);
+    qint64 frameEnd = m_frameClock.nsecsElapsed();
+    m_lastFrameDuration = frameEnd - frameStart;
+
+    //Frames finished within the last second
+    m_frameTimes.push_back(frameEnd);
+    while (frameEnd - m_frameTimes.front() > 1000000000)
+        m_frameTimes.pop_front();
+
+    QString text = QString("%1 fps, %2 ms/frame")
+            .arg(m_frameTimes.size())
+            .arg(double(m_lastFrameDuration) / 1e6, 0, 'f', 1);
+    QPainter painter(viewport());
+    QRect textRect = painter.fontMetrics().boundingRect(text).adjusted(-4, -2, 4, 2);
+    textRect.moveTopLeft(QPoint(4, 4));
+    painter.fillRect(textRect, QColor(255, 255, 255, 200));
+    painter.setPen(Qt::black);
+    painter.drawText(textRect, Qt::AlignCenter, text);
+}
+
 void BandageGraphicsView::setAntialiasing(bool antialiasingOn)
 {
     if (antialiasingOn)
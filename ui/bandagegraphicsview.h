@@ -22,6 +22,9 @@
 #include <QGraphicsView>
 #include <QPoint>
 #include <QLineF>
+#include <QElapsedTimer>
+
+#include <deque>
 
 class GraphicsViewZoom;
 class DeBruijnNode;
@@ -46,6 +49,7 @@ public:
     QPoint m_previousPos;
 
     void setAntialiasing(bool antialiasingOn);
+    void setShowFrameRate(bool showFrameRate);
     bool isPointVisible(QPointF p);
     QPointF findIntersectionWithViewportBoundary(QLineF line);
     QLineF findVisiblePartOfLine(QLineF line, bool * success);
@@ -56,10 +60,18 @@ protected:
     void mouseMoveEvent(QMouseEvent * event);
     void keyPressEvent(QKeyEvent * event);
     void mouseDoubleClickEvent(QMouseEvent * event);
+    void paintEvent(QPaintEvent * event);
 
 private:
     double m_rotation;
 
+    //Frame rate counter: the times the recent frames were finished at and
+    //how long the last one took to paint.
+    bool m_showFrameRate;
+    QElapsedTimer m_frameClock;
+    std::deque<qint64> m_frameTimes;
+    qint64 m_lastFrameDuration;
+
     static double distance(double x1, double y1, double x2, double y2);
     static double angleBetweenTwoLines(QPointF line1Start, QPointF line1End, QPointF line2Start, QPointF line2End);
     void getFourViewportCornersInSceneCoordinates(QPointF * c1, QPointF * c2, QPointF * c3, QPointF * c4);
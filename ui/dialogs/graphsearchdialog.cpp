@@ -125,8 +125,7 @@ GraphSearchDialog::GraphSearchDialog(QWidget *parent, const QString& autoQuery)
     }
 
     // If a BLAST database already exists, move to step 2.
-    QFile databaseFile = m_graphSearch->temporaryDir().filePath("all_nodes.fasta");
-    if (databaseFile.exists())
+    if (m_graphSearch->hasDatabase())
         setUiStep(GRAPH_DB_BUILT_BUT_NO_QUERIES);
     //If there isn't a BLAST database, clear the entire temporary directory
     //and move to step 1.
@@ -365,6 +364,12 @@ void GraphSearchDialog::runGraphSearches(bool separateThread) {
     connect(m_graphSearch.get(), SIGNAL(finishedSearch(QString)), progress, SLOT(deleteLater()));
     connect(m_graphSearch.get(), SIGNAL(finishedSearch(QString)), this, SLOT(graphSearchFinished(QString)));
     connect(progress, SIGNAL(halt()), m_graphSearch.get(), SLOT(cancelSearch()));
+    // Hits are reported query by query while the search runs
+    connect(m_graphSearch.get(), &search::GraphSearch::searchProgress, progress,
+            [progress, queryCount = int(m_graphSearch->getQueryCount())](int queriesSeen, int) {
+                progress->setMaxValue(queryCount);
+                progress->setValue(queriesSeen);
+            });
 
     auto searcher = [&]() { m_graphSearch->doSearch(ui->parametersLineEdit->text().simplified()); };
     if (separateThread) {
@@ -493,7 +498,7 @@ void GraphSearchDialog::setUiStep(SearchUiState uiState) {
         ui->blastQueriesTableInfoText->setEnabled(true);
         ui->step3Label->setEnabled(true);
         ui->parametersLabel->setEnabled(true);
-        ui->parametersLineEdit->setEnabled(true);
+        ui->parametersLineEdit->setEnabled(m_graphSearch->allowParameters());
         ui->runBlastSearchButton->setEnabled(true);
         ui->clearAllQueriesButton->setEnabled(true);
         ui->hitsLabel->setEnabled(false);
@@ -522,7 +527,7 @@ void GraphSearchDialog::setUiStep(SearchUiState uiState) {
         ui->blastQueriesTableInfoText->setEnabled(true);
         ui->step3Label->setEnabled(true);
         ui->parametersLabel->setEnabled(true);
-        ui->parametersLineEdit->setEnabled(true);
+        ui->parametersLineEdit->setEnabled(m_graphSearch->allowParameters());
         ui->runBlastSearchButton->setEnabled(false);
         ui->clearAllQueriesButton->setEnabled(true);
         ui->hitsLabel->setEnabled(false);
@@ -551,7 +556,7 @@ void GraphSearchDialog::setUiStep(SearchUiState uiState) {
         ui->blastQueriesTableInfoText->setEnabled(true);
         ui->step3Label->setEnabled(true);
         ui->parametersLabel->setEnabled(true);
-        ui->parametersLineEdit->setEnabled(true);
+        ui->parametersLineEdit->setEnabled(m_graphSearch->allowParameters());
         ui->runBlastSearchButton->setEnabled(true);
         ui->clearAllQueriesButton->setEnabled(true);
         ui->hitsLabel->setEnabled(true);
@@ -595,6 +600,8 @@ void GraphSearchDialog::setUiCaptions() {
     ui->buildBlastDatabaseButton->setText(QString("Build %1 database").arg(m_graphSearch->name()));
     ui->blastFiltersButton->setText(QString("Set %1 hit filters").arg(m_graphSearch->name()));
     ui->runBlastSearchButton->setText(QString("Run %1 search").arg(m_graphSearch->name()));
+    ui->parametersLineEdit->setPlaceholderText(m_graphSearch->allowParameters() ? QString() :
+                                               QString("The %1 search takes no parameters").arg(m_graphSearch->name()));
 }
 
 void GraphSearchDialog::searcherChanged() {
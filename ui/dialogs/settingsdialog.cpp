@@ -221,6 +221,11 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     intFunctionPointer(&settings->minLengthBaseDiscrepancy, ui->minLengthBaseDiscrepancySpinBox);
     checkBoxFunctionPointer(&settings->maxLengthBaseDiscrepancy.on, ui->maxLengthBaseDiscrepancyCheckBox);
     intFunctionPointer(&settings->maxLengthBaseDiscrepancy, ui->maxLengthBaseDiscrepancySpinBox);
+    intFunctionPointer(&settings->threads, ui->threadsSpinBox);
+    intFunctionPointer(&settings->layoutThreads, ui->layoutThreadsSpinBox);
+    intFunctionPointer(&settings->layoutCacheSize, ui->layoutCacheSizeSpinBox);
+    intFunctionPointer(&settings->searchCacheSize, ui->searchCacheSizeSpinBox);
+    intFunctionPointer(&settings->queryPathSearchLimit, ui->queryPathSearchLimitSpinBox);
 
     //A couple of settings are not in a spin box, check box or colour button, so
     //they have to be done manually, not with those function pointers.
@@ -229,9 +234,14 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
         ui->graphLayoutQualitySlider->setValue(settings->graphLayoutQuality);
         ui->linearLayoutOffRadioButton->setChecked(!settings->linearLayout);
         ui->linearLayoutOnRadioButton->setChecked(settings->linearLayout);
+        ui->graphLayoutAlgorithmCombo->setCurrentIndex(int(settings->graphLayoutAlgorithm));
+        ui->incrementalLayoutOffRadioButton->setChecked(!settings->incrementalLayout);
+        ui->incrementalLayoutOnRadioButton->setChecked(settings->incrementalLayout);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
         ui->antialiasingOnRadioButton->setChecked(settings->antialiasing);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
+        ui->levelOfDetailOnRadioButton->setChecked(settings->levelOfDetail);
+        ui->levelOfDetailOffRadioButton->setChecked(!settings->levelOfDetail);
         ui->singleNodeArrowHeadsOnRadioButton->setChecked(settings->arrowheadsInSingleMode);
         ui->singleNodeArrowHeadsOffRadioButton->setChecked(!settings->arrowheadsInSingleMode);
         ui->depthValueAutoRadioButton->setChecked(settings->autoDepthValue);
@@ -250,7 +260,10 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     {
         settings->graphLayoutQuality = ui->graphLayoutQualitySlider->value();
         settings->linearLayout = ui->linearLayoutOnRadioButton->isChecked();
+        settings->graphLayoutAlgorithm = GraphLayoutAlgorithm(ui->graphLayoutAlgorithmCombo->currentIndex());
+        settings->incrementalLayout = ui->incrementalLayoutOnRadioButton->isChecked();
         settings->antialiasing = ui->antialiasingOnRadioButton->isChecked();
+        settings->levelOfDetail = ui->levelOfDetailOnRadioButton->isChecked();
         settings->arrowheadsInSingleMode = ui->singleNodeArrowHeadsOnRadioButton->isChecked();
         settings->autoDepthValue = ui->depthValueAutoRadioButton->isChecked();
         if (ui->nodeLengthPerMegabaseAutoRadioButton->isChecked())
@@ -0,0 +1,504 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphrenderer.h"
+
+#include "graph/annotationsmanager.h"
+#include "graph/assemblygraph.h"
+#include "graph/debruijnedge.h"
+#include "graph/debruijnnode.h"
+#include "graph/graphicsitemedge.h"
+
+#include "program/globals.h"
+#include "program/settings.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // The grid has about as many cells as there are items, but not more
+    // than that
+    constexpr double MAX_GRID_CELLS = 1 << 20;
+
+    // Deflated image data is written in IDAT chunks of that size
+    constexpr size_t PNG_CHUNK_SIZE = 1 << 16;
+
+    // Node labels are drawn around the node centres and the annotation
+    // descriptions anywhere along the node, so they might stick out of the
+    // node bounds that far
+    double labelExtent(const NodeDrawing &item) {
+        QFontMetrics metrics(g_settings->labelFont);
+
+        QSizeF size(0.0, 0.0);
+        QStringList nodeText = item.getNodeText();
+        for (const QString &text : nodeText)
+            size.setWidth(std::max<double>(size.width(), metrics.boundingRect(text).width()));
+        size.setHeight(nodeText.size() * metrics.height());
+
+        for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
+            if (!g_settings->annotationsSettings[annotationGroup->id].showText)
+                continue;
+
+            for (const DeBruijnNode *node : { item.m_deBruijnNode, item.m_deBruijnNode->getReverseComplement() }) {
+                for (const auto &annotation : annotationGroup->getAnnotations(node)) {
+                    QString text = QString::fromStdString(annotation->getText());
+                    size = size.expandedTo(QSizeF(metrics.boundingRect(text).width(), metrics.height()));
+                }
+            }
+        }
+
+        if (size.isEmpty())
+            return 0.0;
+
+        // Same scaling as in NodeDrawing::drawTextPathAtLocation(). The
+        // labels might be rotated with the view, so any direction counts.
+        double zoom = g_absoluteZoom == 0.0 ? 1.0 : g_absoluteZoom;
+        double zoomAdjustment = 1.0 / (1.0 + ((zoom - 1.0) * g_settings->textZoomScaleFactor));
+        return (std::hypot(size.width(), size.height()) + g_settings->textOutlineThickness * 2.0) * zoomAdjustment;
+    }
+
+    // Minimal PNG encoder for 8-bit RGB images fed a band of rows at a time,
+    // so the whole image never has to be in memory
+    class PngWriter {
+    public:
+        PngWriter() : m_out(PNG_CHUNK_SIZE) {}
+
+        ~PngWriter() {
+            if (m_streamInitialized)
+                deflateEnd(&m_stream);
+        }
+
+        PngWriter(const PngWriter &) = delete;
+        PngWriter &operator=(const PngWriter &) = delete;
+
+        bool open(const QString &fileName, QSize size) {
+            m_file.setFileName(fileName);
+            if (!m_file.open(QIODevice::WriteOnly))
+                return false;
+
+            if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+                return false;
+            m_streamInitialized = true;
+            m_stream.next_out = m_out.data();
+            m_stream.avail_out = uInt(m_out.size());
+            m_row.resize(1 + 3 * size_t(size.width()));
+
+            static constexpr char SIGNATURE[] = "\x89PNG\r\n\x1a\n";
+            if (m_file.write(SIGNATURE, 8) != 8)
+                return false;
+
+            uchar header[13];
+            qToBigEndian<quint32>(quint32(size.width()), header);
+            qToBigEndian<quint32>(quint32(size.height()), header + 4);
+            header[8] = 8;  // bits per channel
+            header[9] = 2;  // RGB
+            header[10] = 0; // deflate
+            header[11] = 0; // adaptive filtering
+            header[12] = 0; // no interlacing
+            return writeChunk("IHDR", header, sizeof(header));
+        }
+
+        // Tiles of the band from left to right, all of the same height
+        bool writeBand(const QList<QImage> &tiles) {
+            for (int y = 0; y < tiles.front().height(); ++y) {
+                uchar *out = m_row.data();
+                *out++ = 0; // no filtering
+                for (const QImage &tile : tiles) {
+                    const auto *pixel = reinterpret_cast<const QRgb *>(tile.constScanLine(y));
+                    for (int x = 0; x < tile.width(); ++x, ++pixel) {
+                        *out++ = uchar(qRed(*pixel));
+                        *out++ = uchar(qGreen(*pixel));
+                        *out++ = uchar(qBlue(*pixel));
+                    }
+                }
+
+                if (!compress(m_row.data(), m_row.size(), false))
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool close() {
+            bool ok = compress(nullptr, 0, true) && writeChunk("IEND", nullptr, 0);
+            m_file.close();
+            return ok && m_file.error() == QFileDevice::NoError;
+        }
+
+    private:
+        bool compress(const uchar *data, size_t size, bool finish) {
+            m_stream.next_in = const_cast<Bytef *>(data);
+            m_stream.avail_in = uInt(size);
+
+            while (true) {
+                int ret = deflate(&m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+                if (ret == Z_STREAM_ERROR)
+                    return false;
+
+                if (m_stream.avail_out == 0 || ret == Z_STREAM_END) {
+                    size_t used = m_out.size() - m_stream.avail_out;
+                    if (used && !writeChunk("IDAT", m_out.data(), used))
+                        return false;
+                    m_stream.next_out = m_out.data();
+                    m_stream.avail_out = uInt(m_out.size());
+                }
+
+                if (finish ? ret == Z_STREAM_END : m_stream.avail_in == 0)
+                    return true;
+            }
+        }
+
+        bool writeChunk(const char *type, const uchar *data, size_t size) {
+            uchar length[4], crc[4];
+            qToBigEndian<quint32>(quint32(size), length);
+            uLong checksum = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+            if (size)
+                checksum = crc32(checksum, data, uInt(size));
+            qToBigEndian<quint32>(quint32(checksum), crc);
+
+            return m_file.write(reinterpret_cast<const char *>(length), 4) == 4 &&
+                   m_file.write(type, 4) == 4 &&
+                   (!size || m_file.write(reinterpret_cast<const char *>(data), qint64(size)) == qint64(size)) &&
+                   m_file.write(reinterpret_cast<const char *>(crc), 4) == 4;
+        }
+
+        QFile m_file;
+        z_stream m_stream{};
+        bool m_streamInitialized = false;
+        std::vector<uchar> m_out;
+        std::vector<uchar> m_row;
+    };
+}
+
+GraphRenderer::GraphRenderer(AssemblyGraph &graph, const GraphLayout &layout) {
+    makeDrawings(graph, layout);
+
+    // Bounds are computed here once: the node shapes are cached lazily, so
+    // they should not be computed from the rendering threads
+    QRectF itemsRect;
+    for (const auto &edge : m_edges) {
+        double extent = edge.width / 2.0;
+        m_itemBounds.push_back(edge.path.boundingRect().adjusted(-extent, -extent, extent, extent));
+        itemsRect |= m_itemBounds.back();
+    }
+    for (const auto &node : m_nodes) {
+        // Same as GraphicsItemNode::boundingRect()
+        double extraSize = g_settings->selectionThickness / 2.0;
+        QRectF bounds = node.shapeBounds().adjusted(-extraSize, -extraSize, extraSize, extraSize);
+        itemsRect |= bounds;
+
+        double extent = labelExtent(node);
+        m_itemBounds.push_back(bounds.adjusted(-extent, -extent, extent, extent));
+    }
+
+    // Same as BandageGraphicsScene::setSceneRectangle()
+    double margin = std::max(itemsRect.width(), itemsRect.height()) * 0.05;
+    m_sceneRect = itemsRect.adjusted(-margin, -margin, margin, margin);
+
+    buildIndex();
+}
+
+// Makes the drawings the same way BandageGraphicsScene::addGraphicsItemsToScene()
+// makes the graphics items
+void GraphRenderer::makeDrawings(AssemblyGraph &graph, const GraphLayout &layout) {
+    double meanDrawnDepth = graph.getMeanDepth(true);
+
+    m_nodes.reserve(layout.size());
+    for (auto &entry : layout) {
+        DeBruijnNode *node = entry.first;
+        if (!node->isDrawn())
+            continue;
+
+        m_nodeIndex[node] = m_nodes.size();
+        auto &nodeDrawing =
+                m_nodes.emplace_back(node,
+                                     meanDrawnDepth == 0 ? 1.0 : node->getDepth() / meanDrawnDepth,
+                                     entry.second);
+        // If we are in double mode and this node's complement is also drawn,
+        // then we should shift the points so the two nodes are not drawn directly
+        // on top of each other.
+        if (g_settings->doubleMode && node->getReverseComplement()->isDrawn())
+            nodeDrawing.shiftPointsLeft();
+    }
+
+    // The complement colours are assigned together, when the second node of
+    // the pair is seen
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        NodeDrawing &nodeDrawing = m_nodes[i];
+        auto rc = m_nodeIndex.find(nodeDrawing.m_deBruijnNode->getReverseComplement());
+        if (rc != m_nodeIndex.end() && rc->second < i) {
+            auto colPair = g_settings->nodeColorer->get(&nodeDrawing, &m_nodes[rc->second]);
+            nodeDrawing.setNodeColour(colPair.first);
+            m_nodes[rc->second].setNodeColour(colPair.second);
+        } else
+            nodeDrawing.setNodeColour(g_settings->nodeColorer->get(&nodeDrawing));
+    }
+
+    auto drawingOf = [this](const DeBruijnNode *node) -> const NodeDrawing * {
+        auto it = m_nodeIndex.find(node);
+        return it == m_nodeIndex.end() ? nullptr : &m_nodes[it->second];
+    };
+    for (auto &entry : graph.m_deBruijnGraphEdges) {
+        const DeBruijnEdge * edge = entry.second;
+        if (!edge->isDrawn())
+            continue;
+
+        auto style = graph.getCustomStyle(edge);
+        m_edges.push_back({ GraphicsItemEdge::makePath(edge, drawingOf),
+                            graph.getCustomColour(edge), style.lineStyle, style.width });
+    }
+}
+
+// Painting fills a few caches lazily: the node shapes and outlines, the
+// vector form of the paths kept by QPainterPath, the annotation settings
+// entries. Painting everything once on this thread fills them all, so
+// afterwards the drawings are only read by the rendering threads.
+void GraphRenderer::prepareDrawings() {
+    if (m_prepared)
+        return;
+
+    QImage image(64, 64, QImage::Format_RGB32);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setWorldTransform(sceneTransform(image.size()));
+    for (size_t i = 0; i < m_itemBounds.size(); ++i)
+        paintItem(painter, i);
+
+    m_prepared = true;
+}
+
+void GraphRenderer::buildIndex() {
+    if (m_sceneRect.isEmpty()) {
+        m_columns = m_rows = 1;
+        m_cellSize = QSizeF(1.0, 1.0);
+    } else {
+        double cells = std::clamp(double(m_itemBounds.size()), 1.0, MAX_GRID_CELLS);
+        double aspectRatio = m_sceneRect.width() / m_sceneRect.height();
+        m_columns = std::max(1, int(std::sqrt(cells * aspectRatio)));
+        m_rows = std::max(1, int(cells / m_columns));
+        m_cellSize = QSizeF(m_sceneRect.width() / m_columns, m_sceneRect.height() / m_rows);
+    }
+
+    m_cells.assign(size_t(m_columns) * size_t(m_rows), {});
+    for (size_t i = 0; i < m_itemBounds.size(); ++i) {
+        QRect cells = cellsIntersecting(m_itemBounds[i]);
+        for (int row = cells.top(); row <= cells.bottom(); ++row)
+            for (int column = cells.left(); column <= cells.right(); ++column)
+                m_cells[size_t(row) * size_t(m_columns) + size_t(column)].push_back(unsigned(i));
+    }
+}
+
+QRect GraphRenderer::cellsIntersecting(const QRectF &sceneArea) const {
+    auto cell = [](double offset, double cellSize, int count) {
+        return std::clamp(int(std::floor(offset / cellSize)), 0, count - 1);
+    };
+
+    return QRect(QPoint(cell(sceneArea.left() - m_sceneRect.left(), m_cellSize.width(), m_columns),
+                        cell(sceneArea.top() - m_sceneRect.top(), m_cellSize.height(), m_rows)),
+                 QPoint(cell(sceneArea.right() - m_sceneRect.left(), m_cellSize.width(), m_columns),
+                        cell(sceneArea.bottom() - m_sceneRect.top(), m_cellSize.height(), m_rows)));
+}
+
+// Same placement as QGraphicsScene::render() with Qt::KeepAspectRatio: the
+// scene is scaled uniformly and centred in the image
+QTransform GraphRenderer::sceneTransform(QSize imageSize) const {
+    double scale = 1.0;
+    if (!m_sceneRect.isEmpty())
+        scale = std::min(imageSize.width() / m_sceneRect.width(),
+                         imageSize.height() / m_sceneRect.height());
+
+    QTransform transform;
+    transform.translate((imageSize.width() - m_sceneRect.width() * scale) / 2.0,
+                        (imageSize.height() - m_sceneRect.height() * scale) / 2.0);
+    transform.scale(scale, scale);
+    transform.translate(-m_sceneRect.left(), -m_sceneRect.top());
+    return transform;
+}
+
+void GraphRenderer::paintItem(QPainter &painter, size_t index) const {
+    QTransform transform = painter.worldTransform();
+    if (index < m_edges.size()) {
+        const EdgeDrawing &edge = m_edges[index];
+        GraphicsItemEdge::draw(&painter, edge.path, edge.colour, edge.penStyle, edge.width);
+    } else
+        m_nodes[index - m_edges.size()].draw(&painter, false);
+    painter.setWorldTransform(transform);
+}
+
+void GraphRenderer::paintItems(QPainter &painter, const QRectF &sceneArea) const {
+    // Items spanning several cells are listed more than once, the indices
+    // also give the drawing order
+    std::vector<unsigned> items;
+    QRect cells = cellsIntersecting(sceneArea);
+    for (int row = cells.top(); row <= cells.bottom(); ++row) {
+        for (int column = cells.left(); column <= cells.right(); ++column) {
+            const auto &cell = m_cells[size_t(row) * size_t(m_columns) + size_t(column)];
+            items.insert(items.end(), cell.begin(), cell.end());
+        }
+    }
+    std::sort(items.begin(), items.end());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+
+    for (unsigned i : items) {
+        if (m_itemBounds[i].intersects(sceneArea))
+            paintItem(painter, i);
+    }
+}
+
+void GraphRenderer::render(QPainter &painter, QSize imageSize) const {
+    painter.save();
+    painter.setWorldTransform(sceneTransform(imageSize), true);
+    for (size_t i = 0; i < m_itemBounds.size(); ++i)
+        paintItem(painter, i);
+    painter.restore();
+}
+
+QImage GraphRenderer::renderTile(QSize imageSize, const QRect &tile) const {
+    QImage image(tile.size(), QImage::Format_RGB32);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+
+    QTransform transform = sceneTransform(imageSize) * QTransform::fromTranslate(-tile.left(), -tile.top());
+    painter.setWorldTransform(transform);
+
+    // A pixel more around the tile for the antialiasing of the items just
+    // outside of it
+    QRectF sceneArea = transform.inverted().mapRect(QRectF(image.rect()).adjusted(-1.0, -1.0, 1.0, 1.0));
+    paintItems(painter, sceneArea);
+
+    return image;
+}
+
+bool GraphRenderer::savePNG(const QString &fileName, QSize imageSize,
+                            int tileSize, unsigned threads) {
+    prepareDrawings();
+
+    PngWriter png;
+    if (!png.open(fileName, imageSize))
+        return false;
+
+    auto bandTiles = [&](int top) {
+        std::vector<QRect> tiles;
+        int height = std::min(tileSize, imageSize.height() - top);
+        for (int left = 0; left < imageSize.width(); left += tileSize)
+            tiles.emplace_back(left, top, std::min(tileSize, imageSize.width() - left), height);
+        return tiles;
+    };
+    auto render = [this, imageSize](const QRect &tile) {
+        return renderTile(imageSize, tile);
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(std::max(threads, 1u)));
+
+    // The next band is rendered while the current one is compressed
+    bool success = true;
+    QFuture<QImage> rendering = QtConcurrent::mapped(&pool, bandTiles(0), render);
+    for (int top = 0; top < imageSize.height(); top += tileSize) {
+        rendering.waitForFinished();
+        QList<QImage> band = rendering.results();
+        if (top + tileSize < imageSize.height())
+            rendering = QtConcurrent::mapped(&pool, bandTiles(top + tileSize), render);
+
+        if (!png.writeBand(band)) {
+            success = false;
+            break;
+        }
+    }
+    rendering.waitForFinished();
+
+    return png.close() && success;
+}
+
+bool GraphRenderer::saveDeepZoom(const QString &fileName, QSize imageSize,
+                                 int tileSize, unsigned threads) {
+    prepareDrawings();
+
+    QFileInfo fileInfo(fileName);
+    QDir directory = fileInfo.dir();
+    QString tilesDirectory = fileInfo.completeBaseName() + "_files";
+
+    struct Tile {
+        QString fileName;
+        QSize levelSize;
+        QRect rect;
+    };
+    std::vector<Tile> tiles;
+
+    // The highest level has the full size, the level 0 is a single pixel
+    int maxLevel = int(std::ceil(std::log2(std::max(imageSize.width(), imageSize.height()))));
+    for (int level = 0; level <= maxLevel; ++level) {
+        double scale = std::ldexp(1.0, level - maxLevel);
+        QSize levelSize(std::max(1, int(std::ceil(imageSize.width() * scale))),
+                        std::max(1, int(std::ceil(imageSize.height() * scale))));
+
+        QString levelDirectory = tilesDirectory + "/" + QString::number(level);
+        if (!directory.mkpath(levelDirectory))
+            return false;
+
+        for (int row = 0; row * tileSize < levelSize.height(); ++row) {
+            for (int column = 0; column * tileSize < levelSize.width(); ++column) {
+                QRect rect(column * tileSize, row * tileSize,
+                           std::min(tileSize, levelSize.width() - column * tileSize),
+                           std::min(tileSize, levelSize.height() - row * tileSize));
+                tiles.push_back({ directory.filePath(levelDirectory + "/" +
+                                                     QString("%1_%2.png").arg(column).arg(row)),
+                                  levelSize, rect });
+            }
+        }
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(std::max(threads, 1u)));
+    std::atomic<bool> success = true;
+    QtConcurrent::blockingMap(&pool, tiles, [&](const Tile &tile) {
+        if (!renderTile(tile.levelSize, tile.rect).save(tile.fileName))
+            success = false;
+    });
+    if (!success)
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"0\" TileSize=\""
+        << tileSize << "\">\n"
+        << "  <Size Width=\"" << imageSize.width() << "\" Height=\"" << imageSize.height() << "\"/>\n"
+        << "</Image>\n";
+    out.flush();
+
+    return file.error() == QFileDevice::NoError;
+}
@@ -0,0 +1,111 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graph/nodedrawing.h"
+#include "layout/graphlayout.h"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QColor>
+#include <QImage>
+#include <QPainterPath>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+class QPainter;
+
+// Draws the graph without a graphics scene or any graphics items: the nodes
+// and edges are laid out into plain drawings, painted with the same code as
+// the interactive items. Used for the command line image export, where the
+// scene would only be overhead. The drawings are looked up via a uniform
+// grid, so the images of any size could be rendered in independent tiles on
+// several threads.
+class GraphRenderer {
+public:
+    GraphRenderer(AssemblyGraph &graph, const GraphLayout &layout);
+
+    GraphRenderer(const GraphRenderer &) = delete;
+    GraphRenderer &operator=(const GraphRenderer &) = delete;
+
+    // Bounds of the drawing with a small margin, same as the scene rectangle
+    // of BandageGraphicsScene
+    QRectF sceneRect() const { return m_sceneRect; }
+
+    // Draws the whole graph fitted into the given size, the same way
+    // QGraphicsScene::render() would. Works with any paint device, e.g.
+    // QSvgGenerator.
+    void render(QPainter &painter, QSize imageSize) const;
+
+    // Renders the pixels of the given rectangle of the image of the whole
+    // graph with the given size. The graph is fitted into the image keeping
+    // its aspect ratio.
+    QImage renderTile(QSize imageSize, const QRect &tile) const;
+
+    // Streams the image of the given size into a PNG file, a band of tiles
+    // at a time. Unlike QImage, the size is not limited to 32767 pixels.
+    bool savePNG(const QString &fileName, QSize imageSize,
+                 int tileSize, unsigned threads);
+
+    // Writes a DeepZoom pyramid: the .dzi descriptor and the PNG tiles of
+    // every level into the "<name>_files" directory next to it. The full
+    // size image is the highest level, each level below is half as large
+    // and is rendered at its own scale.
+    bool saveDeepZoom(const QString &fileName, QSize imageSize,
+                      int tileSize, unsigned threads);
+
+private:
+    struct EdgeDrawing {
+        QPainterPath path;
+        QColor colour;
+        Qt::PenStyle penStyle;
+        float width;
+    };
+
+    QTransform sceneTransform(QSize imageSize) const;
+    QRect cellsIntersecting(const QRectF &sceneArea) const;
+    void paintItems(QPainter &painter, const QRectF &sceneArea) const;
+    void paintItem(QPainter &painter, size_t index) const;
+    void makeDrawings(AssemblyGraph &graph, const GraphLayout &layout);
+    void buildIndex();
+    void prepareDrawings();
+
+    // Drawing a node fills its caches, see prepareDrawings()
+    mutable std::vector<NodeDrawing> m_nodes;
+    std::vector<EdgeDrawing> m_edges;
+    phmap::flat_hash_map<const DeBruijnNode *, size_t> m_nodeIndex;
+
+    // Area every item might paint (with the labels). The items are numbered
+    // in the drawing order: the edges first, then the nodes.
+    std::vector<QRectF> m_itemBounds;
+    QRectF m_sceneRect;
+    bool m_prepared = false;
+
+    // Uniform grid over the scene rectangle, every cell lists the items it
+    // intersects in the drawing order
+    int m_columns = 1, m_rows = 1;
+    QSizeF m_cellSize;
+    std::vector<std::vector<unsigned>> m_cells;
+};
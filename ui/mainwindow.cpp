@@ -49,6 +49,7 @@
 
 #include "layout/graphlayoutworker.h"
 #include "layout/io.h"
+#include "layout/layoutcache.h"
 
 #include "program/globals.h"
 #include "program/memory.h"
@@ -76,6 +77,8 @@
 
 #include <iterator>
 #include <algorithm>
+#include <optional>
+#include <memory>
 #include <stdexcept>
 #include <limits>
 #include <cstdlib>
@@ -174,6 +177,7 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->blastQueryComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(blastQueryChanged()));
     connect(ui->actionControls_panel, SIGNAL(toggled(bool)), this, SLOT(showHidePanels()));
     connect(ui->actionSelection_panel, SIGNAL(toggled(bool)), this, SLOT(showHidePanels()));
+    connect(ui->actionFrame_rate, &QAction::toggled, g_graphicsView, &BandageGraphicsView::setShowFrameRate);
     connect(ui->contiguityButton, SIGNAL(clicked()), this, SLOT(determineContiguityFromSelectedNode()));
     connect(ui->actionBring_selected_nodes_to_front, SIGNAL(triggered()), this, SLOT(bringSelectedNodesToFront()));
     connect(ui->actionSelect_nodes_with_BLAST_hits, SIGNAL(triggered()), this, SLOT(selectNodesWithBlastHits()));
@@ -339,6 +343,7 @@ void MainWindow::loadGraph(QString fullFileName) {
                              "Cannot load file. The selected file's format was not recognised as any supported graph type.");
         return;
     }
+    builder->setThreads(g_settings->threads);
 
     resetScene();
     cleanUp();
@@ -420,7 +425,7 @@ void MainWindow::loadGraph(QString fullFileName) {
 void MainWindow::loadGraphLayout(QString fullFileName) {
     if (fullFileName.isEmpty())
         fullFileName = QFileDialog::getOpenFileName(this, "Load Bandage layout", "",
-                                                    "Bandage layout (*.layout)");
+                                                    "Bandage layout (*.layout *.blayout)");
 
     if (fullFileName.isEmpty())
         return; // user clicked on cancel
@@ -951,10 +956,15 @@ void MainWindow::drawGraph() {
         return;
     }
 
+    // The current drawing has to be taken before the scene is gone
+    std::optional<GraphLayout> previousLayout;
+    if (g_settings->incrementalLayout && m_uiState == GRAPH_DRAWN)
+        previousLayout.emplace(layout::fromGraph(*g_assemblyGraph));
+
     resetScene();
     g_assemblyGraph->resetNodes();
     g_assemblyGraph->markNodesToDraw(scope, startingNodes);
-    layoutGraph();
+    layoutGraph(previousLayout ? &*previousLayout : nullptr);
 }
 
 
@@ -1003,8 +1013,23 @@ std::vector<DeBruijnNode *> MainWindow::getNodesFromLineEdit(QLineEdit * lineEdi
 
 
 
-void MainWindow::layoutGraph()
+void MainWindow::layoutGraph(const GraphLayout *initialLayout)
 {
+    double aspectRatio = double(g_graphicsView->width()) / g_graphicsView->height();
+
+    // Incremental layout depends on the previous drawing, so it is never cached
+    QByteArray cacheKey;
+    if (!initialLayout && g_settings->layoutCacheSize != 0) {
+        cacheKey = layout::cache::key(*g_assemblyGraph,
+                                      g_settings->graphLayoutQuality,
+                                      g_settings->linearLayout,
+                                      g_settings->componentSeparation, aspectRatio);
+        if (auto cached = layout::cache::load(*g_assemblyGraph, cacheKey)) {
+            graphLayoutFinished(*cached);
+            return;
+        }
+    }
+
     //The actual layout is done in a different thread so the UI will stay responsive.
     auto *progress = new MyProgressDialog(this, "Laying out graph...", true, "Cancel layout", "Cancelling layout...",
                                           "Clicking this button will halt the graph layout and display "
@@ -1020,17 +1045,27 @@ void MainWindow::layoutGraph()
     progress->setWindowModality(Qt::WindowModal);
     progress->show();
 
-    double aspectRatio = double(g_graphicsView->width()) / g_graphicsView->height();
     auto *graphLayoutWorker = new GraphLayoutWorker(g_settings->graphLayoutQuality,
                                                     g_settings->linearLayout,
                                                     g_settings->componentSeparation, aspectRatio);
+    if (initialLayout)
+        graphLayoutWorker->setInitialLayout(*initialLayout);
 
     connect(progress, SIGNAL(halt()), graphLayoutWorker, SLOT(cancelLayout()));
 
+    // Incomplete layouts of a cancelled run are not cached
+    auto cancelled = std::make_shared<bool>(false);
+    connect(progress, &MyProgressDialog::halt, this, [cancelled]() { *cancelled = true; });
+
     auto *watcher = new QFutureWatcher<GraphLayout>;
 
     connect(watcher, &QFutureWatcher<GraphLayout>::finished,
-            this, [=]() { this->graphLayoutFinished(watcher->future().result()); });
+            this, [=]() {
+                const GraphLayout &layout = watcher->future().result();
+                if (!cacheKey.isEmpty() && !*cancelled)
+                    layout::cache::store(cacheKey, layout);
+                this->graphLayoutFinished(layout);
+            });
     connect(watcher, SIGNAL(finished()), graphLayoutWorker, SLOT(deleteLater()));
     connect(watcher, SIGNAL(finished()), progress, SLOT(deleteLater()));
     connect(watcher, SIGNAL(finished()), watcher, SLOT(deleteLater()));
@@ -2646,7 +2681,8 @@ void MainWindow::exportGraphLayout() {
     QString filter = "Bandage layout (*.layout)";
     QString fullFileName = QFileDialog::getSaveFileName(this, "Export graph layout",
                                                         "",
-                                                        "Bandage layout (*.layout);;TSV (*.tsv)",
+                                                        "Bandage layout (*.layout);;"
+                                                        "Bandage binary layout (*.blayout);;TSV (*.tsv)",
                                                         &filter);
 
     if (fullFileName.isEmpty())
@@ -2657,6 +2693,8 @@ void MainWindow::exportGraphLayout() {
                                            /* simplified */ isTSV);
     if (isTSV)
         layout::io::saveTSV(fullFileName, layout);
+    else if (filter == "Bandage binary layout (*.blayout)")
+        layout::io::saveBinary(fullFileName, layout);
     else
         layout::io::save(fullFileName, layout);
 }
@@ -79,7 +79,7 @@ private:
     void clearGraphDetails();
     void resetScene();
     void resetAllNodeColours();
-    void layoutGraph();
+    void layoutGraph(const GraphLayout *initialLayout = nullptr);
     void zoomToFitRect(QRectF rect);
     void setZoomSpinBoxStep();
     void getSelectedNodeInfo(int & selectedNodeCount, QString & selectedNodeCountText,